@@ -0,0 +1,1391 @@
+/* dec64_bench.c
+
+This is a benchmark of dec64, dec64_inline, dec64_array, dec64_accum,
+dec64_divisor, dec64_parallel, dec64_math and dec64_string.
+
+Every public function is timed against the same five input distributions:
+
+    integer     integer prices, exponent 0
+    money       two decimal money values, exponent -2
+    mixed       coefficients of 1 to 16 digits with exponents from -20 to 20
+    maxnum      coefficients and exponents close to the largest number
+    nan         half nan, some non-normal nans, the rest money
+
+The series in dec64_math converge very slowly far from their useful domain,
+so the elementary functions are timed against a sixth distribution instead:
+
+    unit        numbers strictly between -1 and 1 with 2 to 16 digits, so that
+                dec64_acos and dec64_asin stay inside their domain
+
+For each function and distribution it reports nanoseconds per operation,
+operations per second, and time stamp counter cycles per operation.
+
+When the library was built with NASM, the routines in dec64n.asm are also
+linked in with a nasm_ prefix, and each function of dec64.h is reported twice:
+once as linked into the library ("lib", which is the C port in dec64.c for
+the functions it provides) and once straight from the assembly ("nasm").
+
+The batched functions of dec64_array are reported once for each kernel set
+that the processor supports ("c", "avx2" and "avx512").
+
+The reductions of dec64_parallel are timed on a large column made of copies
+of each distribution, with 1, 2, 4 and so on threads ("t1", "t2", ...) up to
+the number of processors, to show how they scale. Their ns/op is per number.
+
+When the library was built with DEC64_BACKEND=DISPATCH, the dispatched
+functions are also reported once for each variant that runs on this processor
+("c", "nasm" and "bmi2"), after the "lib" rows that use the chosen variant.
+
+Usage:
+
+    dec64_bench [filter]
+
+Only functions whose name contains filter are run.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "dec64.h"
+#include "dec64_math.h"
+#include "dec64_string.h"
+#include "dec64_inline.h"
+#include "dec64_array.h"
+#include "dec64_accum.h"
+#include "dec64_divisor.h"
+#include "dec64_parallel.h"
+#define DEC64_HARNESS_SPLITMIX
+#include "dec64_harness.h"
+#ifdef DEC64_BENCH_DISPATCH
+#include "dec64_dispatch.h"
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define bench_cycles() __rdtsc()
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define bench_cycles() __rdtsc()
+#else
+#define bench_cycles() 0ULL
+#endif
+
+#define NR_VALUES 1024
+#define NR_PARALLEL_VALUES (1 << 22)
+#define NR_DISTRIBUTIONS 6
+#define TARGET_NS 20000000.0
+
+#define MAXNUM 36028797018963967LL
+
+typedef dec64 (*unary_function)(dec64);
+typedef dec64 (*binary_function)(dec64, dec64);
+typedef void (*unary_array_function)(dec64*, const dec64*, size_t);
+typedef void (*array_function)(dec64*, const dec64*, const dec64*, size_t);
+typedef void (*scalar_function)(dec64*, const dec64*, dec64, size_t);
+typedef dec64 (*reduction_function)(const dec64*, size_t, int);
+
+static const char* distribution_names[NR_DISTRIBUTIONS] = {
+    "integer",
+    "money",
+    "mixed",
+    "maxnum",
+    "nan",
+    "unit"
+};
+
+/* The distributions used by the dec64 and dec64_string functions */
+
+#define ARITHMETIC 0x1F
+
+/* The distributions used by the dec64_math functions */
+
+#define ELEMENTARY 0x20
+
+static dec64 first[NR_DISTRIBUTIONS][NR_VALUES];
+static dec64 second[NR_DISTRIBUTIONS][NR_VALUES];
+static int64 coefficients[NR_DISTRIBUTIONS][NR_VALUES];
+static int64 exponents[NR_DISTRIBUTIONS][NR_VALUES];
+static dec64 places[NR_VALUES];
+static dec64 results[NR_VALUES];
+static dec64_string_char strings[NR_DISTRIBUTIONS][NR_VALUES][32];
+
+static dec64_string_state state;
+static dec64_string_cache cache;
+static const char* filter;
+static volatile dec64 sink;
+static dec64* parallel_totals;
+
+/* measurement */
+
+static double now_ns() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static int wanted(const char* name) {
+    return filter == NULL || strstr(name, filter) != NULL;
+}
+
+static void report(
+    const char* name,
+    const char* variant,
+    const char* distribution,
+    double ns,
+    uint64 cycles,
+    double ops
+) {
+    printf(
+        "%-24s %-6s %-8s %10.2f %14.0f %10.1f\n",
+        name,
+        variant,
+        distribution,
+        ns / ops,
+        ops * 1e9 / ns,
+        (double)cycles / ops
+    );
+    fflush(stdout);
+}
+
+/* distributions */
+
+static dec64 generate_one(
+    int distribution,
+    int64* raw_coefficient,
+    int64* raw_exponent
+) {
+/*
+    Make a number for the distribution. The raw coefficient and exponent are
+    the arguments that dec64_new will be benchmarked with.
+*/
+    int64 coefficient;
+    int64 exponent;
+    uint64 roll;
+
+    switch (distribution) {
+    case 0:
+        coefficient = random_range(1, 100000);
+        if (next_random() % 8 == 0) {
+            coefficient = -coefficient;
+        }
+        exponent = 0;
+        break;
+    case 1:
+        coefficient = random_range(-10000000, 10000000);
+        exponent = -2;
+        break;
+    case 2:
+        coefficient = random_range(1, 9) * (int64)(
+            next_random() % 1000000000000000ULL
+            / (uint64)(1LL << (next_random() % 50))
+            + 1
+        );
+        if (next_random() % 2 == 0) {
+            coefficient = -coefficient;
+        }
+        exponent = random_range(-20, 20);
+        break;
+    case 3:
+        coefficient = MAXNUM - random_range(0, 1 << 20);
+        if (next_random() % 2 == 0) {
+            coefficient = -coefficient;
+        }
+        exponent = random_range(120, 127);
+        *raw_coefficient = coefficient * random_range(1, 200);
+        *raw_exponent = exponent - 2;
+        return dec64_new(coefficient, exponent);
+    case 5:
+        exponent = random_range(2, 16);
+        coefficient = random_range(
+            -power_of_ten(exponent) + 1,
+            power_of_ten(exponent) - 1
+        );
+        exponent = -exponent;
+        break;
+    default:
+        roll = next_random() % 10;
+        coefficient = random_range(-10000000, 10000000);
+        exponent = -2;
+        if (roll < 5) {
+            *raw_coefficient = 0;
+            *raw_exponent = -128;
+            return DEC64_NAN;
+        }
+        if (roll == 5) {
+            *raw_coefficient = 0;
+            *raw_exponent = -128;
+            return (coefficient << 8) | 0x80;
+        }
+        break;
+    }
+    *raw_coefficient = coefficient;
+    *raw_exponent = exponent;
+    return dec64_new(coefficient, exponent);
+}
+
+static void generate() {
+    int at;
+    int distribution;
+    int64 ignored;
+
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        for (at = 0; at < NR_VALUES; at += 1) {
+            first[distribution][at] = generate_one(
+                distribution,
+                &coefficients[distribution][at],
+                &exponents[distribution][at]
+            );
+            second[distribution][at] = generate_one(
+                distribution,
+                &ignored,
+                &ignored
+            );
+            dec64_to_string(
+                state,
+                first[distribution][at],
+                strings[distribution][at]
+            );
+        }
+    }
+    for (at = 0; at < NR_VALUES; at += 1) {
+        places[at] = dec64_new(random_range(-4, 2), 0);
+    }
+}
+
+/* runners */
+
+static void run_unary(
+    const char* name,
+    const char* variant,
+    unary_function function,
+    int distributions
+) {
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 accumulator;
+    const dec64* numbers;
+
+    if (function == NULL || !wanted(name)) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((distributions >> distribution) & 1) == 0) {
+            continue;
+        }
+        numbers = first[distribution];
+        accumulator = 0;
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            for (at = 0; at < NR_VALUES; at += 1) {
+                accumulator ^= function(numbers[at]);
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = accumulator;
+        report(name, variant, distribution_names[distribution], elapsed, cycles, ops);
+    }
+}
+
+static void run_binary(
+    const char* name,
+    const char* variant,
+    binary_function function,
+    int distributions
+) {
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 accumulator;
+    const dec64* lefts;
+    const dec64* rights;
+
+    if (function == NULL || !wanted(name)) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((distributions >> distribution) & 1) == 0) {
+            continue;
+        }
+        lefts = first[distribution];
+        rights = second[distribution];
+        accumulator = 0;
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            for (at = 0; at < NR_VALUES; at += 1) {
+                accumulator ^= function(lefts[at], rights[at]);
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = accumulator;
+        report(name, variant, distribution_names[distribution], elapsed, cycles, ops);
+    }
+}
+
+static void run_new(const char* variant, binary_function function) {
+/*
+    dec64_new takes a raw coefficient and exponent rather than two numbers.
+    In the maxnum distribution the coefficients are too large to fit, so
+    packing has to scale them down.
+*/
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 accumulator;
+
+    if (function == NULL || !wanted("dec64_new")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        accumulator = 0;
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            for (at = 0; at < NR_VALUES; at += 1) {
+                accumulator ^= function(
+                    coefficients[distribution][at],
+                    exponents[distribution][at]
+                );
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = accumulator;
+        report("dec64_new", variant, distribution_names[distribution], elapsed, cycles, ops);
+    }
+}
+
+static void run_new_drop(const char* variant, binary_function function) {
+/*
+    The cost of dec64_new when packing has to drop digits. The coefficients
+    have 16 digits and the exponents are below -127, so that exactly drop
+    digits are lost. A closed form pack costs the same for every drop.
+*/
+    static const int drops[] = {0, 1, 2, 4, 8, 12, 16, 19, 24};
+    char name[16];
+    int64 numbers[NR_VALUES];
+    int at;
+    size_t drop;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 accumulator;
+
+    if (function == NULL || !wanted("dec64_new")) {
+        return;
+    }
+    for (at = 0; at < NR_VALUES; at += 1) {
+        numbers[at] = random_range(1000000000000000, 9999999999999999);
+        if (next_random() % 2 == 0) {
+            numbers[at] = -numbers[at];
+        }
+    }
+    for (drop = 0; drop < sizeof drops / sizeof drops[0]; drop += 1) {
+        snprintf(name, sizeof name, "drop %d", drops[drop]);
+        accumulator = 0;
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            for (at = 0; at < NR_VALUES; at += 1) {
+                accumulator ^= function(numbers[at], -127 - drops[drop]);
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = accumulator;
+        report("dec64_new", variant, name, elapsed, cycles, ops);
+    }
+}
+
+static void run_round(const char* variant, binary_function function) {
+/*
+    dec64_round takes a place, which is a small integer.
+*/
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 accumulator;
+
+    if (function == NULL || !wanted("dec64_round")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        accumulator = 0;
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            for (at = 0; at < NR_VALUES; at += 1) {
+                accumulator ^= function(first[distribution][at], places[at]);
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = accumulator;
+        report("dec64_round", variant, distribution_names[distribution], elapsed, cycles, ops);
+    }
+}
+
+static void run_inline(const char* name, int subtraction) {
+/*
+    dec64_inline_add and dec64_inline_subtract are called directly in the
+    loop, not through a pointer, so that they can be inlined as they would
+    be in an aggregation loop.
+*/
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 accumulator;
+    const dec64* lefts;
+    const dec64* rights;
+
+    if (!wanted(name)) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        lefts = first[distribution];
+        rights = second[distribution];
+        accumulator = 0;
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            if (subtraction) {
+                for (at = 0; at < NR_VALUES; at += 1) {
+                    accumulator ^= dec64_inline_subtract(lefts[at], rights[at]);
+                }
+            } else {
+                for (at = 0; at < NR_VALUES; at += 1) {
+                    accumulator ^= dec64_inline_add(lefts[at], rights[at]);
+                }
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = accumulator;
+        report(name, "lib", distribution_names[distribution], elapsed, cycles, ops);
+    }
+}
+
+static void run_fma(int fused) {
+/*
+    dec64_fma against dec64_multiply followed by dec64_add, which rounds twice.
+    The addends are the second operands taken from the other end.
+*/
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 accumulator;
+    const dec64* lefts;
+    const dec64* rights;
+
+    if (!wanted("dec64_fma")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        lefts = first[distribution];
+        rights = second[distribution];
+        accumulator = 0;
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            if (fused) {
+                for (at = 0; at < NR_VALUES; at += 1) {
+                    accumulator ^= dec64_fma(
+                        lefts[at],
+                        rights[at],
+                        rights[NR_VALUES - 1 - at]
+                    );
+                }
+            } else {
+                for (at = 0; at < NR_VALUES; at += 1) {
+                    accumulator ^= dec64_add(
+                        dec64_multiply(lefts[at], rights[at]),
+                        rights[NR_VALUES - 1 - at]
+                    );
+                }
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = accumulator;
+        report(
+            "dec64_fma",
+            fused ? "lib" : "muladd",
+            distribution_names[distribution],
+            elapsed,
+            cycles,
+            ops
+        );
+    }
+}
+
+static void run_sum(int exact) {
+/*
+    Summing a column with dec64_accum_add_n and dec64_accum_finish, against a
+    chain of dec64_add, which rounds at every step.
+*/
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 sum;
+    dec64_accum accum;
+
+    if (!wanted("dec64_accum")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            if (exact) {
+                dec64_accum_init(&accum);
+                dec64_accum_add_n(&accum, first[distribution], NR_VALUES);
+                sum = dec64_accum_finish(&accum);
+            } else {
+                sum = DEC64_ZERO;
+                for (at = 0; at < NR_VALUES; at += 1) {
+                    sum = dec64_add(sum, first[distribution][at]);
+                }
+            }
+            sink = sum;
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        report(
+            "dec64_accum_add_n",
+            exact ? "lib" : "chain",
+            distribution_names[distribution],
+            elapsed,
+            cycles,
+            ops
+        );
+    }
+}
+
+static void run_dot(int exact) {
+/*
+    dec64_dot against a chain of dec64_multiply and dec64_add, which packs and
+    rounds twice for every element.
+*/
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 sum;
+
+    if (!wanted("dec64_dot")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            if (exact) {
+                sum = dec64_dot(first[distribution], second[distribution], NR_VALUES);
+            } else {
+                sum = DEC64_ZERO;
+                for (at = 0; at < NR_VALUES; at += 1) {
+                    sum = dec64_add(
+                        sum,
+                        dec64_multiply(first[distribution][at], second[distribution][at])
+                    );
+                }
+            }
+            sink = sum;
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        report(
+            "dec64_dot",
+            exact ? "lib" : "chain",
+            distribution_names[distribution],
+            elapsed,
+            cycles,
+            ops
+        );
+    }
+}
+
+static void run_scan(int library) {
+/*
+    A running balance with dec64_scan_inclusive, against a chain of dec64_add
+    that stores every total.
+*/
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 total;
+
+    if (!wanted("dec64_scan_inclusive")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            if (library) {
+                total = dec64_scan_inclusive(results, first[distribution], NR_VALUES, DEC64_ZERO);
+            } else {
+                total = DEC64_ZERO;
+                for (at = 0; at < NR_VALUES; at += 1) {
+                    total = dec64_add(total, first[distribution][at]);
+                    results[at] = total;
+                }
+            }
+            sink = total;
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        report(
+            "dec64_scan_inclusive",
+            library ? "lib" : "chain",
+            distribution_names[distribution],
+            elapsed,
+            cycles,
+            ops
+        );
+    }
+}
+
+static void run_divide_by(int prepared) {
+/*
+    Dividing a column by one number with a dec64_divisor, made once for each
+    pass over the column, against dec64_divide_n_scalar. The divisor is the
+    first number of the second column.
+*/
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64_divisor divisor;
+
+    if (!wanted("dec64_divide_by_n")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            if (prepared) {
+                divisor = dec64_divisor_make(second[distribution][0]);
+                dec64_divide_by_n(results, first[distribution], &divisor, NR_VALUES);
+            } else {
+                dec64_divide_n_scalar(
+                    results,
+                    first[distribution],
+                    second[distribution][0],
+                    NR_VALUES
+                );
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = results[NR_VALUES - 1];
+        report(
+            "dec64_divide_by_n",
+            prepared ? "lib" : "divide",
+            distribution_names[distribution],
+            elapsed,
+            cycles,
+            ops
+        );
+    }
+}
+
+static dec64 bench_parallel_dot(const dec64* numbers, size_t n, int nthreads) {
+    return dec64_parallel_dot(numbers, numbers, n, nthreads);
+}
+
+static dec64 bench_parallel_scan(const dec64* numbers, size_t n, int nthreads) {
+    return dec64_parallel_scan_inclusive(parallel_totals, numbers, n, DEC64_ZERO, nthreads);
+}
+
+static int nr_processors() {
+#ifdef _SC_NPROCESSORS_ONLN
+    long nr = sysconf(_SC_NPROCESSORS_ONLN);
+    return nr > 0 ? (int)nr : 1;
+#else
+    return 8;
+#endif
+}
+
+static void run_parallel(const char* name, reduction_function reduction) {
+    int at;
+    int distribution;
+    int nthreads;
+    int max_threads = nr_processors();
+    char impl[16];
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64* column;
+
+    if (!wanted(name)) {
+        return;
+    }
+    column = (dec64*)malloc(sizeof(dec64) * NR_PARALLEL_VALUES);
+    parallel_totals = (dec64*)malloc(sizeof(dec64) * NR_PARALLEL_VALUES);
+    if (column == NULL || parallel_totals == NULL) {
+        free(column);
+        free(parallel_totals);
+        return;
+    }
+    memset(parallel_totals, 0, sizeof(dec64) * NR_PARALLEL_VALUES);
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        for (at = 0; at < NR_PARALLEL_VALUES; at += 1) {
+            column[at] = first[distribution][at % NR_VALUES];
+        }
+        for (nthreads = 1; ; nthreads *= 2) {
+            if (nthreads > max_threads) {
+                nthreads = max_threads;
+            }
+            snprintf(impl, sizeof impl, "t%i", nthreads);
+            ops = 0;
+            cycles = bench_cycles();
+            start = now_ns();
+            do {
+                sink = reduction(column, NR_PARALLEL_VALUES, nthreads);
+                ops += NR_PARALLEL_VALUES;
+                elapsed = now_ns() - start;
+            } while (elapsed < TARGET_NS);
+            cycles = bench_cycles() - cycles;
+            report(name, impl, distribution_names[distribution], elapsed, cycles, ops);
+            if (nthreads == max_threads) {
+                break;
+            }
+        }
+    }
+    free(column);
+    free(parallel_totals);
+}
+
+static void run_array(
+    const char* name,
+    unary_array_function unary,
+    array_function array,
+    scalar_function scalar
+) {
+/*
+    The batched functions of dec64_array are timed per element, over the
+    whole column of each distribution, with each kernel set in turn. The
+    _scalar variant takes the first number of the second column as its scalar.
+*/
+    static const char* kernel_names[] = {"c", "avx2", "avx512"};
+    int distribution;
+    int kernel;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+
+    if (!wanted(name)) {
+        return;
+    }
+    for (kernel = DEC64_ARRAY_GENERIC; kernel <= DEC64_ARRAY_AVX512; kernel += 1) {
+        if (dec64_array_use_kernel(kernel) != kernel) {
+            continue;
+        }
+        for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+            if (((ARITHMETIC >> distribution) & 1) == 0) {
+                continue;
+            }
+            ops = 0;
+            cycles = bench_cycles();
+            start = now_ns();
+            do {
+                if (unary != NULL) {
+                    unary(results, first[distribution], NR_VALUES);
+                } else if (array != NULL) {
+                    array(results, first[distribution], second[distribution], NR_VALUES);
+                } else {
+                    scalar(results, first[distribution], second[distribution][0], NR_VALUES);
+                }
+                ops += NR_VALUES;
+                elapsed = now_ns() - start;
+            } while (elapsed < TARGET_NS);
+            cycles = bench_cycles() - cycles;
+            sink = results[NR_VALUES - 1];
+            report(
+                name,
+                kernel_names[kernel],
+                distribution_names[distribution],
+                elapsed,
+                cycles,
+                ops
+            );
+        }
+    }
+    dec64_array_use_kernel(DEC64_ARRAY_AVX512);
+}
+
+/* adapters for the functions that do not fit the unary and binary shapes */
+
+static dec64 bench_random(dec64 ignored) {
+    (void)ignored;
+    return dec64_random();
+}
+
+static dec64 bench_seed(dec64 number) {
+    dec64_seed((uint64)number, (uint64)~number);
+    return 0;
+}
+
+static dec64 bench_to_string(dec64 number) {
+    dec64_string_char string[32];
+    return dec64_to_string(state, number, string);
+}
+
+static dec64 bench_to_string_cached(dec64 number) {
+    dec64_string_char string[32];
+    return dec64_to_string_cached(state, cache, number, string);
+}
+
+static dec64 bench_begin_end(dec64 number) {
+    dec64_string_state temp = dec64_string_begin();
+    dec64_string_end(temp);
+    return number;
+}
+
+static dec64 bench_configure(dec64 number) {
+    dec64_string_decimal_point(state, '.');
+    dec64_string_separator(state, ',');
+    dec64_string_separation(state, 3);
+    dec64_string_places(state, 2);
+    dec64_string_engineering(state);
+    dec64_string_scientific(state);
+    dec64_string_standard(state);
+    return number;
+}
+
+static void run_from_string() {
+/*
+    dec64_from_string parses the numbers of each distribution, as formatted
+    by dec64_to_string in standard mode.
+*/
+    int at;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    dec64 accumulator;
+
+    if (!wanted("dec64_from_string")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        accumulator = 0;
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            for (at = 0; at < NR_VALUES; at += 1) {
+                accumulator ^= dec64_from_string(
+                    state,
+                    strings[distribution][at]
+                );
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = accumulator;
+        report("dec64_from_string", "lib", distribution_names[distribution], elapsed, cycles, ops);
+    }
+}
+
+static void run_format_column(int column) {
+/*
+    Writing a column as CSV into a buffer of 4096 characters, emptied when it
+    fills, with dec64_format_column, against dec64_to_string into a temporary
+    string for every number, with the separator added by the caller.
+*/
+    dec64_string_char buffer[4096];
+    dec64_string_char string[32];
+    int at;
+    int count;
+    int distribution;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    size_t length;
+    size_t total;
+    size_t cursor;
+
+    if (!wanted("dec64_format_column")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        ops = 0;
+        total = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            if (column) {
+                cursor = 0;
+                do {
+                    total += dec64_format_column(
+                        state,
+                        first[distribution],
+                        NR_VALUES,
+                        ',',
+                        buffer,
+                        sizeof buffer,
+                        &cursor
+                    );
+                } while (cursor < NR_VALUES);
+            } else {
+                length = 0;
+                for (at = 0; at < NR_VALUES; at += 1) {
+                    if (length + 33 > sizeof buffer) {
+                        total += length;
+                        length = 0;
+                    }
+                    if (at > 0) {
+                        buffer[length] = ',';
+                        length += 1;
+                    }
+                    count = dec64_to_string(state, first[distribution][at], string);
+                    memcpy(buffer + length, string, count);
+                    length += count;
+                }
+                total += length;
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = (dec64)total + buffer[0];
+        report(
+            "dec64_format_column",
+            column ? "lib" : "to_string",
+            distribution_names[distribution],
+            elapsed,
+            cycles,
+            ops
+        );
+    }
+}
+
+static void run_parse_column(int column) {
+/*
+    Reading the numbers of each distribution back from one CSV buffer with
+    dec64_parse_column, against finding each comma, copying the field into a
+    \0 terminated string and calling dec64_from_string.
+*/
+    static dec64_string_char buffer[NR_VALUES * 33];
+    dec64_string_char string[33];
+    const dec64_string_char* at;
+    const dec64_string_char* end;
+    int distribution;
+    int field;
+    double ops;
+    double start;
+    double elapsed;
+    uint64 cycles;
+    size_t length;
+
+    if (!wanted("dec64_parse_column")) {
+        return;
+    }
+    for (distribution = 0; distribution < NR_DISTRIBUTIONS; distribution += 1) {
+        if (((ARITHMETIC >> distribution) & 1) == 0) {
+            continue;
+        }
+        length = 0;
+        for (field = 0; field < NR_VALUES; field += 1) {
+            if (field > 0) {
+                buffer[length] = ',';
+                length += 1;
+            }
+            memcpy(buffer + length, strings[distribution][field], strlen(strings[distribution][field]));
+            length += strlen(strings[distribution][field]);
+        }
+        ops = 0;
+        cycles = bench_cycles();
+        start = now_ns();
+        do {
+            if (column) {
+                dec64_parse_column(state, buffer, length, 1, ',', results, NR_VALUES, NULL, NULL, NULL);
+            } else {
+                at = buffer;
+                for (field = 0; field < NR_VALUES; field += 1) {
+                    end = (const dec64_string_char*)memchr(at, ',', buffer + length - at);
+                    if (end == NULL) {
+                        end = buffer + length;
+                    }
+                    memcpy(string, at, end - at);
+                    string[end - at] = 0;
+                    results[field] = dec64_from_string(state, string);
+                    at = end + 1;
+                }
+            }
+            ops += NR_VALUES;
+            elapsed = now_ns() - start;
+        } while (elapsed < TARGET_NS);
+        cycles = bench_cycles() - cycles;
+        sink = results[NR_VALUES - 1];
+        report(
+            "dec64_parse_column",
+            column ? "lib" : "from_string",
+            distribution_names[distribution],
+            elapsed,
+            cycles,
+            ops
+        );
+    }
+}
+
+static void run_string() {
+    run_from_string();
+    run_parse_column(1);
+    run_parse_column(0);
+    dec64_string_separator(state, 0);
+    dec64_string_places(state, 0);
+    dec64_string_standard(state);
+    run_unary("dec64_to_string/std", "lib", bench_to_string, ARITHMETIC);
+    run_unary("dec64_to_string/std", "cached", bench_to_string_cached, ARITHMETIC);
+    dec64_string_separator(state, ',');
+    dec64_string_places(state, 2);
+    run_unary("dec64_to_string/money", "lib", bench_to_string, ARITHMETIC);
+    run_unary("dec64_to_string/money", "cached", bench_to_string_cached, ARITHMETIC);
+    dec64_string_separator(state, 0);
+    dec64_string_places(state, 0);
+    dec64_string_scientific(state);
+    run_unary("dec64_to_string/sci", "lib", bench_to_string, ARITHMETIC);
+    dec64_string_engineering(state);
+    run_unary("dec64_to_string/eng", "lib", bench_to_string, ARITHMETIC);
+    dec64_string_standard(state);
+    run_format_column(1);
+    run_format_column(0);
+    run_unary("dec64_string_begin_end", "lib", bench_begin_end, ARITHMETIC);
+    run_unary("dec64_string_configure", "lib", bench_configure, ARITHMETIC);
+    dec64_string_separator(state, 0);
+    dec64_string_places(state, 0);
+    dec64_string_standard(state);
+}
+
+/* the C port against the NASM routines */
+
+#ifdef DEC64_BENCH_NASM
+#define NASM(name) nasm_##name
+
+extern int64 nasm_dec64_coefficient(dec64 number);
+extern int64 nasm_dec64_exponent(dec64 number);
+extern dec64 nasm_dec64_is_equal(dec64 comparahend, dec64 comparator);
+extern dec64 nasm_dec64_is_false(dec64 boolean);
+extern dec64 nasm_dec64_is_integer(dec64 number);
+extern dec64 nasm_dec64_is_less(dec64 comparahend, dec64 comparator);
+extern dec64 nasm_dec64_is_nan(dec64 number);
+extern dec64 nasm_dec64_is_zero(dec64 number);
+extern dec64 nasm_dec64_abs(dec64 number);
+extern dec64 nasm_dec64_add(dec64 augend, dec64 addend);
+extern dec64 nasm_dec64_ceiling(dec64 number);
+extern dec64 nasm_dec64_dec(dec64 minuend);
+extern dec64 nasm_dec64_divide(dec64 dividend, dec64 divisor);
+extern dec64 nasm_dec64_floor(dec64 dividend);
+extern dec64 nasm_dec64_half(dec64 dividend);
+extern dec64 nasm_dec64_inc(dec64 augend);
+extern dec64 nasm_dec64_int(dec64 number);
+extern dec64 nasm_dec64_integer_divide(dec64 dividend, dec64 divisor);
+extern dec64 nasm_dec64_modulo(dec64 dividend, dec64 divisor);
+extern dec64 nasm_dec64_multiply(dec64 multiplicand, dec64 multiplier);
+extern dec64 nasm_dec64_neg(dec64 number);
+extern dec64 nasm_dec64_new(int64 coefficient, int64 exponent);
+extern dec64 nasm_dec64_normal(dec64 number);
+extern dec64 nasm_dec64_not(dec64 boolean);
+extern dec64 nasm_dec64_round(dec64 number, dec64 place);
+extern dec64 nasm_dec64_signum(dec64 number);
+extern dec64 nasm_dec64_subtract(dec64 minuend, dec64 subtrahend);
+#else
+#define NASM(name) NULL
+#endif
+
+struct unary_case {
+    const char* name;
+    unary_function c;
+    unary_function nasm;
+    int distributions;
+};
+
+struct binary_case {
+    const char* name;
+    binary_function c;
+    binary_function nasm;
+    int distributions;
+};
+
+static const struct unary_case unary_cases[] = {
+    {"dec64_coefficient", dec64_coefficient, NASM(dec64_coefficient), ARITHMETIC},
+    {"dec64_exponent", dec64_exponent, NASM(dec64_exponent), ARITHMETIC},
+    {"dec64_digits", dec64_digits, NULL, ARITHMETIC},
+    {"dec64_is_false", dec64_is_false, NASM(dec64_is_false), ARITHMETIC},
+    {"dec64_is_integer", dec64_is_integer, NASM(dec64_is_integer), ARITHMETIC},
+    {"dec64_is_nan", dec64_is_nan, NASM(dec64_is_nan), ARITHMETIC},
+    {"dec64_is_zero", dec64_is_zero, NASM(dec64_is_zero), ARITHMETIC},
+    {"dec64_abs", dec64_abs, NASM(dec64_abs), ARITHMETIC},
+    {"dec64_ceiling", dec64_ceiling, NASM(dec64_ceiling), ARITHMETIC},
+    {"dec64_dec", dec64_dec, NASM(dec64_dec), ARITHMETIC},
+    {"dec64_floor", dec64_floor, NASM(dec64_floor), ARITHMETIC},
+    {"dec64_half", dec64_half, NASM(dec64_half), ARITHMETIC},
+    {"dec64_inc", dec64_inc, NASM(dec64_inc), ARITHMETIC},
+    {"dec64_int", dec64_int, NASM(dec64_int), ARITHMETIC},
+    {"dec64_neg", dec64_neg, NASM(dec64_neg), ARITHMETIC},
+    {"dec64_normal", dec64_normal, NASM(dec64_normal), ARITHMETIC},
+    {"dec64_not", dec64_not, NASM(dec64_not), ARITHMETIC},
+    {"dec64_signum", dec64_signum, NASM(dec64_signum), ARITHMETIC},
+    {"dec64_acos", dec64_acos, NULL, ELEMENTARY},
+    {"dec64_asin", dec64_asin, NULL, ELEMENTARY},
+    {"dec64_atan", dec64_atan, NULL, ELEMENTARY},
+    {"dec64_cos", dec64_cos, NULL, ELEMENTARY},
+    {"dec64_exp", dec64_exp, NULL, ELEMENTARY},
+    {"dec64_factorial", dec64_factorial, NULL, ELEMENTARY},
+    {"dec64_log", dec64_log, NULL, ELEMENTARY},
+    {"dec64_random", bench_random, NULL, ELEMENTARY},
+    {"dec64_seed", bench_seed, NULL, ELEMENTARY},
+    {"dec64_sin", dec64_sin, NULL, ELEMENTARY},
+    {"dec64_sqrt", dec64_sqrt, NULL, ELEMENTARY},
+    {"dec64_tan", dec64_tan, NULL, ELEMENTARY}
+};
+
+static const struct binary_case binary_cases[] = {
+    {"dec64_is_equal", dec64_is_equal, NASM(dec64_is_equal), ARITHMETIC},
+    {"dec64_is_less", dec64_is_less, NASM(dec64_is_less), ARITHMETIC},
+    {"dec64_add", dec64_add, NASM(dec64_add), ARITHMETIC},
+    {"dec64_divide", dec64_divide, NASM(dec64_divide), ARITHMETIC},
+    {"dec64_integer_divide", dec64_integer_divide, NASM(dec64_integer_divide), ARITHMETIC},
+    {"dec64_modulo", dec64_modulo, NASM(dec64_modulo), ARITHMETIC},
+    {"dec64_multiply", dec64_multiply, NASM(dec64_multiply), ARITHMETIC},
+    {"dec64_subtract", dec64_subtract, NASM(dec64_subtract), ARITHMETIC},
+    {"dec64_atan2", dec64_atan2, NULL, ELEMENTARY},
+    {"dec64_raise", dec64_raise, NULL, ELEMENTARY},
+    {"dec64_root", dec64_root, NULL, ELEMENTARY}
+};
+
+#ifdef DEC64_BENCH_DISPATCH
+static void run_dispatch() {
+    size_t at;
+    int chosen = dec64_dispatch_variant();
+    int variant;
+    const char* name;
+
+    for (variant = DEC64_VARIANT_C; variant <= DEC64_VARIANT_BMI2; variant += 1) {
+        if (dec64_dispatch_use(variant) != variant) {
+            continue;
+        }
+        name = dec64_dispatch_name(variant);
+        run_new(name, dec64_new);
+        run_round(name, dec64_round);
+        for (at = 0; at < sizeof binary_cases / sizeof binary_cases[0]; at += 1) {
+            if (
+                binary_cases[at].c == dec64_add
+                || binary_cases[at].c == dec64_subtract
+                || binary_cases[at].c == dec64_multiply
+                || binary_cases[at].c == dec64_divide
+                || binary_cases[at].c == dec64_integer_divide
+                || binary_cases[at].c == dec64_modulo
+            ) {
+                run_binary(
+                    binary_cases[at].name,
+                    name,
+                    binary_cases[at].c,
+                    binary_cases[at].distributions
+                );
+            }
+        }
+    }
+    dec64_dispatch_use(chosen);
+}
+#endif
+
+int main(int argc, char* argv[]) {
+    size_t at;
+
+    filter = argc > 1 ? argv[1] : NULL;
+    seed = 0x9E3779B97F4A7C15ULL;
+    state = dec64_string_begin();
+    cache = dec64_string_cache_begin(4 * NR_VALUES);
+    generate();
+
+    printf(
+        "%-24s %-6s %-8s %10s %14s %10s\n",
+        "function",
+        "impl",
+        "inputs",
+        "ns/op",
+        "ops/s",
+        "cycles/op"
+    );
+    run_new("lib", dec64_new);
+    run_new("nasm", NASM(dec64_new));
+    run_new_drop("lib", dec64_new);
+    run_new_drop("nasm", NASM(dec64_new));
+    run_round("lib", dec64_round);
+    run_round("nasm", NASM(dec64_round));
+    run_inline("dec64_inline_add", 0);
+    run_inline("dec64_inline_subtract", 1);
+    run_fma(1);
+    run_fma(0);
+    run_sum(1);
+    run_sum(0);
+    run_dot(1);
+    run_dot(0);
+    run_scan(1);
+    run_scan(0);
+    run_divide_by(1);
+    run_divide_by(0);
+    run_parallel("dec64_parallel_dot", bench_parallel_dot);
+    run_parallel("dec64_parallel_max", dec64_parallel_max);
+    run_parallel("dec64_parallel_mean", dec64_parallel_mean);
+    run_parallel("dec64_parallel_min", dec64_parallel_min);
+    run_parallel("dec64_parallel_scan_inclusive", bench_parallel_scan);
+    run_parallel("dec64_parallel_sum", dec64_parallel_sum);
+    run_array("dec64_abs_n", dec64_abs_n, NULL, NULL);
+    run_array("dec64_add_n", NULL, dec64_add_n, NULL);
+    run_array("dec64_add_n_scalar", NULL, NULL, dec64_add_n_scalar);
+    run_array("dec64_divide_n", NULL, dec64_divide_n, NULL);
+    run_array("dec64_divide_n_scalar", NULL, NULL, dec64_divide_n_scalar);
+    run_array("dec64_is_equal_n", NULL, dec64_is_equal_n, NULL);
+    run_array("dec64_is_equal_n_scalar", NULL, NULL, dec64_is_equal_n_scalar);
+    run_array("dec64_is_less_n", NULL, dec64_is_less_n, NULL);
+    run_array("dec64_is_less_n_scalar", NULL, NULL, dec64_is_less_n_scalar);
+    run_array("dec64_multiply_n", NULL, dec64_multiply_n, NULL);
+    run_array("dec64_multiply_n_scalar", NULL, NULL, dec64_multiply_n_scalar);
+    run_array("dec64_neg_n", dec64_neg_n, NULL, NULL);
+    run_array("dec64_signum_n", dec64_signum_n, NULL, NULL);
+    run_array("dec64_subtract_n", NULL, dec64_subtract_n, NULL);
+    run_array("dec64_subtract_n_scalar", NULL, NULL, dec64_subtract_n_scalar);
+    for (at = 0; at < sizeof unary_cases / sizeof unary_cases[0]; at += 1) {
+        run_unary(
+            unary_cases[at].name,
+            "lib",
+            unary_cases[at].c,
+            unary_cases[at].distributions
+        );
+        run_unary(
+            unary_cases[at].name,
+            "nasm",
+            unary_cases[at].nasm,
+            unary_cases[at].distributions
+        );
+    }
+    for (at = 0; at < sizeof binary_cases / sizeof binary_cases[0]; at += 1) {
+        run_binary(
+            binary_cases[at].name,
+            "lib",
+            binary_cases[at].c,
+            binary_cases[at].distributions
+        );
+        run_binary(
+            binary_cases[at].name,
+            "nasm",
+            binary_cases[at].nasm,
+            binary_cases[at].distributions
+        );
+    }
+#ifdef DEC64_BENCH_DISPATCH
+    run_dispatch();
+#endif
+    run_string();
+
+    dec64_string_cache_end(cache);
+    dec64_string_end(state);
+    return 0;
+}
@@ -0,0 +1,44 @@
+/* dec64_dispatch.h
+
+The dec64_dispatch header file. This is the companion to dec64_dispatch.c.
+
+When the library is built with DEC64_BACKEND=DISPATCH, the heavier dec64
+functions (new, add, subtract, multiply, divide, integer_divide, modulo and
+round) have more than one implementation in the same binary, and each call
+goes through a table that is filled in at startup for the host processor.
+
+dec64_dispatch_variant tells which variant is in use. dec64_dispatch_use
+selects a variant, if it is available, and returns the variant that is now
+in use. It can be called while other threads are using dec64: each call
+takes the whole table of one variant or of the other.
+dec64_dispatch_name gives the name of a variant, as accepted by the
+DEC64_DISPATCH environment variable.
+
+The batched kernels of dec64_array are selected separately; see
+dec64_array_kernel.
+
+Public Domain
+
+No warranty.
+*/
+
+#ifndef DEC64_DISPATCH_H
+#define DEC64_DISPATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEC64_VARIANT_C 0       /* the portable C port of dec64.c */
+#define DEC64_VARIANT_NASM 1    /* the routines of dec64n.asm */
+#define DEC64_VARIANT_BMI2 2    /* the C port compiled for BMI2, ADX and LZCNT */
+
+extern int dec64_dispatch_variant(void);
+extern int dec64_dispatch_use(int variant);
+extern const char* dec64_dispatch_name(int variant);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //DEC64_DISPATCH_H
@@ -0,0 +1,51 @@
+/* dec64_divisor.h
+
+The dec64_divisor header file. This is the companion to dec64_divisor.c.
+
+A dec64_divisor is a number prepared for being divided by many times, like an
+exchange rate or a share count that a whole column is divided by. It is made
+once with dec64_divisor_make, and then dec64_divide_by gives exactly the
+quotient that dec64_divide would give, without a hardware division.
+dec64_divide_by_n divides n numbers by it. quotients may be the same array as
+dividends.
+
+A dec64_divisor is a plain struct that the caller owns. It does not change
+after it is made, so any number of threads can use it at once.
+
+Public Domain
+
+No warranty.
+*/
+
+#ifndef DEC64_DIVISOR
+#define DEC64_DIVISOR
+
+#include <stddef.h>
+#include "dec64.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct dec64_divisor {
+    dec64 divisor;
+    uint64 normalized;
+    uint64 reciprocal;
+    int shift;
+    int bits;
+} dec64_divisor;
+
+extern dec64_divisor dec64_divisor_make(dec64 divisor);
+extern dec64 dec64_divide_by(dec64 dividend, const dec64_divisor* divisor);
+extern void dec64_divide_by_n(
+    dec64* quotients,
+    const dec64* dividends,
+    const dec64_divisor* divisor,
+    size_t n
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //DEC64_DIVISOR
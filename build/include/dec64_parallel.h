@@ -0,0 +1,61 @@
+/* dec64_parallel.h
+
+The dec64_parallel header file. This is the companion to dec64_parallel.c.
+
+Each function reduces n numbers to one, splitting the work over up to
+nthreads threads (the caller is one of them). The result is exactly the same
+for any number of threads. A nan among the numbers makes the result nan, and
+so does an empty array, except for the sum, which is zero.
+
+dec64_parallel_dot is the sum of the products of two arrays, as dec64_dot.
+
+dec64_parallel_scan_inclusive and dec64_parallel_scan_exclusive write the same
+running totals as dec64_scan_inclusive and dec64_scan_exclusive, and return the
+same final total, for any number of threads. totals may be the same array as
+numbers.
+
+Public Domain
+
+No warranty.
+*/
+
+#ifndef DEC64_PARALLEL
+#define DEC64_PARALLEL
+
+#include <stddef.h>
+#include "dec64.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern dec64 dec64_parallel_dot(
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    size_t n,
+    int nthreads
+);
+extern dec64 dec64_parallel_max(const dec64* numbers, size_t n, int nthreads);
+extern dec64 dec64_parallel_mean(const dec64* numbers, size_t n, int nthreads);
+extern dec64 dec64_parallel_min(const dec64* numbers, size_t n, int nthreads);
+extern dec64 dec64_parallel_scan_exclusive(
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start,
+    int nthreads
+);
+extern dec64 dec64_parallel_scan_inclusive(
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start,
+    int nthreads
+);
+extern dec64 dec64_parallel_sum(const dec64* numbers, size_t n, int nthreads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //DEC64_PARALLEL
@@ -1,6 +1,53 @@
 //
 // Created by Gabriel Ferreira (@gabrielcarvfer) on 04-Aug-18.
 //
+//With DEC64_DISPATCH the public names of the dispatched functions (see
+// dec64_dispatch.c) are not defined here. Instead this file is compiled twice:
+// once as usual, with the dispatched functions renamed to dec64_c_*, and once
+// with BMI2/ADX/LZCNT code generation and DEC64_DISPATCH_BMI2, with every
+// function renamed to dec64_bmi2_* so that both objects can be linked together
+#if defined(DEC64_DISPATCH_BMI2)
+#define DEC64_RENAME(name) dec64_bmi2_##name
+#define dec64_coefficient DEC64_RENAME(coefficient)
+#define dec64_exponent DEC64_RENAME(exponent)
+#define dec64_digits DEC64_RENAME(digits)
+#define dec64_build DEC64_RENAME(build)
+#define dec64_pack DEC64_RENAME(pack)
+#define dec64_add_proc DEC64_RENAME(add_proc)
+#define dec64_inc DEC64_RENAME(inc)
+#define dec64_dec DEC64_RENAME(dec)
+#define dec64_round_proc DEC64_RENAME(round_proc)
+#define dec64_ceiling DEC64_RENAME(ceiling)
+#define dec64_floor DEC64_RENAME(floor)
+#define dec64_fma DEC64_RENAME(fma)
+#define dec64_is_nan DEC64_RENAME(is_nan)
+#define dec64_is_zero DEC64_RENAME(is_zero)
+#define dec64_is_false DEC64_RENAME(is_false)
+#define dec64_is_integer DEC64_RENAME(is_integer)
+#define dec64_signum DEC64_RENAME(signum)
+#define dec64_neg DEC64_RENAME(neg)
+#define dec64_abs DEC64_RENAME(abs)
+#define dec64_half DEC64_RENAME(half)
+#define dec64_int DEC64_RENAME(int)
+#define dec64_normal DEC64_RENAME(normal)
+#define dec64_not DEC64_RENAME(not)
+#define dec64_is_equal DEC64_RENAME(is_equal)
+#define dec64_is_less DEC64_RENAME(is_less)
+#elif defined(DEC64_DISPATCH)
+#define DEC64_RENAME(name) dec64_c_##name
+#endif
+
+#ifdef DEC64_RENAME
+#define dec64_new DEC64_RENAME(new)
+#define dec64_add DEC64_RENAME(add)
+#define dec64_subtract DEC64_RENAME(subtract)
+#define dec64_multiply DEC64_RENAME(multiply)
+#define dec64_divide DEC64_RENAME(divide)
+#define dec64_integer_divide DEC64_RENAME(integer_divide)
+#define dec64_modulo DEC64_RENAME(modulo)
+#define dec64_round DEC64_RENAME(round)
+#endif
+
 #include "dec64.h"
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,31 +57,85 @@
 #define MAXNUM 0x007FFFFFFFFFFFFF
 #define MAXEXP 0x007F
 
-static int64 powers10[] = {(int64) 1,                       // 10^00
-                           (int64) 10,                      // 10^01
-                           (int64) 100,                     // 10^02
-                           (int64) 1000,                    // 10^03
-                           (int64) 10000,                   // 10^03
-                           (int64) 100000,                  // 10^04
-                           (int64) 1000000,                 // 10^05
-                           (int64) 10000000,                // 10^06
-                           (int64) 100000000,               // 10^07
-                           (int64) 1000000000,              // 10^08
-                           (int64) 10000000000,             // 10^09
-                           (int64) 100000000000,            // 10^10
-                           (int64) 1000000000000,           // 10^11
-                           (int64) 10000000000000,          // 10^12
-                           (int64) 100000000000000,         // 10^13
-                           (int64) 1000000000000000,        // 10^13
-                           (int64) 10000000000000000,       // 10^14
-                           (int64) 100000000000000000,      // 10^15
-                           (int64) 1000000000000000000,     // 10^16
-                           (int64) 10000000000000000000,     // 10^17
-                           (int64) 100000000000000000000,     // 10^18
-                           (int64) 1000000000000000000000,     // 10^19
-
-
-                           };
+#if defined(_MSC_VER)
+#include <intrin.h>
+static int leading_zeros(uint64 x)
+{
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - (int) index;
+}
+#else
+#define leading_zeros(x) __builtin_clzll(x)
+#endif
+
+static const uint64 powers10[] = {1ULL,                       // 10^00
+                                  10ULL,                      // 10^01
+                                  100ULL,                     // 10^02
+                                  1000ULL,                    // 10^03
+                                  10000ULL,                   // 10^04
+                                  100000ULL,                  // 10^05
+                                  1000000ULL,                 // 10^06
+                                  10000000ULL,                // 10^07
+                                  100000000ULL,               // 10^08
+                                  1000000000ULL,              // 10^09
+                                  10000000000ULL,             // 10^10
+                                  100000000000ULL,            // 10^11
+                                  1000000000000ULL,           // 10^12
+                                  10000000000000ULL,          // 10^13
+                                  100000000000000ULL,         // 10^14
+                                  1000000000000000ULL,        // 10^15
+                                  10000000000000000ULL,       // 10^16
+                                  100000000000000000ULL,      // 10^17
+                                  1000000000000000000ULL,     // 10^18
+                                  10000000000000000000ULL,    // 10^19
+                                  };
+
+#if defined(__SIZEOF_INT128__)
+typedef __int128 int128;
+typedef unsigned __int128 uint128;
+#endif
+
+//Magic numbers for dividing by 10^k without a division. 10^k is 2^k * 5^k, so
+// abs / 10^k is ((abs >> k) * magic) >> (64 + shift), with magic = ceil(2^(64+shift) / 5^k)
+// and the smallest shift that makes it exact for every abs under 2^64
+static const struct
+{
+    uint64 magic;
+    int shift;
+} divide10[] = {{0ULL,                  0},     // 10^00 is not used
+                {0x6666666666666667ULL, 1},     // 10^01
+                {0x28F5C28F5C28F5C3ULL, 2},     // 10^02
+                {0x20C49BA5E353F7CFULL, 4},     // 10^03
+                {0x0D1B71758E219653ULL, 5},     // 10^04
+                {0x0A7C5AC471B47843ULL, 7},     // 10^05
+                {0x0218DEF416BDB1A7ULL, 7},     // 10^06
+                {0x00D6BF94D5E57A43ULL, 8},     // 10^07
+                {0x00ABCC77118461CFULL, 10},    // 10^08
+                {0x0044B82FA09B5A53ULL, 11},    // 10^09
+                {0x001B7CDFD9D7BDBBULL, 12},    // 10^10
+                {0x000AFEBFF0BCB24BULL, 13},    // 10^11
+                {0x0008CBCCC096F509ULL, 15},    // 10^12
+                {0x000709709A125DA1ULL, 17},    // 10^13
+                {0x0000B424DC35095DULL, 16},    // 10^14
+                {0x00024075F3DCEAC3ULL, 20},    // 10^15
+                {0x0000734ACA5F6227ULL, 20},    // 10^16
+                {0x00005C3BD5191B53ULL, 22},    // 10^17
+                {0x000049C97747490FULL, 24},    // 10^18
+                {0x00001D83C94FB6D3ULL, 25},    // 10^19
+                };
+
+//abs / 10^k, for k from 1 to 19, with one multiply
+static inline uint64 divide_power10(uint64 abs, int64 k)
+{
+#if defined(__SIZEOF_INT128__)
+    return (uint64) (((uint128) (abs >> k) * divide10[k].magic) >> 64) >> divide10[k].shift;
+#elif defined(_MSC_VER)
+    return __umulh(abs >> k, divide10[k].magic) >> divide10[k].shift;
+#else
+    return abs / powers10[k];
+#endif
+}
 
 int64 dec64_coefficient(int64 number)
 {
@@ -49,78 +150,22 @@ int64 dec64_exponent(int64 number)
     return (int64) val;
 }
 
+int64 dec64_digits(int64 coeff)
+{
+    //Number of decimal digits in the absolute value of coeff (zero has none)
+    //The bit length times log10(2) (1233/4096) is the digit count or one less,
+    // and a single comparison with the power of ten settles which
+    uint64 abs = coeff < 0 ? 0 - (uint64) coeff : (uint64) coeff;
+    int bits = 64 - leading_zeros(abs | 1);
+    int digits = (bits * 1233) >> 12;
+    return digits + (abs >= powers10[digits]);
+}
+
 int64 dec64_build(int64 coeff, int64 exp)
 {
     return (coeff << 8) | (0x0FF & exp);
 }
 
-
-
-
-/*
-dec64_round: function_with_two_parameters
-;(number: dec64, place: dec64) returns quantization: dec64
-
-; The place argument indicates at what decimal place to round.
-;    -2        nearest cent
-;     0        nearest integer
-;     3        nearest thousand
-;     6        nearest million
-;     9        nearest billion
-
-; The place should be between -16 and 16.
-
-mov     r11,r1          ; preserve the number
-        mov     r1,r2           ; pass the place
-        call_with_one_parameter dec64_int
-        mov     r9,r0           ; r9 is the normalized place
-        cmp     r11_b,128       ; is the first operand not nan?
-setne   r1_b
-sar     r9,8            ; r9 is the place as int64
-cmp     r0_b,128        ; is the second operand nan?
-setne   r1_h
-movsx   r8,r11_b        ; r8 is the current exponent
-        mov     r0,r11          ; r0 is the number
-test    r1_b,r1_h       ; is either nan?
-jz      return_nan      ; %if so, the result is nan
-
-sar     r0,8            ; r0 is the coefficient
-jz      return          ; %if the coefficient is zero, the result is zero
-        cmp     r8,r9           ; compare the exponents
-        jge     pack            ; no rounding required
-        mov     r2,r0           ; r2 is the coefficient
-neg     r2              ; rs is the coefficient negated
-        cmovns  r0,r2           ; r0 is absolute value of the coefficient
-        mov     r10,eight_over_ten ; magic
-        pad
-
-round_loop:
-
-; Increment the exponent and divide the coefficient by 10 until the target
-; exponent is reached.
-
-mul     r10             ; r2 is the coefficient * 8 / 10
-mov     r0,r2           ; r0 is the coefficient * 8 / 10
-shr     r0,3            ; r0 is the coefficient / 10
-
-add     r8,1            ; increment the exponent
-        cmp     r8,r9           ; compare the exponents
-        jne     round_loop      ; loop %if the exponent has not reached the target
-
-; Round %if necessary and return the result.
-
-shr     r2,2            ; Isolate the carry bit
-and     r2,1            ; r2 is 1 %if rounding is needed
-        add     r0,r2           ; r0 is rounded
-        mov     r2,r0           ; r2 is the result
-neg     r2              ; r2 is the result negated
-        test    r11,r11         ; was the original number negative
-        cmovs   r0,r2           ; %if so, use the negated result
-jmp     pack            ; pack it up
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-*/
-
 int64 dec64_pack(int64 coeff, int64 exp)
 {
     //Zero is zero
@@ -132,74 +177,65 @@ int64 dec64_pack(int64 coeff, int64 exp)
         return DEC64_NAN;
 
     int negc = coeff < 0;
-    int64 maxval = negc ? MAXNUM+1 : MAXNUM;
-    coeff = negc ? -coeff : coeff;
+    uint64 maxval = negc ? MAXNUM+1 : MAXNUM;
+    uint64 abs = negc ? 0 - (uint64) coeff : (uint64) coeff;
 
-    int64 original_exp = exp;
-    int64 original_coeff = coeff;
-
-    int round=0;
-
-    //Pack procedures
-    while (1)
+    //equivalent to pack_decrease
+    //The coefficient takes the whole excess of the exponent in a single multiply
+    if (exp > 127)
     {
-        //equivalent to pack_decrease
-        if (exp > 127)
-        {
-            int64 tcoeff = coeff * 10;
-
-            if (tcoeff < 0)             //If overflows, nan
-                return DEC64_NAN;
-            coeff = tcoeff;             //Otherwise, continue
-            exp--;
-            continue;
-        }
+        int64 excess = exp - 127;
 
-        //equivalent to pack_increase and
-        //equivalent to pack_large
-        if(coeff > maxval || exp < -127)
-        {
-            //Couldn't save the value
-            if (exp == 127)
-                return DEC64_NAN;
-            //No more divisions to make
-            if (coeff == 0)
-                break;
-            coeff /= 10;
-            exp++;
-            continue;
-        }
+        //If overflows, nan
+        if (excess > 17 - dec64_digits(coeff) || abs * powers10[excess] > maxval)
+            return DEC64_NAN;
+        abs *= powers10[excess];
+        exp = 127;
+    }
 
-        //If doesn't need any procedure, break loop and procede
-        break;
+    //equivalent to pack_increase and
+    //equivalent to pack_large
+    //The digit count tells at once how many digits must be dropped
+    int64 drop = 0;
+    if (abs > maxval)
+    {
+        drop = dec64_digits(coeff) - 17;
+        if (drop == 0 || divide_power10(abs, drop) > maxval)
+            drop++;
     }
+    if (exp < -127 - drop)
+        drop = -127 - exp;
 
-    //round properly - may overflow maxval
-    int muls = exp - original_exp;
-    if (muls > 0 && muls <= 19)
+    if (drop > 0)
     {
-        int64 tcoeff = coeff;
-        int64 temp2 = original_coeff / powers10[muls-1];
-        coeff = coeff + ((temp2 % 10 >= 5) ? 1 : 0);
+        //One multiply by the magic number of the power of 10, rounding half away from zero
+        if (drop < 20)
+        {
+            uint64 divisor = powers10[drop];
+            uint64 quotient = divide_power10(abs, drop);
+            uint64 rest = abs - quotient * divisor;
+            abs = quotient + (rest >= divisor / 2);
+        }
+        else
+            abs = 0;
+        exp += drop;
 
-        if (coeff > maxval)
+        //Rounding up may carry into an extra digit
+        if (abs > maxval)
         {
-            round = coeff % 10;
-            coeff += (round >= 5 && coeff > 10) ? 10 - round : 0;
-            coeff /= 10;
+            abs = (abs + 5) / 10;
             exp++;
         }
 
-        //Verify the distance between rounded and non-rounded numbers
-        //if ( (original_coeff - coeff) > (original_coeff - tcoeff) )
-        //    coeff = tcoeff;
+        //Couldn't save the value
+        if (exp > 127)
+            return DEC64_NAN;
     }
 
-    if (coeff == 0)
+    if (abs == 0)
         return 0;
 
-
-    coeff = negc ? -coeff : coeff;
+    coeff = negc ? -(int64) abs : (int64) abs;
     return dec64_build(coeff, exp);
 }
 
@@ -209,16 +245,6 @@ int64 dec64_new(int64 coeff, int64 exp)
     return dec64_pack(coeff, exp);
 }
 
-int checkPowerOf10(int64 coeff)
-{
-    for (int i = 0; i < 20; i++)
-    {
-        if (coeff < powers10[i])
-            return i;
-    }
-    return 0;
-}
-
 int64 dec64_add_proc(int64 augend, int64 addend, int subtraction)
 {
     int8_t exp1, exp2;
@@ -246,12 +272,18 @@ int64 dec64_add_proc(int64 augend, int64 addend, int subtraction)
     if(exp1-exp2 > 17)
     {
         //Before returning, check if the second value can be truncated (n divisions by 10 makes it fit)
-        int k = checkPowerOf10(coeff2);
+        int64 k = dec64_digits(coeff2);
         if (exp1-exp2-k > 17)
             return augend;
     }
+    //The same for the other side. A subtrahend is negated with dec64_pack, because the
+    // negation of -2^55 does not fit
     if(exp2-exp1 > 17)
-        return (subtraction ? -coeff2 << 8 | 0x0FF & exp2 : addend);
+    {
+        int64 k = dec64_digits(coeff1);
+        if (exp2-exp1-k > 17)
+            return subtraction ? dec64_pack(-coeff2, exp2) : addend;
+    }
 
     //Invert arguments and keep the higher exponent on coeff1|exp1
     int inverted = 0;
@@ -272,44 +304,51 @@ int64 dec64_add_proc(int64 augend, int64 addend, int subtraction)
     coeff1 = neg1 ? -coeff1 : coeff1;
     coeff2 = neg2 ? -coeff2 : coeff2;
 
-    //Adjust numbers
-    int pow10coeff1 = checkPowerOf10(coeff1);
-    int pow10coeff2 = checkPowerOf10(coeff2);
-
-    //Align mantissas through the exponents until
+    //Align mantissas through the exponents
     //equivalent to add slower_decrease and add_slower
-    int64   tcoeff1 = coeff1 * 10;
-    int8_t  texp1 = exp1-1;
-    while( (tcoeff1 < MAXNUM || ( subtraction & (!neg1&!neg2) | (neg1&!neg2) ) ) && exp1 > exp2 && pow10coeff1 < 18)
+    //Scale coeff1 by as many powers of 10 as the exponent difference allows, while it
+    // stays under 18 digits and, when the magnitudes are added, under MAXNUM
+    //When they are subtracted, nothing can overflow, and any limit would lose digits
+    // that decide the result, like -3602879701896397e1 - -36028797018963968
+    int64 digits1 = dec64_digits(coeff1);
+    int64 shift = exp1 - exp2;
+    if (shift > 18 - digits1)
+        shift = 18 - digits1;
+    if (subtraction ? neg1 != neg2 : neg1 == neg2)
+    {
+        int64 fits = 16 - digits1;
+        if (fits >= 0 && coeff1 * (int64) powers10[fits + 1] < MAXNUM)
+            fits++;
+        if (shift > fits)
+            shift = fits;
+    }
+    if (shift > 0)
     {
-        coeff1 = tcoeff1;
-        exp1 = texp1;
-        tcoeff1 *= 10;
-        texp1--;
-        pow10coeff1++;
+        coeff1 *= (int64) powers10[shift];
+        exp1 -= shift;
     }
 
      //divide mantissa and increase exponent of addend
     int expdiff = exp1-exp2;
 
-    //while (expdiff > 17)
+    //The addend is too small to matter. coeff1 has lost its sign, and it is
+    // the subtrahend when the arguments were inverted
     if (expdiff > 17)
-        return dec64_pack(coeff1, exp1);
+        return dec64_pack(neg1 != (subtraction && inverted) ? -coeff1 : coeff1, exp1);
 
+    //One multiply drops all the digits, and the first of them rounds half away from zero
     if (expdiff > 0)
     {
-        int64 tcoeff2, original_coeff2;
-        tcoeff2 = original_coeff2 = coeff2;
-
-        coeff2 /= powers10[expdiff-1];
-        int round = coeff2 % 10;
-        coeff2 += (round >= 5) ? 10 - round : 0;
-        coeff2 /= 10;
+        uint64 divisor = powers10[expdiff];
+        uint64 quotient = divide_power10((uint64) coeff2, expdiff);
+        uint64 rest = (uint64) coeff2 - quotient * divisor;
+        coeff2 = (int64) (quotient + (rest >= divisor / 2));
         exp2 = exp1;
     }
 
+    //The addend rounded away. When inverted, the result is the subtrahend negated
     if(coeff2 == 0)
-        return inverted? addend : augend;
+        return !inverted ? augend : subtraction ? dec64_pack(-(addend >> 8), (int8_t) addend) : addend;
 
     coeff1 = neg1? -coeff1 : coeff1;
     coeff2 = neg2? -coeff2 : coeff2;
@@ -404,11 +443,7 @@ int64 dec64_round_proc(int64 num, int64 roundup)
     int64 absCoeff = positive? coeff : -coeff;
     int64 absExp   = exp   > 0 ? exp   : -exp;
 
-    int power = checkPowerOf10(absCoeff);
-    int expDiff = power - absExp; //remember that exp < 0
-
-
-    int round;
+    int64 expDiff = dec64_digits(absCoeff) - absExp; //remember that exp < 0
 
     //Round numbers -inf<x<1
     if (expDiff <= 0)
@@ -420,14 +455,15 @@ int64 dec64_round_proc(int64 num, int64 roundup)
         absExp   = 0;
     }
 
-    //Divide and round
-    while(absExp > 0)
+    //Divide once by the power of 10 with its magic number, rounding away from zero when asked to
+    if (absExp > 0)
     {
-        round = (!(positive ^ ceil) && absCoeff % 10) * 10;
-        absCoeff += round; //add or subtract rounding if number is positive or negative
-        absCoeff /= 10;
-        absExp -= 1;
-        power -= 1;
+        int64 divisor = (int64) powers10[absExp];
+        int64 quotient = (int64) divide_power10((uint64) absCoeff, absExp);
+        int64 rest = absCoeff - quotient * divisor;
+        absCoeff = quotient;
+        absCoeff += !(positive ^ ceil) && rest;
+        absExp = 0;
     }
 
 
@@ -447,660 +483,501 @@ int64 dec64_floor(int64 num)
 {
     return dec64_round_proc(num, DEC64_ZERO);
 }
-/*
 
-dec64_multiply: function_with_two_parameters
-;(multiplicand: dec64, multiplier: dec64) returns product: dec64
+#if defined(__SIZEOF_INT128__)
+
+//10^k for k up to 38, the largest power of 10 under 2^127
+static uint128 power10_128(int64 k)
+{
+    return k <= 19 ? powers10[k] : (uint128) powers10[19] * powers10[k - 19];
+}
+
+static int64 digits128(uint128 abs)
+{
+    uint64 high = (uint64) (abs >> 64);
+    int bits = high != 0 ? 128 - leading_zeros(high) : 64 - leading_zeros((uint64) abs | 1);
+    int digits = (bits * 1233) >> 12;
+    return digits + (abs >= power10_128(digits));
+}
+
+//dec64_pack for a 128 bit coefficient, with the same single rounding half away from zero
+static int64 dec64_pack128(int128 coeff, int64 exp)
+{
+    if (coeff == (int64) coeff)
+        return dec64_pack((int64) coeff, exp);
+
+    int negc = coeff < 0;
+    uint128 maxval = negc ? MAXNUM+1 : MAXNUM;
+    uint128 abs = negc ? 0 - (uint128) coeff : (uint128) coeff;
+
+    int64 drop = digits128(abs) - 17;
+    if (abs / power10_128(drop) > maxval)
+        drop++;
+    if (exp < -127 - drop)
+        drop = -127 - exp;
+
+    if (drop <= 38)
+    {
+        uint128 divisor = power10_128(drop);
+        uint128 quotient = abs / divisor;
+        uint128 rest = abs - quotient * divisor;
+        abs = quotient + (rest >= divisor / 2);
+    }
+    else
+        abs = 0;
+
+    //What is left fits in 64 bits, and dec64_pack only has to deal with a carry
+    return dec64_pack(negc ? -(int64) abs : (int64) abs, exp + drop);
+}
+
+int64 dec64_fma(int64 multiplicand, int64 multiplier, int64 addend)
+{
+    int nan1 = (int8_t) multiplicand == -128;
+    int nan2 = (int8_t) multiplier == -128;
+    int64 coeff1 = multiplicand >> 8;
+    int64 coeff2 = multiplier >> 8;
+    int64 coeff3 = addend >> 8;
+
+    //The product is nan if either factor is nan and neither is zero, as in dec64_multiply
+    if ((nan1 && (coeff2 != 0 || nan2)) || (nan2 && (coeff1 != 0 || nan1)) || (int8_t) addend == -128)
+        return DEC64_NAN;
+
+    //A zero product leaves the addend, and a zero addend leaves the product
+    int128 product = (int128) coeff1 * coeff2;
+    if (product == 0)
+        return dec64_add(DEC64_ZERO, addend);
+    if (coeff3 == 0)
+        return dec64_multiply(multiplicand, multiplier);
+
+    //Fast path: the product fits in 64 bits and has the exponent of the addend
+    int64 exp1 = (int64) (int8_t) multiplicand + (int8_t) multiplier;
+    int64 exp3 = (int8_t) addend;
+    int64 sum64;
+    if (exp1 == exp3 && product == (int64) product && !__builtin_add_overflow((int64) product, coeff3, &sum64))
+        return dec64_pack(sum64, exp1);
+
+    //Keep the term with the larger exponent in big, and scale it up by as many powers of
+    // 10 as the gap allows while it stays under 10^37
+    int128 big = product, small = coeff3;
+    int64 exp = exp1, gap = exp1 - exp3;
+    if (gap < 0)
+    {
+        big = coeff3;
+        small = product;
+        exp = exp3;
+        gap = -gap;
+    }
+    int64 shift = 37 - digits128(big < 0 ? 0 - (uint128) big : (uint128) big);
+    if (shift > gap)
+        shift = gap;
+    big *= (int128) power10_128(shift);
+    exp -= shift;
+    gap -= shift;
+
+    //The rest of the gap is taken from the small term, remembering if anything was lost
+    int sticky = 0;
+    int small_negative = small < 0;
+    if (gap > 0)
+    {
+        int128 quotient = gap <= 38 ? small / (int128) power10_128(gap) : 0;
+        sticky = gap > 38 || quotient * (int128) power10_128(gap) != small;
+        small = quotient;
+    }
+
+    int128 sum = big + small;
+    if (sticky)
+    {
+        //big has 37 digits, so at least 19 are dropped. The lost digits are replaced by a
+        // unit one place further down, which rounds the same way
+        sum = sum * 10 + (small_negative ? -1 : 1);
+        exp--;
+    }
+    if (sum == 0)
+        return DEC64_ZERO;
+    return dec64_pack128(sum, exp);
+}
+
+#else
+
+//Without 128 bit integers the product is rounded before the addition
+int64 dec64_fma(int64 multiplicand, int64 multiplier, int64 addend)
+{
+    return dec64_add(dec64_multiply(multiplicand, multiplier), addend);
+}
+
+#endif
+
+#ifdef DEC64_BACKEND_C
+
+//The C backend provides the functions that otherwise come from dec64n.asm, dec64m.asm or dec64.s
+//It follows the assembly, so comparisons return DEC64_ONE or DEC64_ZERO
+//The 128 bit products that the assembly builds in r2:r0 are unsigned __int128 here
+
+#if !defined(__SIZEOF_INT128__)
+#error "DEC64_BACKEND=C needs a compiler with unsigned __int128"
+#endif
+
+#define IS_NAN(number) ((int8_t) (number) == -128)
+
+int64 dec64_is_nan(int64 number)
+{
+    return IS_NAN(number) ? DEC64_ONE : DEC64_ZERO;
+}
+
+int64 dec64_is_zero(int64 number)
+{
+    return (number & ~0xFFLL) == 0 && !IS_NAN(number) ? DEC64_ONE : DEC64_ZERO;
+}
+
+int64 dec64_is_false(int64 boolean)
+{
+    return boolean == DEC64_FALSE ? DEC64_TRUE : DEC64_FALSE;
+}
+
+int64 dec64_is_integer(int64 number)
+{
+    //Nan is not an integer
+    if (IS_NAN(number))
+        return DEC64_ZERO;
+
+    int64 coeff = number >> 8;
+    int64 exp = (int8_t) number;
+    if (coeff == 0 || exp >= 0)
+        return DEC64_ONE;
+
+    //Extreme negative exponents can never be integer
+    if (-exp >= 17)
+        return DEC64_ZERO;
+
+    return coeff % (int64) powers10[-exp] == 0 ? DEC64_ONE : DEC64_ZERO;
+}
+
+int64 dec64_signum(int64 number)
+{
+    if (IS_NAN(number))
+        return DEC64_NAN;
 
-; Multiply two dec64 numbers together.
+    int64 coeff = number >> 8;
+    return coeff < 0 ? DEC64_NEGATIVE_ONE : coeff > 0 ? DEC64_ONE : DEC64_ZERO;
+}
 
-; Unpack the exponents into r8 and r9.
-
-movsx   r8,r1_b         ; r8 is the first exponent
-        movsx   r9,r2_b         ; r9 is the second exponent
-
-; Set flags in r0 %if either operand is nan.
+int64 dec64_neg(int64 number)
+{
+    if (IS_NAN(number))
+        return DEC64_NAN;
 
-cmp     r1_b,128        ; is the first operand nan?
-sete    r0_b            ; r0_b is 1 %if the first operand is nan
-        cmp     r2_b,128        ; is the second operand nan?
-sete    r0_h            ; r0_h is 1 %if the second operand is nan
+    int64 coeff = number >> 8;
+    if (coeff == 0)
+        return DEC64_ZERO;
 
-; Unpack the coefficients. Set flags in r1 %if either is not zero.
+    //The most negative coefficient is the only one that can't be negated in place
+    if (coeff == -MAXNUM-1)
+        return dec64_pack(-coeff, (int8_t) number);
 
-sar     r1,8            ; r1 is the first coefficient
-        mov     r10,r1          ; r10 is the first coefficient
-        setnz   r1_b            ; r1_b is 1 %if the first coefficient is not zero
-sar     r2,8            ; r2 is the second coefficient
-        setnz   r1_h            ; r1_h is 1 %if the second coefficient is not zero
+    return dec64_build(-coeff, (int8_t) number);
+}
 
-; The result is nan %if one or both of the operands is nan and neither of the
-; operands is zero.
+int64 dec64_abs(int64 number)
+{
+    if (number < 0)
+        return dec64_neg(number);
+    if (IS_NAN(number))
+        return DEC64_NAN;
+    if ((number & ~0xFFLL) == 0)
+        return DEC64_ZERO;
+    return number;
+}
 
-or      r1_w,r0_w       ; is either coefficient zero and not nan?
-xchg    r1_b,r1_h
-test    r0_w,r1_w
-jnz     return_nan
-
-mov     r0,r10          ; r0 is the first coefficient
-        add     r8,r9           ; r8 is the product exponent
-        imul    r2              ; r2:r0 is r1 * r2
-jno     pack            ; %if the product fits in 64 bits, start packing
-
-; There was overflow.
-
-; Make the 110 bit coefficient in r2:r0Er8 all fit. Estimate the number of
-; digits of excess, and increase the exponent by that many digits.
-; We use 77/256 to convert log2 to log10.
-
-mov     r9,r2           ; r9 is the excess sign%ificance
-        xor     r1,r1           ; r1 is zero anticipating bsr
-        neg     r9
-        cmovs   r9,r2           ; r9 is absolute value of the excess sign%ificance
-
-        bsr     r1,r9           ; find the position of the most sign%ificant bit
-imul    r1,77           ; multiply the bit number by 77/256 to
-        shr     r1,8            ;     convert a bit number to a digit number
-add     r1,2            ; add two extra digits to the scale
-        add     r8,r1           ; increase the exponent
-        mov     r9,power
-        idiv    qword [r9+r1*8] ; divide by the power of ten
-jmp     pack
-
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_divide: function_with_two_parameters
-;(dividend: dec64, divisor: dec64) returns quotient: dec64
-
-; Divide a dec64 number by another.
-
-; Begin unpacking the components.
-
-movsx   r8,r1_b         ; r8 is the first exponent
-        movsx   r9,r2_b         ; r9 is the second exponent
-        mov     r10,r1          ; r10 is the first number
-        mov     r11,r2          ; r11 is the second number
-
-; Set nan flags in r0.
-
-cmp     r1_b,128        ; is the first operand nan?
-sete    r0_b            ; r0_b is 1 %if the first operand is nan
-        cmp     r2_b,128        ; is the second operand nan?
-sete    r0_h            ; r0_h is 1 %if the second operand is nan
-
-        sar     r10,8           ; r10 is the dividend coefficient
-        setnz   r1_b            ; r1_b is 1 %if the dividend coefficient is zero
-        sar     r11,8           ; r11 is the divisor coefficient
-        setz    r1_h            ; r1_h is 1 %if dividing by zero
-        or      r0_h,r0_b       ; r0_h is 1 %if either is nan
-        or      r1_b,r0_b       ; r1_b is zero %if the dividend is zero and not nan
-        jz      return_zero     ; %if the dividend is zero, the quotient is zero
-        sub     r8,r9           ; r8 is the quotient exponent
-        or      r0_b,r1_h       ; r0_b is 1 %if either is nan or the divisor is zero
-jnz     return_nan
-pad
-
-        divide_measure:
-
-; We want to get as many bits into the quotient as possible in order to capture
-; enough sign%ificance. But %if the quotient has more than 64 bits, then there
-; will be a hardware fault. To avoid that, we compare the magnitudes of the
-; dividend coefficient and divisor coefficient, and use that to scale the
-; dividend to give us a good quotient.
-
-mov     r0,r10          ; r0 is the first coefficient
-        mov     r1,r11          ; r1 is the second coefficient
-        neg     r0              ; r0 is negated
-        cmovs   r0,r10          ; r0 is abs of dividend coefficient
-neg     r1              ; r1 is negated
-        cmovs   r1,r11          ; r1 is abs of divisor coefficient
-bsr     r0,r0           ; r0 is the dividend most sign%ificant bit
-bsr     r1,r1           ; r1 is the divisor most sign%ificant bit
-
-; Scale up the dividend to be approximately 58 bits longer than the divisor.
-; Scaling uses factors of 10, so we must convert from a bit count to a digit
-; count by multiplication by 77/256 (approximately LN2/LN10).
-
-add     r1,58           ; we want approximately 58 bits in the raw quotient
-        sub     r1,r0           ; r1 is the number of bits to add to the dividend
-        imul    r1,77           ; multiply by 77/256 to convert bits to digits
-        shr     r1,8            ; r1 is the number of digits to scale the dividend
-
-; The largest power of 10 that can be held in an int64 is 1e18.
-
-cmp     r1,18           ; prescale the dividend %if 10**r1 won't fit
-jg      divide_prescale
-
-; Multiply the dividend by the scale factor, and divide that 128 bit result by
-; the divisor.  Because of the scaling, the quotient is guaranteed to use most
-; of the 64 bits in r0, and never more. Reduce the final exponent by the number
-; of digits scaled.
-
-mov     r0,r10          ; r0 is the dividend coefficient
-        mov     r9,power
-        imul    qword [r9+r1*8] ; r2:r0 is the dividend coefficient * 10**r1
-        idiv    r11             ; r0 is the quotient
-sub     r8,r1           ; r8 is the exponent
-jmp     pack            ; pack it up
-        pad
-
-divide_prescale:
-
-; %if the number of scaling digits is larger than 18, then we will have to
-; scale in two steps: first prescaling the dividend to fill a register, and
-; then repeating to fill a second register. This happens when the divisor
-; coefficient is much larger than the dividend coefficient.
-
-mov     r1,58           ; we want 58 bits or so in the dividend
-sub     r1,r0           ; r1 is the number of additional bits needed
-imul    r1,77           ; convert bits to digits
-shr     r1,8            ; sh%ift 8 is cheaper than div 256
-mov     r9,power
-imul    r10,qword [r9+r1*8] ; multiply the dividend by power of ten
-        sub     r8,r1           ; reduce the exponent
-        jmp     divide_measure  ; try again
-
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_integer_divide: function_with_two_parameters
-;(dividend: dec64, divisor: dec64) returns quotient: dec64
-
-; Divide, with a floored integer result. It produces the same result as
-;    dec64_floor(dec64_divide(dividend, divisor))
-; but can sometimes produce that result more quickly.
-
-cmp     r1_b,r2_b       ; are the exponents equal?
-jne     integer_divide_slow
-
-mov     r0,r1           ; r0 is the dividend
-mov     r11,r2          ; r11 is the divisor
-sar     r1,8            ; r1 is the dividend coefficient
-        setnz   r2_h            ; r2_h is 1 %if the dividend coefficient is not zero
-cmp     r0_b,128        ; are the operands nan?
-sete    r2_b            ; r2_b is 1 %if the operands are nan
-and     r0,-256         ; zero the dividend's exponent
-or      r2_h,r2_b       ; r2_h is zero %if the dividend is zero and not nan
-        jz      return_zero     ; the quotient is zero %if the dividend is zero
-sar     r11,8           ; r11 is the divisor coefficient
-        setz    r2_h            ; r2_h is 1 %if the divisor coefficient is zero
-        or      r2_b,r2_h       ; r2_b is 1 %if the result is nan
-jnz     return_nan
-cqo                     ; sign extend r0 into r2
-        idiv    r11             ; r0 is the quotient
-and     r0,-256         ; zero the exponent again
-ret                     ; no need to pack
-pad
-
-        integer_divide_slow:
-
-; The exponents are not the same, so do it the hard way.
-
-call_with_two_parameters dec64_divide
-mov     r1,r0
-tail_with_one_parameter dec64_floor
-
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_modulo: function_with_two_parameters
-;(dividend: dec64, divisor: dec64) returns modulus: dec64
-
-; Modulo. It produces the same result as
-;    dec64_subtract(
-;        dividend,
-;        dec64_multiply(
-;            dec64_integer_divide(dividend, divisor),
-;            divisor
-;        )
-;    )
-
-cmp     r1_b,r2_b       ; are the two exponents the same?
-jnz     modulo_slow     ; %if not take the slow path
-        mov     r0,r1           ; r0 is the dividend
-mov     r11,r2          ; r11 is the divisor
-cmp     r1_b,128        ; is the first operand nan?
-setne   r2_h            ; r2_h is 1 %if the operands are not nan
-        sar     r0,8            ; r0 is the dividend coefficient
-        setz    r2_b            ; r2_b is 1 %if the dividend coefficient is zero
-        test    r2_b,r2_h       ; is the dividend is zero and not nan?
-jnz     return_zero     ; the quotient is zero %if the dividend is zero
-sar     r11,8           ; r11 is the divisor coefficient
-        setnz   r2_b            ; r2_b is 1 %if the divisor coefficient is not zero
-test    r2_h,r2_b       ; is either operand nan or is the divisor zero?
-jz      return_nan
-cqo                     ; sign extend r0 into r2
-        idiv    r11             ; divide r2:r0 by the divisor
-
-; %if the signs of the divisor and remainder are d%ifferent and the remainder is
-; not zero, add the divisor to the remainder.
-
-xor     r0,r0           ; r0 is zero
-        mov     r10,r2          ; r10 is the remainder
-test    r2,r2           ; examine the remainder
-        cmovz   r11,r0          ; r11 is zero %if the remainder is zero
-xor     r10,r11         ; r10 is remainder xor divisor
-        cmovs   r0,r11          ; r0 is the divisor %if the signs were d%ifferent
-        add     r0,r2           ; r0 is the corrected result
-        cmovz   r1,r0           ; %if r0 is zero, so is the exponent
-shl     r0,8            ; position the coefficient
-        mov     r0_b,r1_b       ; mix in the exponent
-ret
-        pad
-
-modulo_slow:
-
-; The exponents are not the same, so do it the hard way.
-
-push    r1              ; save the dividend
-        push    r2              ; save the divisor
-
-        call_with_two_parameters dec64_integer_divide
-        pop     r2
-        mov     r1,r0
-        call_with_two_parameters dec64_multiply
-        pop     r1
-        mov     r2,r0
-        tail_with_two_parameters dec64_subtract
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_half: function_with_one_parameter
-;(dividend: dec64) returns quotient: dec64
-
-; Divide a dec64 number by two. This will always be faster than dec64_divide.
-
-cmp     r1_b,128
-je      return_nan
-test    r1_h,1
-jz      half_fast
-
-; Unpack the components into r8 and r1, multiply by 5 and divide by 10.
-
-movsx   r8,r1_b         ; r8 is the exponent
-sar     r1,8            ; r1 is the coefficient
-sub     r8,1            ; bump down the exponent
-lea     r0,[r1+r1*4]    ; r0 is the coefficient * 5
-jmp     pack
-pad
-
-        half_fast:
-
-; %if the least sign%ificant bit of the coefficient is 0, then we can do this
-; the fast way. Sh%ift the coefficient by 1 bit and restore the exponent. %if
-; the sh%ift produces zero, even easier.
-
-mov     r0,-256         ; r0 is the coefficient mask
-        and     r0,r1           ; r0 is the coefficient sh%ifted 8 bits
-        jz      return
-sar     r0,1            ; r0 is divided by 2
-movzx   r1,r1_b         ; zero out r1 except lowest 8 bits
-        or      r0,r1           ; mix in the exponent
-ret
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_signum: function_with_one_parameter
-;(number: dec64) returns signature: dec64
-
-; %if the number is nan, the result is nan.
-; %if the number is less than zero, the result is -1.
-; %if the number is zero, the result is 0.
-; %if the number is greater than zero, the result is 1.
-
-mov     r0,r1           ; r0 is the number
-sar     r0,8            ; r0 is the coefficient
-mov     r8,r0           ; r8 is the coefficient too
-        neg     r0              ; r0 is -coefficient
-        sar     r8,63           ; r8 is the extended sign (-1 %if negative else 0)
-shr     r0,63           ; r0 is 1 %if the number was greater than 0
-mov     r2,128          ; r2 is nan
-        or      r0,r8           ; r0 is -1, 0, or 1
-shl     r0,8            ; package the number with a zero exponent
-        cmp     r1_b,r2_b       ; is the number nan?
-cmove   r0,r2           ; %if so, replace the answer
-        ret
-
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_not: function_with_one_parameter
-;(boolean: dec64) returns notation: dec64
-
-; %if the number is 1, the result is 0.
-; %if the number is 0, the result is 1.
-; Otherwise, the result is nan.
-
-test    r1_b,r1_b
-jnz     not_hard
-test    r1,r1
-jz      return_one
-cmp     r1,100h
-je      return_zero
-jmp     return_nan
-pad
-
-        not_hard:
-
-cmp     r1_b,80h
-je      return_nan
-call_with_one_parameter dec64_normal
-test    r0_b,r0_b
-jnz     return_nan
-test    r0,r0
-jz      return_one
-cmp     r0,100h
-je      return_zero
-jmp     return_nan
-
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_neg: function_with_one_parameter
-;(number: dec64) returns negation: dec64
-
-; Negate a number. We need to negate the coefficient without changing the
-; exponent.
-
-cmp     r1_b,128        ; compare the exponent to nan
-        je      return_nan      ; is the number nan?
-mov     r2,r1           ; r2 is the number
-mov     r0,-256         ; r0 is the coefficient mask
-        sar     r2,8            ; r2 is the coefficient
-cmovz   r1,r2           ; %if the coefficient is zero, then the exponent too
-        xor     r0,r1           ; r0 has the exponent and complemented coefficient
-        add     r0,256          ; r0 has the exponent and negated coefficient
-        jo      neg_overflow    ; nice day %if it don't overflow
-ret
-
-        neg_overflow:
-
-; The coefficient is -36028797018963968, which is the only coefficient that
-; cannot be trivially negated. So we do this the hard way.
-
-mov     r0,r2
-movsx   r8,r1_b         ; r8 is the exponent
-neg     r0
-jmp     pack
-
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_abs: function_with_one_parameter
-;(number: dec64) returns absolution: dec64
-
-; Find the absolute value of a number. %if the number is negative, hand it off
-; to dec64_neg. Otherwise, return the number unless it is nan or zero.
-
-test    r1,r1           ; examine r1
-js      dec64_neg       ; is the number negative?
-mov     r10,r1          ; r10 is the number
-mov     r0,r1           ; r0 is the number
-mov     r2,128          ; r2 is nan
-        and     r10,-256        ; r10 is the coefficient without an exponent
-        cmovz   r0,r10          ; %if the coefficient is zero, the number is zero
-        cmp     r1_b,r2_b       ; compare r1 to nan
-cmovz   r0,r2           ; is the number nan?
-ret                     ; return the number
-
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_equal: function_with_two_parameters
-;(comparahend: dec64, comparator: dec64) returns comparison: dec64
-
-; Compare two dec64 numbers. %if they are equal, return 1, otherwise return 0.
-; Denormal zeroes are equal but denormal nans are not.
-
-; %if the numbers are trivally equal, then return 1.
-
-cmp     r1,r2           ; compare the two numbers
-je      return_one
-
-; %if the exponents match or %if their signs are d%ifferent, then return false.
-
-mov     r0,r1           ; r0 is the first number
-        xor     r0,r2           ; r0 the xor of the two numbers
-        sets    r0_h            ; r0_h is 1 %if the signs are d%ifferent
-        cmp     r1_b,r2_b       ; compare the two exponents
-sete    r0_b            ; r0_b is 1 %if the exponents are the same
-        or      r0_b,r0_h
-        jnz     return_zero
-
-; Do it the hard way by subtraction. Is the d%ifference zero?
-
-call_with_two_parameters dec64_subtract ; r0 is r1 - r2
-        cmp     r0_b,128        ; is the d%ifference nan?
-je      return_zero
-or      r0,r0           ; examine the d%ifference
-        setz    r0_b            ; r0 is 1 %if the numbers are equal
-movzx   r0,r0_b
-shl     r0,8
-ret
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_less: function_with_two_parameters
-;(comparahend: dec64, comparator: dec64) returns comparison: dec64
-
-; Compare two dec64 numbers. %if either argument is any nan, then the result is
-; nan. %if the first is less than the second, return 1, otherwise return 0.
-
-; The other 3 comparison functions are easily implemented with dec64_less:
-
-;    dec64_greater(a, b)          => dec64_less(b, a)
-;    dec64_greater_or_equal(a, b) => dec64_not(dec64_less(a, b))
-;    dec64_less_or_equal(a, b)    => dec64_not(dec64_less(b, a))
-
-cmp     r1_b,128        ; is the first argument nan?
-setne   r8_b            ; r8_b is 1 %if first is not nan
-cmp     r2_b,128        ; is the second argument nan?
-setne   r9_b            ; r9_b is 1 %if second is not nan
-test    r8_b,r9_b       ; is either nan?
-jz      return_nan
-
-; %if the exponents are the same, or the coefficient signs are d%ifferent, then
-; do a simple compare.
-
-mov     r10,r1          ; r10 is the first number
-        cmp     r1_b,r2_b       ; are the two exponents equal?
-setne   r8_b            ; r8_b is 0 %if the exponents are equal
-xor     r10,r2          ; r10 is the two numbers xor together
-        setns   r10_b           ; r10_b is 0 %if the sign bits were d%ifferent
-        test    r10_b,r8_b      ; exponents equal or sign bits d%ifferent
-        jnz     less_slow       ; do it another way
-        cmp     r1,r2           ; compare the numbers
-        setl    r0_b            ; r0_b is 1 %if the first number is less
-        movzx   r0,r0_b         ; r0 is 1 %if the first number is less
-        shl     r0,8            ; that bit distinguishes true from false
-ret
-        pad
-
-less_slow:
-
-; Do it the hard way with a subtraction.
-
-call_with_two_parameters dec64_subtract ; r0 is r1 - r2
-        cmp     r0_b,128        ; is the d%ifference nan?
-je      return_nan
-shr     r0,63           ; r0 is 1 %if the first number is less
-        shl     r0,8            ; that bit distinguishes true from false
-ret
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_is_integer: function_with_one_parameter
-;(number: dec64) returns comparison: dec64
-
-; %if the number contains a non-zero fractional part or %if it is nan, return
-; false. Otherwise, return true.
-
-cmp     r1_b,128        ; nan exponent?
-je      return_zero     ; nan is not an integer
-        mov     r0,r1           ; r0 is the number
-sar     r0,8            ; r0 is the coefficient
-cmovz   r1,r0           ; %if the coefficient is zero, so is the exponent
-        movsx   r8,r1_b         ; r8 is the exponent
-test    r1_b,r1_b       ; examine the exponent
-        jns     return_one
-        neg     r8              ; negate the exponent
-        cmp     r8_b,17         ; extreme negative exponents can never be integer
-        jae     return_zero
-        mov     r9,power
-        mov     r10,[r9+r8*8]  ; r10 is 10^-exponent
-        cqo                     ; sign extend r0 into r2
-        idiv    r10             ; divide r2:r0 by the power of ten
-xor     r0,r0           ; r0 is zero
-        test    r2,r2           ; examine the remainder
-        setz    r0_b            ; %if the remainder is zero, then return one
-        movzx   r0,r0_b
-        shl     r0,8
-ret
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_is_any_nan: function_with_one_parameter
-;(number: dec64) returns comparison: dec64
-
-        cmp     r1_b,128        ; is r1 nan?
-sete    r0_b            ; r0 is 1 %if r1 is nan
-        movzx   r0,r0_b
-        shl     r0,8
-ret
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_is_zero: function_with_one_parameter
-;(number: dec64) returns comparison: dec64
-
-        xor     r0,r0           ; r0 is zero
-        test    r1,-256         ; coefficient mask
-setz    r0_b            ; r0 is one %if the coefficient is zero
-cmp     r1_b,128        ; is the number nan?
-setnz   r0_h            ; r0_h is 1 %if the number is not nan
-        and     r0_b,r0_h       ; r0 is one %if the coefficient is zero and not nan
-        movzx   r0,r0_b
-        shl     r0,8
-ret
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_int: function_with_one_parameter
-;(number: dec64) returns integer: dec64
-
-; Convert the number such that the exponent will be zero, discarding the
-; fraction part. It will produce nan %if the result cannot be represented in
-; 56 signed bits. This is used to extract an int56 from a dec64 for bitwise
-; operations. It accepts a broader range than the safe integer range:
-; -36028797018963968 thru 72057594037927935.
-
-; Preserved: r11
-
-        mov     r0,r1           ; r0 is the number
-test    r1_b,r1_b       ; examine the exponent
-        jz      return          ; nothing to do it the exponent is zero
-        js      dec64_floor     ; shed the fraction part %if exponent is negative
-        movzx   r8,r1_b         ; r8 is the exponent
-mov     r2,18           ; r2 is 18
-cmp     r1_b,18         ; is the exponent too enormous?
-cmovae  r8,r2           ; r8 is min(exponent, 18)
-and     r0,-256         ; r0 is the coefficient, sh%ifted 8
-mov     r9,power
-mov     r10,[r9+r8*8]  ; r10 is 10^exponent
-        imul    r10             ; r0 is coefficient * 10^exponent
-        sar     r2,1            ; sh%ift the lsb of the overflow into carry
-adc     r2,0            ; %if r2 was 0 or -1, it is now 0
-jnz     return_nan      ; was the coefficient too enormous?
-ret
-
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
-
-dec64_normal: function_with_one_parameter
-;(number: dec64) returns normalization: dec64
-
-; Make the exponent as close to zero as possible without losing any signficance.
-; Usually normalization is not needed since it does not materially change the
-; value of a number.
-
-mov     r0,r1           ; r0 is the number
-cmp     r1_b,128        ; compare the exponent to nan
-        jz      return_nan      ; %if exponent is nan, the result is nan
-and     r0,-256         ; r0 is the coefficient sh%ifted 8 bits
-        mov     r8,10           ; r8 is the divisor
-cmovz   r1,r0           ; r1 is zero %if r0 is zero
-        mov     r10,r0          ; r10 is the coefficient sh%ifted 8 bits
-        test    r1_b,r1_b       ; examine the exponent
-        jz      return          ; %if the exponent is zero, return r0
-        jns     normal_multiply ; %if the exponent is positive
-sar     r0,8            ; r0 is the coefficient
-sar     r10,8           ; r10 is the coefficient
-pad
-
-        normal_divide:
-
-; While the exponent is less than zero, divide the coefficient by 10 and
-; increment the exponent.
-
-cqo                     ; sign extend r0 into r2
-        idiv    r8              ; divide r2:r0 by 10
-test    r2,r2           ; examine the remainder
-        jnz     normal_divide_done ; %if r2 is not zero, we are done
-mov     r10,r0          ; r10 is the coefficient
-add     r1_b,1          ; increment the exponent
-        jnz     normal_divide   ; until the exponent is zero
-        pad
+int64 dec64_half(int64 dividend)
+{
+    if (IS_NAN(dividend))
+        return DEC64_NAN;
 
-normal_divide_done:
+    //An even coefficient is shifted in place
+    if (((dividend >> 8) & 1) == 0)
+    {
+        int64 shifted = dividend & ~0xFFLL;
+        if (shifted == 0)
+            return DEC64_ZERO;
+        return (shifted >> 1) | (dividend & 0xFF);
+    }
 
-mov     r0,r10          ; r0 is the finished coefficient
-        shl     r0,8            ; put it in position
-mov     r0_b,r1_b       ; mix in the exponent
-ret
-        pad
+    //An odd one is multiplied by 5 and divided by 10
+    return dec64_pack((dividend >> 8) * 5, (int8_t) dividend - 1);
+}
 
-normal_multiply:
+int64 dec64_int(int64 number)
+{
+    int64 exp = (int8_t) number;
 
-; While the exponent is greater than zero, multiply the coefficient by 10 and
-; decrement the exponent. %if the coefficient gets too large, wrap it up.
+    if (exp == 0)
+        return number;
 
-imul    r0,10           ; r0 is r0 * 10
-jo      normal_multiply_done ; return zero %if overflow
-        mov     r10,r0          ; r10 is the coefficient
-sub     r1_b,1          ; decrement the exponent
-        jnz     normal_multiply ; until the exponent is zero
-        ret
-pad
+    //Shed the fraction part if the exponent is negative (nan included)
+    if (exp < 0)
+        return dec64_floor(number);
 
-        normal_multiply_done:
+    //The result is nan if it doesn't fit in 64 bits, so 56 bit coefficients up to 72057594037927935 are accepted
+    if (exp > 18)
+        exp = 18;
+    int128 product = (int128) (number & ~0xFFLL) * (int64) powers10[exp];
+    int64 high = (int64) (product >> 64);
+    if (high != 0 && high != -1)
+        return DEC64_NAN;
+    return (int64) product;
+}
 
-mov     r0,r10          ; r0 is the finished positioned coefficient
-mov     r0_b,r1_b       ; mix in the exponent
-ret
+int64 dec64_normal(int64 number)
+{
+    if (IS_NAN(number))
+        return DEC64_NAN;
 
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
+    int64 shifted = number & ~0xFFLL;
+    int64 exp = (int8_t) number;
+    if (shifted == 0)
+        return DEC64_ZERO;
+    if (exp == 0)
+        return number;
 
-return:
+    //While the exponent is positive, multiply by 10 until the coefficient would overflow
+    if (exp > 0)
+    {
+        while (exp > 0)
+        {
+            int64 tshifted;
+            if (__builtin_mul_overflow(shifted, (int64) 10, &tshifted))
+                return shifted | (exp & 0xFF);
+            shifted = tshifted;
+            exp--;
+        }
+        return shifted;
+    }
 
-; Return whatever is in r0.
+    //While the exponent is negative, divide by 10 as long as nothing is lost
+    int64 coeff = number >> 8;
+    while (exp < 0 && coeff % 10 == 0)
+    {
+        coeff /= 10;
+        exp++;
+    }
+    return dec64_build(coeff, exp);
+}
 
-ret
+int64 dec64_not(int64 boolean)
+{
+    //Fast path for normal zero and one
+    if ((int8_t) boolean == 0)
+        return boolean == DEC64_ZERO ? DEC64_ONE : boolean == DEC64_ONE ? DEC64_ZERO : DEC64_NAN;
 
-        pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
+    if (IS_NAN(boolean))
+        return DEC64_NAN;
 
-return_nan:
+    int64 normal = dec64_normal(boolean);
+    if ((int8_t) normal != 0)
+        return DEC64_NAN;
+    return normal == DEC64_ZERO ? DEC64_ONE : normal == DEC64_ONE ? DEC64_ZERO : DEC64_NAN;
+}
 
-; All of the dec64_ functions return only this form of nan.
+//-1, 0 or 1 as comparahend is less than, equal to or greater than comparator, neither
+// of which is nan. The magnitude with the larger exponent is scaled up to 18 digits
+// at most, which is more than any coefficient has, so unlike a subtraction this
+// cannot round away or overflow
+static int dec64_compare_proc(int64 comparahend, int64 comparator)
+{
+    int64 coeff1 = comparahend >> 8;
+    int64 coeff2 = comparator >> 8;
+    int64 exp1 = (int8_t) comparahend;
+    int64 exp2 = (int8_t) comparator;
+
+    //Different signs or a zero decide it without the exponents
+    if ((coeff1 < 0) != (coeff2 < 0) || coeff1 == 0 || coeff2 == 0)
+        return (coeff1 > coeff2) - (coeff1 < coeff2);
+
+    //Compare the magnitudes, and turn the answer around for negative numbers
+    int sign = coeff1 < 0 ? -1 : 1;
+    uint64 abs1 = coeff1 < 0 ? 0 - (uint64) coeff1 : (uint64) coeff1;
+    uint64 abs2 = coeff2 < 0 ? 0 - (uint64) coeff2 : (uint64) coeff2;
+    if (exp1 < exp2)
+    {
+        uint64 temp = abs1;
+        abs1 = abs2;
+        abs2 = temp;
+        int64 exp = exp1;
+        exp1 = exp2;
+        exp2 = exp;
+        sign = -sign;
+    }
+    int64 shift = exp1 - exp2;
+    if (shift > 18 - dec64_digits((int64) abs1))
+        return sign;
+    abs1 *= powers10[shift];
+    return abs1 > abs2 ? sign : abs1 < abs2 ? -sign : 0;
+}
 
-mov     r0,128          ; nan
-        ret
+int64 dec64_is_equal(int64 comparahend, int64 comparator)
+{
+    //If the numbers are trivially equal, then return 1
+    if (comparahend == comparator)
+        return DEC64_ONE;
 
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
+    //If the exponents match or if their signs are different, then return 0
+    if ((comparahend ^ comparator) < 0 || (int8_t) comparahend == (int8_t) comparator)
+        return DEC64_ZERO;
 
-return_one:
+    //Do it the hard way by aligning the coefficients
+    if (IS_NAN(comparahend) || IS_NAN(comparator))
+        return DEC64_ZERO;
+    return dec64_compare_proc(comparahend, comparator) == 0 ? DEC64_ONE : DEC64_ZERO;
+}
 
-mov     r0,256          ; one
-        ret
+int64 dec64_is_less(int64 comparahend, int64 comparator)
+{
+    if (IS_NAN(comparahend) || IS_NAN(comparator))
+        return DEC64_NAN;
 
-pad; -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
+    //If the exponents are the same, or the signs are different, then do a simple compare
+    if ((int8_t) comparahend == (int8_t) comparator || (comparahend ^ comparator) < 0)
+        return comparahend < comparator ? DEC64_ONE : DEC64_ZERO;
 
-return_zero:
+    //Do it the hard way by aligning the coefficients
+    return dec64_compare_proc(comparahend, comparator) < 0 ? DEC64_ONE : DEC64_ZERO;
+}
 
-xor     r0,r0           ; zero
-        ret
+int64 dec64_multiply(int64 multiplicand, int64 multiplier)
+{
+    int nan1 = IS_NAN(multiplicand);
+    int nan2 = IS_NAN(multiplier);
+    int64 coeff1 = multiplicand >> 8;
+    int64 coeff2 = multiplier >> 8;
+
+    //The result is nan if one or both of the operands is nan and neither of the operands is zero
+    if ((nan1 && (coeff2 != 0 || nan2)) || (nan2 && (coeff1 != 0 || nan1)))
+        return DEC64_NAN;
+
+    int64 exp = (int64) (int8_t) multiplicand + (int8_t) multiplier;
+    int128 product = (int128) coeff1 * coeff2;
+
+    //If the product fits in 64 bits, start packing
+    if (product == (int64) product)
+        return product == 0 ? DEC64_ZERO : dec64_pack((int64) product, exp);
+
+    //Otherwise estimate the number of digits of excess from the high word
+    //77/256 converts log2 to log10, plus two extra digits to the scale
+    int64 high = (int64) (product >> 64);
+    uint64 abs_high = high < 0 ? 0 - (uint64) high : (uint64) high;
+    int64 scale = (((63 - leading_zeros(abs_high | 1)) * 77) >> 8) + 2;
+    return dec64_pack((int64) (product / (int64) powers10[scale]), exp + scale);
+}
+
+int64 dec64_divide(int64 dividend, int64 divisor)
+{
+    int nan1 = IS_NAN(dividend);
+    int nan2 = IS_NAN(divisor);
+    int64 coeff1 = dividend >> 8;
+    int64 coeff2 = divisor >> 8;
 
+    //If the dividend is zero, the quotient is zero
+    if (coeff1 == 0 && !nan1)
+        return DEC64_ZERO;
+
+    //If either is nan or the divisor is zero, the quotient is nan
+    if (nan1 || nan2 || coeff2 == 0)
+        return DEC64_NAN;
+
+    int64 exp = (int64) (int8_t) dividend - (int8_t) divisor;
+    int bits2 = 63 - leading_zeros(coeff2 < 0 ? 0 - (uint64) coeff2 : (uint64) coeff2);
+    while (1)
+    {
+        //Scale the dividend to be approximately 58 bits longer than the divisor
+        int bits1 = 63 - leading_zeros(coeff1 < 0 ? 0 - (uint64) coeff1 : (uint64) coeff1);
+        int scale = ((bits2 + 58 - bits1) * 77) >> 8;
+
+        //The largest power of 10 that can be held in an int64 is 1e18, so prescale the dividend
+        if (scale > 18)
+        {
+            scale = ((58 - bits1) * 77) >> 8;
+            coeff1 *= (int64) powers10[scale];
+            exp -= scale;
+            continue;
+        }
+
+        int128 quotient = (int128) coeff1 * (int64) powers10[scale] / coeff2;
+        return dec64_pack((int64) quotient, exp - scale);
+    }
+}
+
+int64 dec64_integer_divide(int64 dividend, int64 divisor)
+{
+    //If the exponents are equal, the quotient of the shifted dividend and the coefficient of the
+    // divisor is floored by masking off the exponent
+    if ((int8_t) dividend == (int8_t) divisor)
+    {
+        int nan = IS_NAN(dividend);
+        int64 coeff2 = divisor >> 8;
+        if ((dividend >> 8) == 0 && !nan)
+            return DEC64_ZERO;
+        if (nan || coeff2 == 0)
+            return DEC64_NAN;
+        //Dividing by -1 could overflow
+        if (coeff2 != -1)
+            return ((dividend & ~0xFFLL) / coeff2) & ~0xFFLL;
+    }
+
+    //The exponents are not the same, so do it the hard way
+    return dec64_floor(dec64_divide(dividend, divisor));
+}
+
+int64 dec64_modulo(int64 dividend, int64 divisor)
+{
+    if ((int8_t) dividend == (int8_t) divisor)
+    {
+        int nan = IS_NAN(dividend);
+        int64 coeff1 = dividend >> 8;
+        int64 coeff2 = divisor >> 8;
+        if (coeff1 == 0 && !nan)
+            return DEC64_ZERO;
+        if (nan || coeff2 == 0)
+            return DEC64_NAN;
+
+        //The remainder takes the sign of the divisor
+        int64 remainder = coeff1 % coeff2;
+        if (remainder != 0 && (remainder ^ coeff2) < 0)
+            remainder += coeff2;
+        if (remainder == 0)
+            return DEC64_ZERO;
+        return dec64_build(remainder, (int8_t) dividend);
+    }
+
+    //The exponents are not the same, so do it the hard way
+    return dec64_subtract(dividend, dec64_multiply(dec64_integer_divide(dividend, divisor), divisor));
+}
+
+int64 dec64_round(int64 number, int64 place)
+{
+    int64 integer_place = dec64_int(place);
+    if (IS_NAN(number) || IS_NAN(integer_place))
+        return DEC64_NAN;
+
+    int64 target = integer_place >> 8;
+    int64 exp = (int8_t) number;
+    int64 coeff = number >> 8;
+    if (coeff == 0)
+        return DEC64_ZERO;
+
+    //No rounding required
+    if (exp >= target)
+        return dec64_pack(coeff, exp);
+
+    //Add half of the power of 10 and divide by it with one multiply, which rounds
+    // half away from zero on the first dropped digit
+    //A coefficient has at most 17 digits, so farther targets are just zero
+    if (target - exp > 19)
+        return DEC64_ZERO;
+    uint64 abs = coeff < 0 ? 0 - (uint64) coeff : (uint64) coeff;
+    abs = divide_power10(abs + powers10[target - exp] / 2, target - exp);
+    if (abs == 0)
+        return DEC64_ZERO;
+    return dec64_pack(coeff < 0 ? -(int64) abs : (int64) abs, target);
+}
 
-*/
\ No newline at end of file
+#endif //DEC64_BACKEND_C
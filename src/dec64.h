@@ -32,6 +32,7 @@ typedef int64 dec64;
 
 extern int64 dec64_coefficient(dec64 number)                /*   coefficient */;
 extern int64 dec64_exponent(dec64 number)                   /*      exponent */;
+extern int64 dec64_digits(int64 coefficient)                /*  digit count */;
 
 extern dec64 dec64_is_equal(dec64 comparahend, dec64 comparator)/*comparison */;
 extern dec64 dec64_is_false(dec64 boolean)                  /*    comparison */;
@@ -45,6 +46,8 @@ extern dec64 dec64_ceiling(dec64 number)                    /*       integer */;
 extern dec64 dec64_dec(dec64 minuend)                          /* difference */;
 extern dec64 dec64_divide(dec64 dividend, dec64 divisor)    /*      quotient */;
 extern dec64 dec64_floor(dec64 dividend)                    /*       integer */;
+extern dec64 dec64_fma(dec64 multiplicand, dec64 multiplier, dec64 addend)
+                                                            /* product + sum */;
 extern dec64 dec64_half(dec64 dividend)                          /* quotient */;
 extern dec64 dec64_inc(dec64 augend)                                  /* sum */;
 extern dec64 dec64_int(dec64 number)                              /* integer */;
@@ -62,52 +65,121 @@ extern dec64 dec64_subtract(dec64 minuend, dec64 subtrahend)/*    difference */;
 
 #ifdef __cplusplus
 }
-#include <iostream>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "dec64_constexpr.h"
+
+//The constexpr port is only needed while a Dec64 is computed at compile time. At run time the
+// operators call the functions above, so they use the backend the library was built with.
+// Where that can't be told, the port is used all the time; it gives the same words
+#if defined(__cpp_lib_is_constant_evaluated)
+#define DEC64_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define DEC64_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(DEC64_CONSTANT_EVALUATED) && defined(__GNUC__) && __GNUC__ >= 9
+#define DEC64_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#ifndef DEC64_CONSTANT_EVALUATED
+#define DEC64_CONSTANT_EVALUATED() true
+#endif
 
+namespace dec64_select {
+    constexpr dec64 dec64_new(int64 coefficient, int64 exponent) {
+        return DEC64_CONSTANT_EVALUATED() ? dec64_constexpr::dec64_new(coefficient, exponent) : ::dec64_new(coefficient, exponent);
+    }
+    constexpr dec64 dec64_add(dec64 augend, dec64 addend) {
+        return DEC64_CONSTANT_EVALUATED() ? dec64_constexpr::dec64_add(augend, addend) : ::dec64_add(augend, addend);
+    }
+    constexpr dec64 dec64_subtract(dec64 minuend, dec64 subtrahend) {
+        return DEC64_CONSTANT_EVALUATED() ? dec64_constexpr::dec64_subtract(minuend, subtrahend) : ::dec64_subtract(minuend, subtrahend);
+    }
+    constexpr dec64 dec64_multiply(dec64 multiplicand, dec64 multiplier) {
+        return DEC64_CONSTANT_EVALUATED() ? dec64_constexpr::dec64_multiply(multiplicand, multiplier) : ::dec64_multiply(multiplicand, multiplier);
+    }
+    constexpr dec64 dec64_divide(dec64 dividend, dec64 divisor) {
+        return DEC64_CONSTANT_EVALUATED() ? dec64_constexpr::dec64_divide(dividend, divisor) : ::dec64_divide(dividend, divisor);
+    }
+    constexpr dec64 dec64_is_equal(dec64 comparahend, dec64 comparator) {
+        return DEC64_CONSTANT_EVALUATED() ? dec64_constexpr::dec64_is_equal(comparahend, comparator) : ::dec64_is_equal(comparahend, comparator);
+    }
+    constexpr dec64 dec64_is_less(dec64 comparahend, dec64 comparator) {
+        return DEC64_CONSTANT_EVALUATED() ? dec64_constexpr::dec64_is_less(comparahend, comparator) : ::dec64_is_less(comparahend, comparator);
+    }
+    constexpr dec64 dec64_normal(dec64 number) {
+        return DEC64_CONSTANT_EVALUATED() ? dec64_constexpr::dec64_normal(number) : ::dec64_normal(number);
+    }
+}
+
+//The tag for making a Dec64 from a dec64 word as it is, without packing it: Dec64(dec64_raw, word)
+struct dec64_raw_t { explicit constexpr dec64_raw_t() {} };
+constexpr dec64_raw_t dec64_raw{};
+
+//A Dec64 is just its dec64 word: it is trivially copyable and standard layout, and every
+// member is inline, so arrays of Dec64 can be copied and looped over like arrays of int64
+//Construction and the arithmetic, comparison and normal operators are constexpr,
+// using the C++ port in dec64_constexpr.h at compile time, so Dec64 constants are folded
 class Dec64{
     public:
-        Dec64(const int64 coefficient = 0, const int64 exponent=0, const bool copy=false);
-        Dec64(std::string);
-
-
-        ~Dec64();
-
-        Dec64 set_val(const dec64 val);
-        Dec64 coefficient() const ;
-        Dec64 exponent() const ;
-        int64 coefficient_to_int() const ;
-        int64 exponent_to_int() const ;
-        Dec64 abs() const ;
-        Dec64 ceil() const ;
-        Dec64 floor() const ;
-        Dec64 round(Dec64 places) const ;
-        Dec64 half() const ;
-        Dec64 neg() const ;
-        int64 to_int() const ;
-        Dec64 integer_divide(const Dec64 &a) const ;
-        bool  is_zero() const ;
-        bool  is_nan() const ;
-        bool  is_integer() const ;
-        Dec64 signum() const ;
-        Dec64 normal() const ;
-
-
-
-        Dec64 operator!() const ;
-        Dec64 operator+(const Dec64& a) const ;
-        Dec64 operator++() const ;
-        Dec64 operator-(const Dec64& a) const ;
-        Dec64 operator--() const ;
-        Dec64 operator*(const Dec64& a) const ;
-        Dec64 operator/(const Dec64& a) const ;
-        Dec64 operator%(const Dec64& a) const ;
+        constexpr Dec64(const int64 coefficient = 0, const int64 exponent=0)
+            : value(dec64_select::dec64_new(coefficient, exponent)) {}
+        explicit constexpr Dec64(dec64_raw_t, const dec64 word) : value(word) {}
+        Dec64(const std::string& text) : Dec64(parse(text)) {}
+
+        //Parse all of text as a number, like -12.5, 1e-3 or nan, without allocating. If it
+        // is not a number, the result is nan and *error is the position where it went wrong,
+        // and otherwise *error is std::string_view::npos
+        //An exponent may have a fraction, like 25e0.5, as the string constructor always
+        // allowed; that one case is not exact, and keeps six decimal places
+        static Dec64 parse(std::string_view text, std::size_t* error = nullptr);
+
+        Dec64 set_val(const dec64 val) { value = val; return *this; }
+        Dec64 coefficient() const { return Dec64(dec64_raw, dec64_coefficient(value)); }
+        Dec64 exponent() const { return Dec64(dec64_raw, dec64_exponent(value)); }
+        constexpr int64 coefficient_to_int() const { return dec64_constexpr::dec64_coefficient(value); }
+        constexpr int64 exponent_to_int() const { return dec64_constexpr::dec64_exponent(value); }
+        Dec64 abs() const { return Dec64(dec64_raw, dec64_abs(value)); }
+        Dec64 ceil() const { return Dec64(dec64_raw, dec64_ceiling(value)); }
+        Dec64 floor() const { return Dec64(dec64_raw, dec64_floor(value)); }
+        Dec64 fma(const Dec64 &multiplier, const Dec64 &addend) const { return Dec64(dec64_raw, dec64_fma(value, multiplier.value, addend.value)); }
+        Dec64 round(Dec64 places) const { return Dec64(dec64_raw, dec64_round(value, places.value)); }
+        Dec64 half() const { return Dec64(dec64_raw, dec64_half(value)); }
+        Dec64 neg() const { return Dec64(dec64_raw, dec64_neg(value)); }
+        int64 to_int() const { return dec64_int(value); }
+        Dec64 integer_divide(const Dec64 &a) const { return Dec64(dec64_raw, dec64_integer_divide(value, a.value)); }
+        bool  is_zero() const { return dec64_is_zero(value) == DEC64_ONE; }
+        bool  is_nan() const { return dec64_is_nan(value) == DEC64_ONE; }
+        bool  is_integer() const { return dec64_is_integer(value) == DEC64_ONE; }
+        Dec64 signum() const { return Dec64(dec64_raw, dec64_signum(value)); }
+        constexpr Dec64 normal() const { return Dec64(dec64_raw, dec64_select::dec64_normal(value)); }
+
+
+
+        Dec64 operator!() const { return Dec64(dec64_raw, dec64_not(value)); }
+        constexpr Dec64 operator+(const Dec64& a) const { return Dec64(dec64_raw, dec64_select::dec64_add(value, a.value)); }
+        Dec64 operator++() const { return Dec64(dec64_raw, dec64_inc(value)); }
+        constexpr Dec64 operator-(const Dec64& a) const { return Dec64(dec64_raw, dec64_select::dec64_subtract(value, a.value)); }
+        Dec64 operator--() const { return Dec64(dec64_raw, dec64_dec(value)); }
+        constexpr Dec64 operator*(const Dec64& a) const { return Dec64(dec64_raw, dec64_select::dec64_multiply(value, a.value)); }
+        constexpr Dec64 operator/(const Dec64& a) const { return Dec64(dec64_raw, dec64_select::dec64_divide(value, a.value)); }
+        Dec64 operator%(const Dec64& a) const { return Dec64(dec64_raw, dec64_modulo(value, a.value)); }
         //bool  operator<(const Dec64& a) const ;
-        Dec64 operator<(const Dec64 &a) const ;
-        bool  operator>(const Dec64& a) const ;
-        bool  operator==(const Dec64& a) const ;
-        bool  operator!=(const Dec64& a) const ;
-        bool  operator<=(const Dec64& a) const ;
-        bool  operator>=(const Dec64& a) const ;
+        constexpr Dec64 operator<(const Dec64 &a) const { return Dec64(dec64_raw, dec64_select::dec64_is_less(value, a.value)); }
+        constexpr bool  operator>(const Dec64& a) const { return dec64_select::dec64_is_less(a.value, value) == DEC64_ONE; }
+        constexpr bool  operator==(const Dec64& a) const { return dec64_select::dec64_is_equal(value, a.value) == DEC64_ONE; }
+        constexpr bool  operator!=(const Dec64& a) const { return dec64_select::dec64_is_equal(value, a.value) == DEC64_ZERO; }
+        constexpr bool  operator<=(const Dec64& a) const { return *this == a; }// *this<a ||
+        constexpr bool  operator>=(const Dec64& a) const { return *this > a || *this == a; }
+
+        constexpr Dec64& operator+=(const Dec64& a) { value = dec64_select::dec64_add(value, a.value); return *this; }
+        constexpr Dec64& operator-=(const Dec64& a) { value = dec64_select::dec64_subtract(value, a.value); return *this; }
+        constexpr Dec64& operator*=(const Dec64& a) { value = dec64_select::dec64_multiply(value, a.value); return *this; }
+        constexpr Dec64& operator/=(const Dec64& a) { value = dec64_select::dec64_divide(value, a.value); return *this; }
 
         friend std::ostream& operator<<(std::ostream& os, const Dec64& a);
 
@@ -115,6 +187,10 @@ class Dec64{
 
         dec64 value;
 };
+
+static_assert(sizeof(Dec64) == 8, "a Dec64 is one dec64 word");
+static_assert(std::is_trivially_copyable<Dec64>::value, "a Dec64 can be copied with memcpy");
+static_assert(std::is_standard_layout<Dec64>::value, "a Dec64 has the layout of a dec64");
 #endif //__cplusplus
 
 #endif //DEC64
\ No newline at end of file
@@ -0,0 +1,393 @@
+/* dec64_accum.c
+
+An exact accumulator for long sums of dec64 numbers.
+
+A chain of dec64_add rounds at every step, and drops the smaller operand
+entirely when the exponents are too far apart. dec64_accum instead keeps one
+integer bucket for each exponent, and adds the coefficient of each number to
+the bucket of its exponent, which is exact and needs no alignment or packing.
+A bucket that grows past 2^61 carries all but its last digit into the bucket
+above it, so it can never overflow. The buckets above exponent 254 only
+receive those carries. The top bucket does not carry, but nothing could ever
+be added often enough to reach it.
+
+A product of two coefficients can have 34 digits. It is split into three
+parts of at most 18 digits, which go into the buckets of the product's
+exponent, 9 above and 18 above, so products are also exact. The parts come
+from splitting each coefficient at 10^9, so the arithmetic stays in 64 bits.
+
+dec64_accum_finish does the carries from the lowest used bucket up, giving the
+exact sum as one decimal digit per exponent, and rounds it once with
+dec64_new. The result is what dec64_add would give if it were done with
+infinite precision: when the exact sum fits, it is kept at the smallest
+exponent that was added, so a column of money sums to money.
+
+A nan anywhere in the sum makes the result nan.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdint.h>
+#include "dec64_accum.h"
+
+#define BLOCK 64
+#define PRODUCT_BLOCK 32
+#define LIMIT 0x2000000000000000LL
+#define LOWEST_EXPONENT -254
+#define SMALL 0x1000000000LL
+#define BILLION 1000000000LL
+
+static void carry(dec64_accum* accum, int at) {
+/*
+    Carry all but the last digit of each bucket that is past the limit into
+    the bucket above it.
+*/
+    int64 quotient;
+
+    while (
+        at < DEC64_ACCUM_BUCKETS - 1
+        && (uint64)(accum->buckets[at] + LIMIT) > (uint64)(2 * LIMIT)
+    ) {
+        quotient = accum->buckets[at] / 10;
+        accum->buckets[at] -= quotient * 10;
+        at += 1;
+        accum->buckets[at] += quotient;
+    }
+}
+
+static inline void add_coefficient(dec64_accum* accum, int at, int64 coefficient) {
+    accum->buckets[at] += coefficient;
+    if ((uint64)(accum->buckets[at] + LIMIT) > (uint64)(2 * LIMIT)) {
+        carry(accum, at);
+    }
+}
+
+static inline void add_one(dec64_accum* accum, dec64 number) {
+    int exponent = (signed char)number;
+
+    if (exponent == -128) {
+        accum->nan = 1;
+    } else {
+        add_coefficient(accum, exponent - LOWEST_EXPONENT, number >> 8);
+    }
+}
+
+static inline void add_product(
+    dec64_accum* accum,
+    dec64 multiplicand,
+    dec64 multiplier
+) {
+/*
+    As in dec64_multiply, the product is nan if either number is nan and the
+    other is not zero. Coefficients under 2^31 make a product that fits.
+*/
+    int nan1 = (multiplicand & 0xFF) == 0x80;
+    int nan2 = (multiplier & 0xFF) == 0x80;
+    int64 coefficient1 = multiplicand >> 8;
+    int64 coefficient2 = multiplier >> 8;
+    int64 high1;
+    int64 high2;
+    int64 low1;
+    int64 low2;
+    int at;
+
+    if (nan1 || nan2) {
+        if ((nan1 && nan2) || (nan1 ? coefficient2 : coefficient1) != 0) {
+            accum->nan = 1;
+        }
+        return;
+    }
+    at = (signed char)multiplicand + (signed char)multiplier - LOWEST_EXPONENT;
+    if (
+        (uint64)(coefficient1 + 0x80000000LL) < 0x100000000ULL
+        && (uint64)(coefficient2 + 0x80000000LL) < 0x100000000ULL
+    ) {
+        add_coefficient(accum, at, coefficient1 * coefficient2);
+    } else {
+        high1 = coefficient1 / BILLION;
+        high2 = coefficient2 / BILLION;
+        low1 = coefficient1 - high1 * BILLION;
+        low2 = coefficient2 - high2 * BILLION;
+        add_coefficient(accum, at, low1 * low2);
+        add_coefficient(accum, at + 9, high1 * low2 + low1 * high2);
+        add_coefficient(accum, at + 18, high1 * high2);
+    }
+}
+
+static inline void add_products_kernel(
+    dec64_accum* accum,
+    const dec64* multiplicands,
+    size_t stride1,
+    const dec64* multipliers,
+    size_t stride2,
+    size_t n
+) {
+/*
+    The products are taken in blocks. If every multiplicand in a block has the
+    exponent of the first, every multiplier has the exponent of the first, none
+    is nan and every coefficient is under 2^28, then the products are summed in
+    a register (32 of them can not pass 2^61) and go into the bucket at once.
+    Otherwise the block is done one product at a time.
+
+    The coefficients are checked on the words plus 2^36, which are under 2^37
+    when the coefficients are under 2^28. Adding 2^36 to a word adds 2^28 to
+    its coefficient and leaves the exponent alone, so the biased coefficients
+    are unsigned and under 2^29, and can be multiplied with the unsigned 32 bit
+    multiply that every vector unit has. Since
+
+        (a + 2^28) * (b + 2^28) = a * b + 2^28 * ((a + 2^28) + (b + 2^28)) - 2^56
+
+    the sum of the products is had by taking back 2^28 times the sum of the
+    biased coefficients and adding 2^56 for each lane. The arithmetic wraps,
+    but the result fits.
+
+    The kernel is static inline and called with constant strides, so that the
+    contiguous case gets its own loop.
+*/
+    size_t at;
+    int lane;
+
+    for (at = 0; at + PRODUCT_BLOCK <= n; at += PRODUCT_BLOCK) {
+        dec64 first1 = multiplicands[at * stride1];
+        dec64 first2 = multipliers[at * stride2];
+        uint64 mixed = 0;
+        uint64 range = 0;
+        uint64 products = 0;
+        uint64 offsets = 0;
+        for (lane = 0; lane < PRODUCT_BLOCK; lane += 1) {
+            uint64 word1 = (uint64)multiplicands[(at + lane) * stride1] + SMALL;
+            uint64 word2 = (uint64)multipliers[(at + lane) * stride2] + SMALL;
+            uint32_t biased1 = (uint32_t)(word1 >> 8);
+            uint32_t biased2 = (uint32_t)(word2 >> 8);
+            mixed |= (word1 ^ (uint64)first1) | (word2 ^ (uint64)first2);
+            range |= word1 | word2;
+            products += (uint64)biased1 * biased2;
+            offsets += (uint64)biased1 + biased2;
+        }
+        if (
+            (mixed & 0xFF) == 0
+            && range < 2 * SMALL
+            && (first1 & 0xFF) != 0x80
+            && (first2 & 0xFF) != 0x80
+        ) {
+            add_coefficient(
+                accum,
+                (signed char)first1 + (signed char)first2 - LOWEST_EXPONENT,
+                (int64)(
+                    products
+                    - (offsets << 28)
+                    + ((uint64)PRODUCT_BLOCK << 56)
+                )
+            );
+        } else {
+            for (lane = 0; lane < PRODUCT_BLOCK; lane += 1) {
+                add_product(
+                    accum,
+                    multiplicands[(at + lane) * stride1],
+                    multipliers[(at + lane) * stride2]
+                );
+            }
+        }
+    }
+    for (; at < n; at += 1) {
+        add_product(accum, multiplicands[at * stride1], multipliers[at * stride2]);
+    }
+}
+
+static int64 digitize(
+    const dec64_accum* accum,
+    int64 sign,
+    int lowest,
+    int highest,
+    signed char digits[DEC64_ACCUM_BUCKETS]
+) {
+/*
+    Do the carries from the lowest used bucket up with floored division, so
+    that every digit is 0 to 9, and return what is carried out of the top. That
+    is negative if the sum is negative, and then it is done again with the sign
+    flipped. A bucket holds less than 2^61, so its carries are gone 19 buckets
+    above the highest used one.
+*/
+    int at;
+    int end = highest + 20 < DEC64_ACCUM_BUCKETS ? highest + 20 : DEC64_ACCUM_BUCKETS;
+    int64 value;
+    int64 excess = 0;
+
+    for (at = lowest; at < end; at += 1) {
+        value = sign * accum->buckets[at] + excess;
+        excess = value / 10;
+        digits[at] = (signed char)(value - excess * 10);
+        if (digits[at] < 0) {
+            digits[at] += 10;
+            excess -= 1;
+        }
+    }
+    for (; at < DEC64_ACCUM_BUCKETS; at += 1) {
+        digits[at] = 0;
+    }
+    return excess;
+}
+
+void dec64_accum_init(dec64_accum* accum) {
+    int at;
+
+    for (at = 0; at < DEC64_ACCUM_BUCKETS; at += 1) {
+        accum->buckets[at] = 0;
+    }
+    accum->nan = 0;
+}
+
+void dec64_accum_add(dec64_accum* accum, dec64 number) {
+    add_one(accum, number);
+}
+
+void dec64_accum_add_n(dec64_accum* accum, const dec64* numbers, size_t n) {
+/*
+    Columns usually have one exponent, so the numbers are taken in blocks. If
+    every number in a block has the exponent of the first and it is not nan,
+    the coefficients are summed in a register (64 of them can not pass 2^61)
+    and go into the bucket at once. Otherwise the block is done one at a time.
+
+    The coefficients are summed with unsigned shifts, which every vector unit
+    has, and 2^56 is taken back for each negative one.
+*/
+    size_t at;
+    int lane;
+
+    for (at = 0; at + BLOCK <= n; at += BLOCK) {
+        dec64 first = numbers[at];
+        int64 mixed = 0;
+        uint64 sum = 0;
+        uint64 negatives = 0;
+        for (lane = 0; lane < BLOCK; lane += 1) {
+            dec64 number = numbers[at + lane];
+            mixed |= (number ^ first) & 0xFF;
+            sum += (uint64)number >> 8;
+            negatives += (uint64)number >> 63;
+        }
+        if (mixed == 0 && (first & 0xFF) != 0x80) {
+            add_coefficient(
+                accum,
+                (signed char)first - LOWEST_EXPONENT,
+                (int64)(sum - (negatives << 56))
+            );
+        } else {
+            for (lane = 0; lane < BLOCK; lane += 1) {
+                add_one(accum, numbers[at + lane]);
+            }
+        }
+    }
+    for (; at < n; at += 1) {
+        add_one(accum, numbers[at]);
+    }
+}
+
+void dec64_accum_add_product(
+    dec64_accum* accum,
+    dec64 multiplicand,
+    dec64 multiplier
+) {
+    add_product(accum, multiplicand, multiplier);
+}
+
+void dec64_accum_add_products_n(
+    dec64_accum* accum,
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    size_t n
+) {
+    add_products_kernel(accum, multiplicands, 1, multipliers, 1, n);
+}
+
+void dec64_accum_merge(dec64_accum* accum, const dec64_accum* other) {
+    int at;
+
+    for (at = 0; at < DEC64_ACCUM_BUCKETS; at += 1) {
+        add_coefficient(accum, at, other->buckets[at]);
+    }
+    accum->nan |= other->nan;
+}
+
+dec64 dec64_accum_finish(const dec64_accum* accum) {
+/*
+    The 18 digits at the top of the exact sum, but none below the smallest
+    exponent that was added, are given to dec64_new, which rounds them to fit.
+    The digits below those can not change the rounding, because a dropped 5
+    rounds away from zero whatever follows it.
+*/
+    signed char digits[DEC64_ACCUM_BUCKETS];
+    int64 sign = 1;
+    int64 coefficient = 0;
+    int lowest;
+    int highest;
+    int bottom;
+    int top;
+    int at;
+
+    if (accum->nan) {
+        return DEC64_NAN;
+    }
+    for (lowest = 0; lowest < DEC64_ACCUM_BUCKETS; lowest += 1) {
+        if (accum->buckets[lowest] != 0) {
+            break;
+        }
+    }
+    if (lowest == DEC64_ACCUM_BUCKETS) {
+        return DEC64_ZERO;
+    }
+    for (highest = DEC64_ACCUM_BUCKETS - 1; highest > lowest; highest -= 1) {
+        if (accum->buckets[highest] != 0) {
+            break;
+        }
+    }
+    if (digitize(accum, 1, lowest, highest, digits) != 0) {
+        sign = -1;
+        if (digitize(accum, -1, lowest, highest, digits) != 0) {
+            return DEC64_NAN;
+        }
+    }
+    for (top = DEC64_ACCUM_BUCKETS - 1; top >= lowest; top -= 1) {
+        if (digits[top] != 0) {
+            break;
+        }
+    }
+    if (top < lowest) {
+        return DEC64_ZERO;
+    }
+    bottom = top - 17 > lowest ? top - 17 : lowest;
+    for (at = top; at >= bottom; at -= 1) {
+        coefficient = coefficient * 10 + digits[at];
+    }
+    return dec64_new(sign * coefficient, bottom + LOWEST_EXPONENT);
+}
+
+dec64 dec64_dot(const dec64* multiplicands, const dec64* multipliers, size_t n) {
+    dec64_accum accum;
+
+    dec64_accum_init(&accum);
+    add_products_kernel(&accum, multiplicands, 1, multipliers, 1, n);
+    return dec64_accum_finish(&accum);
+}
+
+dec64 dec64_dot_strided(
+    const dec64* multiplicands,
+    size_t multiplicand_stride,
+    const dec64* multipliers,
+    size_t multiplier_stride,
+    size_t n
+) {
+    dec64_accum accum;
+
+    dec64_accum_init(&accum);
+    add_products_kernel(
+        &accum,
+        multiplicands,
+        multiplicand_stride,
+        multipliers,
+        multiplier_stride,
+        n
+    );
+    return dec64_accum_finish(&accum);
+}
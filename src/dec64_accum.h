@@ -0,0 +1,78 @@
+/* dec64_accum.h
+
+The dec64_accum header file. This is the companion to dec64_accum.c.
+
+A dec64_accum sums any number of dec64 numbers exactly, and rounds only once,
+in dec64_accum_finish. It is a plain struct that the caller owns, on the stack
+or anywhere else, and must be cleared with dec64_accum_init before use.
+dec64_accum_merge adds one accumulator into another, so that partial sums can
+be made separately and combined. The result does not depend on the order of
+the additions or merges.
+
+dec64_accum_add_product adds the exact product of two numbers, so an
+accumulator can also make a dot product (or a weighted sum) that is rounded
+only once. dec64_dot does that for two arrays, and dec64_dot_strided for
+arrays whose elements are stride numbers apart, like a column of a matrix.
+
+Public Domain
+
+No warranty.
+*/
+
+#ifndef DEC64_ACCUM
+#define DEC64_ACCUM
+
+#include <stddef.h>
+#include "dec64.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+    One bucket for each exponent from -254 to 254, which is the range of the
+    exponents of products, and more above that for the carries of very long
+    sums.
+*/
+
+#define DEC64_ACCUM_BUCKETS 547
+
+typedef struct dec64_accum {
+    int64 buckets[DEC64_ACCUM_BUCKETS];
+    int64 nan;
+} dec64_accum;
+
+extern void dec64_accum_init(dec64_accum* accum);
+extern void dec64_accum_add(dec64_accum* accum, dec64 number);
+extern void dec64_accum_add_n(dec64_accum* accum, const dec64* numbers, size_t n);
+extern void dec64_accum_add_product(
+    dec64_accum* accum,
+    dec64 multiplicand,
+    dec64 multiplier
+);
+extern void dec64_accum_add_products_n(
+    dec64_accum* accum,
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    size_t n
+);
+extern void dec64_accum_merge(dec64_accum* accum, const dec64_accum* other);
+extern dec64 dec64_accum_finish(const dec64_accum* accum);
+extern dec64 dec64_dot(
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    size_t n
+);
+extern dec64 dec64_dot_strided(
+    const dec64* multiplicands,
+    size_t multiplicand_stride,
+    const dec64* multipliers,
+    size_t multiplier_stride,
+    size_t n
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //DEC64_ACCUM
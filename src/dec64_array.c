@@ -0,0 +1,1101 @@
+/* dec64_array.c
+
+Batched versions of the dec64 operators, for columns of numbers.
+
+The results are always identical to calling the operator on each element.
+
+Most columns hold numbers with the same exponent (prices, money, counts), so
+add, subtract and the comparisons take the elements in blocks. If every pair
+in a block has the same exponent, no nan and no overflow, the whole block is
+done with plain word arithmetic and no branches, which the compiler can
+vectorize. Otherwise the block is redone one element at a time with the
+fast paths of dec64_inline.h, which fall back to the out-of-line functions.
+A block is computed into a buffer first, so out may alias an operand.
+
+The scans fold a running total from the left, so that out[i] is exactly the
+total that a chain of dec64_add calls would have. Blocks that share the
+exponent of the total are a running sum of words.
+
+Multiply and fma use the inline fast path for each element. Divide has no fast path:
+its results are scaled, so only dec64_divide gives identical ones.
+
+In the kernels, step is 1 when the second operand is an array and 0 when it
+is a scalar. The kernels are static inline and always called with a constant
+step, so each entry point gets its own specialized loop.
+
+On x86-64 with GCC or Clang there are also AVX2 (4 lanes) and AVX-512 (8 lanes)
+kernels for add, subtract, is_equal, is_less, neg, abs and signum. They do
+the same word arithmetic as the block kernels on whole vectors. Lanes that
+need alignment of exponents or repacking are redone with the scalar fast paths,
+and the rest of the vector is kept. The widest kernel set that the processor
+supports is chosen at the first call, using cpuid, so one binary runs on any
+x86-64. dec64_array_use_kernel can limit the choice, for tests and benchmarks.
+
+Public Domain
+
+No warranty.
+*/
+
+#include "dec64_array.h"
+#include "dec64_inline.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#define BLOCK 16
+
+#define LOW 0xFFLL
+#define HIGH (~0xFFLL)
+#define MIN_SHIFTED (-9223372036854775807LL - 1)
+
+static inline void add_kernel(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n,
+    int subtraction
+) {
+    dec64 block[BLOCK];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + BLOCK <= n; at += BLOCK) {
+        int slow = 0;
+        for (lane = 0; lane < BLOCK; lane += 1) {
+            dec64 x = first[at + lane];
+            dec64 y = second[(at + lane) * step];
+            int64 x_coefficient = x & ~0xFFLL;
+            int64 y_coefficient = y & ~0xFFLL;
+            int64 result;
+            if (subtraction) {
+                result = (int64)((uint64)x_coefficient - (uint64)y_coefficient);
+                slow |= ((x_coefficient ^ y_coefficient) & (x_coefficient ^ result)) < 0;
+            } else {
+                result = (int64)((uint64)x_coefficient + (uint64)y_coefficient);
+                slow |= ((x_coefficient ^ result) & (y_coefficient ^ result)) < 0;
+            }
+            slow |= ((x ^ y) & 0xFF) != 0;
+            slow |= (x & 0xFF) == 0x80;
+            block[lane] = result == 0 ? 0 : result | (x & 0xFF);
+        }
+        if (slow) {
+            for (lane = 0; lane < BLOCK; lane += 1) {
+                block[lane] = subtraction
+                    ? dec64_inline_subtract(first[at + lane], second[(at + lane) * step])
+                    : dec64_inline_add(first[at + lane], second[(at + lane) * step]);
+            }
+        }
+        for (lane = 0; lane < BLOCK; lane += 1) {
+            out[at + lane] = block[lane];
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = subtraction
+            ? dec64_inline_subtract(first[at], second[at * step])
+            : dec64_inline_add(first[at], second[at * step]);
+    }
+}
+
+static inline void is_equal_kernel(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n
+) {
+    dec64 block[BLOCK];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + BLOCK <= n; at += BLOCK) {
+        int slow = 0;
+        for (lane = 0; lane < BLOCK; lane += 1) {
+            dec64 x = first[at + lane];
+            dec64 y = second[(at + lane) * step];
+            slow |= (x != y) & (((x ^ y) & 0xFF) != 0) & ((x ^ y) >= 0);
+            block[lane] = x == y ? DEC64_ONE : DEC64_ZERO;
+        }
+        if (slow) {
+            for (lane = 0; lane < BLOCK; lane += 1) {
+                block[lane] = dec64_inline_is_equal(
+                    first[at + lane],
+                    second[(at + lane) * step]
+                );
+            }
+        }
+        for (lane = 0; lane < BLOCK; lane += 1) {
+            out[at + lane] = block[lane];
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = dec64_inline_is_equal(first[at], second[at * step]);
+    }
+}
+
+static inline void is_less_kernel(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n
+) {
+    dec64 block[BLOCK];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + BLOCK <= n; at += BLOCK) {
+        int slow = 0;
+        for (lane = 0; lane < BLOCK; lane += 1) {
+            dec64 x = first[at + lane];
+            dec64 y = second[(at + lane) * step];
+            int nan = ((x & 0xFF) == 0x80) | ((y & 0xFF) == 0x80);
+            slow |= !nan & (((x ^ y) & 0xFF) != 0) & ((x ^ y) >= 0);
+            block[lane] = nan ? DEC64_NAN : x < y ? DEC64_ONE : DEC64_ZERO;
+        }
+        if (slow) {
+            for (lane = 0; lane < BLOCK; lane += 1) {
+                block[lane] = dec64_inline_is_less(
+                    first[at + lane],
+                    second[(at + lane) * step]
+                );
+            }
+        }
+        for (lane = 0; lane < BLOCK; lane += 1) {
+            out[at + lane] = block[lane];
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = dec64_inline_is_less(first[at], second[at * step]);
+    }
+}
+
+static inline dec64 neg_one(dec64 number) {
+/*
+    The word arithmetic of dec64_neg. Only the most negative coefficient needs
+    packing, so it goes to dec64_neg.
+*/
+    int64 shifted = number & HIGH;
+    if ((number & LOW) == 0x80) {
+        return DEC64_NAN;
+    }
+    if (shifted == 0) {
+        return DEC64_ZERO;
+    }
+    if (shifted == MIN_SHIFTED) {
+        return dec64_neg(number);
+    }
+    return (int64)(0 - (uint64)shifted) | (number & LOW);
+}
+
+static inline dec64 abs_one(dec64 number) {
+    if (number < 0) {
+        return neg_one(number);
+    }
+    if ((number & LOW) == 0x80) {
+        return DEC64_NAN;
+    }
+    return (number & HIGH) == 0 ? DEC64_ZERO : number;
+}
+
+static inline dec64 signum_one(dec64 number) {
+    if ((number & LOW) == 0x80) {
+        return DEC64_NAN;
+    }
+    return number < 0
+        ? DEC64_NEGATIVE_ONE
+        : (number & HIGH) != 0 ? DEC64_ONE : DEC64_ZERO;
+}
+
+static inline dec64 scan_kernel(
+    dec64* out,
+    const dec64* numbers,
+    size_t n,
+    dec64 total,
+    int exclusive
+) {
+/*
+    The running total is folded with dec64_add, from the left. If the total is
+    zero or has the exponent of a block, and every number in the block has that
+    exponent, the block is a running sum of words, checked for overflow. A zero
+    total takes the exponent of the number added to it, as in dec64_add.
+    Otherwise the block is done (or redone) from its total with the inline fast
+    path. A total that does not fit the block's first number skips the try.
+
+    out gets the total after each number, or before it when exclusive, and the
+    final total is returned.
+*/
+    dec64 block[BLOCK];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + BLOCK <= n; at += BLOCK) {
+        int64 exponent = numbers[at] & LOW;
+        int64 running = total & HIGH;
+        int slow = exponent == 0x80
+            || (total & LOW) == 0x80
+            || (running != 0 && (total & LOW) != exponent);
+        if (!slow) {
+            for (lane = 0; lane < BLOCK; lane += 1) {
+                dec64 number = numbers[at + lane];
+                int64 coefficient = number & HIGH;
+                int64 sum = (int64)((uint64)running + (uint64)coefficient);
+                slow |= ((running ^ sum) & (coefficient ^ sum)) < 0;
+                slow |= (number & LOW) != exponent;
+                block[lane] = exclusive ? running : sum;
+                running = sum;
+            }
+        }
+        if (slow) {
+            for (lane = 0; lane < BLOCK; lane += 1) {
+                dec64 number = numbers[at + lane];
+                if (exclusive) {
+                    block[lane] = total;
+                }
+                total = dec64_inline_add(total, number);
+                if (!exclusive) {
+                    block[lane] = total;
+                }
+            }
+        } else {
+            for (lane = 0; lane < BLOCK; lane += 1) {
+                block[lane] = block[lane] == 0 ? DEC64_ZERO : block[lane] | exponent;
+            }
+            if (exclusive) {
+                block[0] = total;
+            }
+            total = running == 0 ? DEC64_ZERO : running | exponent;
+        }
+        for (lane = 0; lane < BLOCK; lane += 1) {
+            out[at + lane] = block[lane];
+        }
+    }
+    for (; at < n; at += 1) {
+        dec64 number = numbers[at];
+        if (exclusive) {
+            out[at] = total;
+        }
+        total = dec64_inline_add(total, number);
+        if (!exclusive) {
+            out[at] = total;
+        }
+    }
+    return total;
+}
+
+#ifdef X86_KERNELS
+
+/* AVX2 kernels */
+
+__attribute__((target("avx2")))
+static void add_avx2(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n,
+    int subtraction
+) {
+    const __m256i low = _mm256_set1_epi64x(LOW);
+    const __m256i high = _mm256_set1_epi64x(HIGH);
+    const __m256i nan = _mm256_set1_epi64x(DEC64_NAN);
+    const __m256i zero = _mm256_setzero_si256();
+    dec64 vector[4];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + 4 <= n; at += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(first + at));
+        __m256i y = step
+            ? _mm256_loadu_si256((const __m256i*)(second + at))
+            : _mm256_set1_epi64x(second[0]);
+        __m256i x_coefficient = _mm256_and_si256(x, high);
+        __m256i y_coefficient = _mm256_and_si256(y, high);
+        __m256i exponent = _mm256_and_si256(x, low);
+        __m256i result;
+        __m256i overflow;
+        int slow;
+        if (subtraction) {
+            result = _mm256_sub_epi64(x_coefficient, y_coefficient);
+            overflow = _mm256_and_si256(
+                _mm256_xor_si256(x_coefficient, y_coefficient),
+                _mm256_xor_si256(x_coefficient, result)
+            );
+        } else {
+            result = _mm256_add_epi64(x_coefficient, y_coefficient);
+            overflow = _mm256_and_si256(
+                _mm256_xor_si256(x_coefficient, result),
+                _mm256_xor_si256(y_coefficient, result)
+            );
+        }
+        slow = _mm256_movemask_pd(_mm256_castsi256_pd(overflow))
+            | (~_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(
+                _mm256_and_si256(_mm256_xor_si256(x, y), low),
+                zero
+            ))) & 0xF)
+            | _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(exponent, nan)));
+        result = _mm256_or_si256(
+            result,
+            _mm256_andnot_si256(_mm256_cmpeq_epi64(result, zero), exponent)
+        );
+        if (slow == 0) {
+            _mm256_storeu_si256((__m256i*)(out + at), result);
+            continue;
+        }
+        _mm256_storeu_si256((__m256i*)vector, result);
+        for (lane = 0; lane < 4; lane += 1) {
+            out[at + lane] = ((slow >> lane) & 1) == 0
+                ? vector[lane]
+                : subtraction
+                ? dec64_inline_subtract(first[at + lane], second[(at + lane) * step])
+                : dec64_inline_add(first[at + lane], second[(at + lane) * step]);
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = subtraction
+            ? dec64_inline_subtract(first[at], second[at * step])
+            : dec64_inline_add(first[at], second[at * step]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void is_equal_avx2(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n
+) {
+    const __m256i low = _mm256_set1_epi64x(LOW);
+    const __m256i one = _mm256_set1_epi64x(DEC64_ONE);
+    const __m256i zero = _mm256_setzero_si256();
+    dec64 vector[4];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + 4 <= n; at += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(first + at));
+        __m256i y = step
+            ? _mm256_loadu_si256((const __m256i*)(second + at))
+            : _mm256_set1_epi64x(second[0]);
+        __m256i different = _mm256_xor_si256(x, y);
+        __m256i equal = _mm256_cmpeq_epi64(x, y);
+        __m256i same_exponent = _mm256_cmpeq_epi64(_mm256_and_si256(different, low), zero);
+        int slow = ~(
+            _mm256_movemask_pd(_mm256_castsi256_pd(equal))
+            | _mm256_movemask_pd(_mm256_castsi256_pd(same_exponent))
+            | _mm256_movemask_pd(_mm256_castsi256_pd(different))
+        ) & 0xF;
+        __m256i result = _mm256_and_si256(equal, one);
+        if (slow == 0) {
+            _mm256_storeu_si256((__m256i*)(out + at), result);
+            continue;
+        }
+        _mm256_storeu_si256((__m256i*)vector, result);
+        for (lane = 0; lane < 4; lane += 1) {
+            out[at + lane] = ((slow >> lane) & 1) == 0
+                ? vector[lane]
+                : dec64_inline_is_equal(first[at + lane], second[(at + lane) * step]);
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = dec64_inline_is_equal(first[at], second[at * step]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void is_less_avx2(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n
+) {
+    const __m256i low = _mm256_set1_epi64x(LOW);
+    const __m256i one = _mm256_set1_epi64x(DEC64_ONE);
+    const __m256i nan = _mm256_set1_epi64x(DEC64_NAN);
+    const __m256i zero = _mm256_setzero_si256();
+    dec64 vector[4];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + 4 <= n; at += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(first + at));
+        __m256i y = step
+            ? _mm256_loadu_si256((const __m256i*)(second + at))
+            : _mm256_set1_epi64x(second[0]);
+        __m256i different = _mm256_xor_si256(x, y);
+        __m256i either_nan = _mm256_or_si256(
+            _mm256_cmpeq_epi64(_mm256_and_si256(x, low), nan),
+            _mm256_cmpeq_epi64(_mm256_and_si256(y, low), nan)
+        );
+        __m256i same_exponent = _mm256_cmpeq_epi64(_mm256_and_si256(different, low), zero);
+        int slow = ~(
+            _mm256_movemask_pd(_mm256_castsi256_pd(either_nan))
+            | _mm256_movemask_pd(_mm256_castsi256_pd(same_exponent))
+            | _mm256_movemask_pd(_mm256_castsi256_pd(different))
+        ) & 0xF;
+        __m256i result = _mm256_blendv_epi8(
+            _mm256_and_si256(_mm256_cmpgt_epi64(y, x), one),
+            nan,
+            either_nan
+        );
+        if (slow == 0) {
+            _mm256_storeu_si256((__m256i*)(out + at), result);
+            continue;
+        }
+        _mm256_storeu_si256((__m256i*)vector, result);
+        for (lane = 0; lane < 4; lane += 1) {
+            out[at + lane] = ((slow >> lane) & 1) == 0
+                ? vector[lane]
+                : dec64_inline_is_less(first[at + lane], second[(at + lane) * step]);
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = dec64_inline_is_less(first[at], second[at * step]);
+    }
+}
+
+__attribute__((target("avx2")))
+static void unary_avx2(dec64* out, const dec64* numbers, size_t n, int operation) {
+/*
+    operation is 0 for neg, 1 for abs and 2 for signum.
+*/
+    const __m256i low = _mm256_set1_epi64x(LOW);
+    const __m256i high = _mm256_set1_epi64x(HIGH);
+    const __m256i nan = _mm256_set1_epi64x(DEC64_NAN);
+    const __m256i one = _mm256_set1_epi64x(DEC64_ONE);
+    const __m256i negative_one = _mm256_set1_epi64x(DEC64_NEGATIVE_ONE);
+    const __m256i min_shifted = _mm256_set1_epi64x(MIN_SHIFTED);
+    const __m256i zero = _mm256_setzero_si256();
+    dec64 vector[4];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + 4 <= n; at += 4) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(numbers + at));
+        __m256i shifted = _mm256_and_si256(x, high);
+        __m256i is_nan = _mm256_cmpeq_epi64(_mm256_and_si256(x, low), nan);
+        __m256i negative = _mm256_cmpgt_epi64(zero, x);
+        __m256i result;
+        int slow = 0;
+        if (operation == 2) {
+            result = _mm256_or_si256(
+                _mm256_and_si256(negative, negative_one),
+                _mm256_and_si256(_mm256_cmpgt_epi64(shifted, zero), one)
+            );
+        } else {
+            __m256i changed = _mm256_or_si256(
+                _mm256_sub_epi64(zero, shifted),
+                _mm256_and_si256(x, low)
+            );
+            __m256i overflow = _mm256_andnot_si256(
+                is_nan,
+                _mm256_cmpeq_epi64(shifted, min_shifted)
+            );
+            if (operation == 1) {
+                changed = _mm256_blendv_epi8(x, changed, negative);
+                overflow = _mm256_and_si256(overflow, negative);
+            }
+            result = _mm256_andnot_si256(_mm256_cmpeq_epi64(shifted, zero), changed);
+            slow = _mm256_movemask_pd(_mm256_castsi256_pd(overflow));
+        }
+        result = _mm256_blendv_epi8(result, nan, is_nan);
+        if (slow == 0) {
+            _mm256_storeu_si256((__m256i*)(out + at), result);
+            continue;
+        }
+        _mm256_storeu_si256((__m256i*)vector, result);
+        for (lane = 0; lane < 4; lane += 1) {
+            out[at + lane] = ((slow >> lane) & 1) == 0
+                ? vector[lane]
+                : dec64_neg(numbers[at + lane]);
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = operation == 0
+            ? neg_one(numbers[at])
+            : operation == 1
+            ? abs_one(numbers[at])
+            : signum_one(numbers[at]);
+    }
+}
+
+/* AVX-512 kernels */
+
+__attribute__((target("avx512f")))
+static void add_avx512(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n,
+    int subtraction
+) {
+    const __m512i low = _mm512_set1_epi64(LOW);
+    const __m512i high = _mm512_set1_epi64(HIGH);
+    const __m512i nan = _mm512_set1_epi64(DEC64_NAN);
+    const __m512i zero = _mm512_setzero_si512();
+    dec64 vector[8];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + 8 <= n; at += 8) {
+        __m512i x = _mm512_loadu_si512((const void*)(first + at));
+        __m512i y = step
+            ? _mm512_loadu_si512((const void*)(second + at))
+            : _mm512_set1_epi64(second[0]);
+        __m512i x_coefficient = _mm512_and_si512(x, high);
+        __m512i y_coefficient = _mm512_and_si512(y, high);
+        __m512i exponent = _mm512_and_si512(x, low);
+        __m512i result;
+        __m512i overflow;
+        __mmask8 slow;
+        if (subtraction) {
+            result = _mm512_sub_epi64(x_coefficient, y_coefficient);
+            overflow = _mm512_and_si512(
+                _mm512_xor_si512(x_coefficient, y_coefficient),
+                _mm512_xor_si512(x_coefficient, result)
+            );
+        } else {
+            result = _mm512_add_epi64(x_coefficient, y_coefficient);
+            overflow = _mm512_and_si512(
+                _mm512_xor_si512(x_coefficient, result),
+                _mm512_xor_si512(y_coefficient, result)
+            );
+        }
+        slow = _mm512_cmplt_epi64_mask(overflow, zero)
+            | _mm512_test_epi64_mask(_mm512_xor_si512(x, y), low)
+            | _mm512_cmpeq_epi64_mask(exponent, nan);
+        result = _mm512_maskz_or_epi64(
+            _mm512_test_epi64_mask(result, result),
+            result,
+            exponent
+        );
+        if (slow == 0) {
+            _mm512_storeu_si512((void*)(out + at), result);
+            continue;
+        }
+        _mm512_storeu_si512((void*)vector, result);
+        for (lane = 0; lane < 8; lane += 1) {
+            out[at + lane] = ((slow >> lane) & 1) == 0
+                ? vector[lane]
+                : subtraction
+                ? dec64_inline_subtract(first[at + lane], second[(at + lane) * step])
+                : dec64_inline_add(first[at + lane], second[(at + lane) * step]);
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = subtraction
+            ? dec64_inline_subtract(first[at], second[at * step])
+            : dec64_inline_add(first[at], second[at * step]);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void is_equal_avx512(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n
+) {
+    const __m512i low = _mm512_set1_epi64(LOW);
+    const __m512i one = _mm512_set1_epi64(DEC64_ONE);
+    const __m512i zero = _mm512_setzero_si512();
+    dec64 vector[8];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + 8 <= n; at += 8) {
+        __m512i x = _mm512_loadu_si512((const void*)(first + at));
+        __m512i y = step
+            ? _mm512_loadu_si512((const void*)(second + at))
+            : _mm512_set1_epi64(second[0]);
+        __m512i different = _mm512_xor_si512(x, y);
+        __mmask8 equal = _mm512_cmpeq_epi64_mask(x, y);
+        __mmask8 slow = (__mmask8)(
+            ~equal
+            & _mm512_test_epi64_mask(different, low)
+            & _mm512_cmpge_epi64_mask(different, zero)
+        );
+        __m512i result = _mm512_maskz_mov_epi64(equal, one);
+        if (slow == 0) {
+            _mm512_storeu_si512((void*)(out + at), result);
+            continue;
+        }
+        _mm512_storeu_si512((void*)vector, result);
+        for (lane = 0; lane < 8; lane += 1) {
+            out[at + lane] = ((slow >> lane) & 1) == 0
+                ? vector[lane]
+                : dec64_inline_is_equal(first[at + lane], second[(at + lane) * step]);
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = dec64_inline_is_equal(first[at], second[at * step]);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void is_less_avx512(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n
+) {
+    const __m512i low = _mm512_set1_epi64(LOW);
+    const __m512i one = _mm512_set1_epi64(DEC64_ONE);
+    const __m512i nan = _mm512_set1_epi64(DEC64_NAN);
+    const __m512i zero = _mm512_setzero_si512();
+    dec64 vector[8];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + 8 <= n; at += 8) {
+        __m512i x = _mm512_loadu_si512((const void*)(first + at));
+        __m512i y = step
+            ? _mm512_loadu_si512((const void*)(second + at))
+            : _mm512_set1_epi64(second[0]);
+        __m512i different = _mm512_xor_si512(x, y);
+        __mmask8 either_nan = _mm512_cmpeq_epi64_mask(_mm512_and_si512(x, low), nan)
+            | _mm512_cmpeq_epi64_mask(_mm512_and_si512(y, low), nan);
+        __mmask8 slow = (__mmask8)(
+            ~either_nan
+            & _mm512_test_epi64_mask(different, low)
+            & _mm512_cmpge_epi64_mask(different, zero)
+        );
+        __m512i result = _mm512_mask_mov_epi64(
+            _mm512_maskz_mov_epi64(_mm512_cmplt_epi64_mask(x, y), one),
+            either_nan,
+            nan
+        );
+        if (slow == 0) {
+            _mm512_storeu_si512((void*)(out + at), result);
+            continue;
+        }
+        _mm512_storeu_si512((void*)vector, result);
+        for (lane = 0; lane < 8; lane += 1) {
+            out[at + lane] = ((slow >> lane) & 1) == 0
+                ? vector[lane]
+                : dec64_inline_is_less(first[at + lane], second[(at + lane) * step]);
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = dec64_inline_is_less(first[at], second[at * step]);
+    }
+}
+
+__attribute__((target("avx512f")))
+static void unary_avx512(dec64* out, const dec64* numbers, size_t n, int operation) {
+    const __m512i low = _mm512_set1_epi64(LOW);
+    const __m512i high = _mm512_set1_epi64(HIGH);
+    const __m512i nan = _mm512_set1_epi64(DEC64_NAN);
+    const __m512i one = _mm512_set1_epi64(DEC64_ONE);
+    const __m512i negative_one = _mm512_set1_epi64(DEC64_NEGATIVE_ONE);
+    const __m512i min_shifted = _mm512_set1_epi64(MIN_SHIFTED);
+    const __m512i zero = _mm512_setzero_si512();
+    dec64 vector[8];
+    size_t at;
+    int lane;
+
+    for (at = 0; at + 8 <= n; at += 8) {
+        __m512i x = _mm512_loadu_si512((const void*)(numbers + at));
+        __m512i shifted = _mm512_and_si512(x, high);
+        __mmask8 is_nan = _mm512_cmpeq_epi64_mask(_mm512_and_si512(x, low), nan);
+        __mmask8 negative = _mm512_cmplt_epi64_mask(x, zero);
+        __m512i result;
+        __mmask8 slow = 0;
+        if (operation == 2) {
+            result = _mm512_mask_mov_epi64(
+                _mm512_maskz_mov_epi64(_mm512_cmpgt_epi64_mask(shifted, zero), one),
+                negative,
+                negative_one
+            );
+        } else {
+            __mmask8 changing = operation == 1 ? negative : 0xFF;
+            result = _mm512_mask_or_epi64(
+                x,
+                changing,
+                _mm512_sub_epi64(zero, shifted),
+                _mm512_and_si512(x, low)
+            );
+            result = _mm512_maskz_mov_epi64(_mm512_test_epi64_mask(shifted, shifted), result);
+            slow = (__mmask8)(
+                changing
+                & ~is_nan
+                & _mm512_cmpeq_epi64_mask(shifted, min_shifted)
+            );
+        }
+        result = _mm512_mask_mov_epi64(result, is_nan, nan);
+        if (slow == 0) {
+            _mm512_storeu_si512((void*)(out + at), result);
+            continue;
+        }
+        _mm512_storeu_si512((void*)vector, result);
+        for (lane = 0; lane < 8; lane += 1) {
+            out[at + lane] = ((slow >> lane) & 1) == 0
+                ? vector[lane]
+                : dec64_neg(numbers[at + lane]);
+        }
+    }
+    for (; at < n; at += 1) {
+        out[at] = operation == 0
+            ? neg_one(numbers[at])
+            : operation == 1
+            ? abs_one(numbers[at])
+            : signum_one(numbers[at]);
+    }
+}
+
+#endif
+
+/* kernel selection */
+
+static int kernel = -1;
+static int kernel_limit = DEC64_ARRAY_AVX512;
+
+static int select_kernel() {
+/*
+    The widest kernel set that both the processor and the limit allow. Both
+    kernel and kernel_limit are loaded and stored atomically, because the
+    first call and dec64_array_use_kernel can happen on different threads.
+*/
+    int best = DEC64_ARRAY_GENERIC;
+    int limit = __atomic_load_n(&kernel_limit, __ATOMIC_ACQUIRE);
+#ifdef X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        best = DEC64_ARRAY_AVX512;
+    } else if (__builtin_cpu_supports("avx2")) {
+        best = DEC64_ARRAY_AVX2;
+    }
+#endif
+    return best < limit ? best : limit;
+}
+
+static inline int current_kernel() {
+/*
+    The cached kernel set. The first call selects it. If another thread has
+    stored one in the meantime, that one is kept, so a first call does not
+    undo a dec64_array_use_kernel.
+*/
+    int chosen = __atomic_load_n(&kernel, __ATOMIC_ACQUIRE);
+    int unset = -1;
+    if (chosen >= 0) {
+        return chosen;
+    }
+    chosen = select_kernel();
+    if (!__atomic_compare_exchange_n(
+        &kernel,
+        &unset,
+        chosen,
+        0,
+        __ATOMIC_ACQ_REL,
+        __ATOMIC_ACQUIRE
+    )) {
+        chosen = unset;
+    }
+    return chosen;
+}
+
+int dec64_array_kernel() {
+    return current_kernel();
+}
+
+int dec64_array_use_kernel(int limit) {
+    int chosen;
+    __atomic_store_n(&kernel_limit, limit, __ATOMIC_RELEASE);
+    chosen = select_kernel();
+    __atomic_store_n(&kernel, chosen, __ATOMIC_RELEASE);
+    return chosen;
+}
+
+static inline void add_dispatch(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n,
+    int subtraction
+) {
+#ifdef X86_KERNELS
+    switch (current_kernel()) {
+    case DEC64_ARRAY_AVX512:
+        add_avx512(out, first, second, step, n, subtraction);
+        return;
+    case DEC64_ARRAY_AVX2:
+        add_avx2(out, first, second, step, n, subtraction);
+        return;
+    }
+#endif
+    add_kernel(out, first, second, step, n, subtraction);
+}
+
+static inline void is_equal_dispatch(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n
+) {
+#ifdef X86_KERNELS
+    switch (current_kernel()) {
+    case DEC64_ARRAY_AVX512:
+        is_equal_avx512(out, first, second, step, n);
+        return;
+    case DEC64_ARRAY_AVX2:
+        is_equal_avx2(out, first, second, step, n);
+        return;
+    }
+#endif
+    is_equal_kernel(out, first, second, step, n);
+}
+
+static inline void is_less_dispatch(
+    dec64* out,
+    const dec64* first,
+    const dec64* second,
+    size_t step,
+    size_t n
+) {
+#ifdef X86_KERNELS
+    switch (current_kernel()) {
+    case DEC64_ARRAY_AVX512:
+        is_less_avx512(out, first, second, step, n);
+        return;
+    case DEC64_ARRAY_AVX2:
+        is_less_avx2(out, first, second, step, n);
+        return;
+    }
+#endif
+    is_less_kernel(out, first, second, step, n);
+}
+
+/* entry points */
+
+void dec64_abs_n(dec64* absolutions, const dec64* numbers, size_t n) {
+    size_t at;
+
+#ifdef X86_KERNELS
+    switch (current_kernel()) {
+    case DEC64_ARRAY_AVX512:
+        unary_avx512(absolutions, numbers, n, 1);
+        return;
+    case DEC64_ARRAY_AVX2:
+        unary_avx2(absolutions, numbers, n, 1);
+        return;
+    }
+#endif
+    for (at = 0; at < n; at += 1) {
+        absolutions[at] = abs_one(numbers[at]);
+    }
+}
+
+void dec64_add_n(
+    dec64* sums,
+    const dec64* augends,
+    const dec64* addends,
+    size_t n
+) {
+    add_dispatch(sums, augends, addends, 1, n, 0);
+}
+
+void dec64_add_n_scalar(
+    dec64* sums,
+    const dec64* augends,
+    dec64 addend,
+    size_t n
+) {
+    add_dispatch(sums, augends, &addend, 0, n, 0);
+}
+
+void dec64_divide_n(
+    dec64* quotients,
+    const dec64* dividends,
+    const dec64* divisors,
+    size_t n
+) {
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        quotients[at] = dec64_divide(dividends[at], divisors[at]);
+    }
+}
+
+void dec64_divide_n_scalar(
+    dec64* quotients,
+    const dec64* dividends,
+    dec64 divisor,
+    size_t n
+) {
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        quotients[at] = dec64_divide(dividends[at], divisor);
+    }
+}
+
+void dec64_fma_n(
+    dec64* sums,
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    const dec64* addends,
+    size_t n
+) {
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        sums[at] = dec64_inline_fma(multiplicands[at], multipliers[at], addends[at]);
+    }
+}
+
+void dec64_fma_n_scalar(
+    dec64* sums,
+    const dec64* multiplicands,
+    dec64 multiplier,
+    dec64 addend,
+    size_t n
+) {
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        sums[at] = dec64_inline_fma(multiplicands[at], multiplier, addend);
+    }
+}
+
+void dec64_is_equal_n(
+    dec64* comparisons,
+    const dec64* comparahends,
+    const dec64* comparators,
+    size_t n
+) {
+    is_equal_dispatch(comparisons, comparahends, comparators, 1, n);
+}
+
+void dec64_is_equal_n_scalar(
+    dec64* comparisons,
+    const dec64* comparahends,
+    dec64 comparator,
+    size_t n
+) {
+    is_equal_dispatch(comparisons, comparahends, &comparator, 0, n);
+}
+
+void dec64_is_less_n(
+    dec64* comparisons,
+    const dec64* comparahends,
+    const dec64* comparators,
+    size_t n
+) {
+    is_less_dispatch(comparisons, comparahends, comparators, 1, n);
+}
+
+void dec64_is_less_n_scalar(
+    dec64* comparisons,
+    const dec64* comparahends,
+    dec64 comparator,
+    size_t n
+) {
+    is_less_dispatch(comparisons, comparahends, &comparator, 0, n);
+}
+
+void dec64_multiply_n(
+    dec64* products,
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    size_t n
+) {
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        products[at] = dec64_inline_multiply(multiplicands[at], multipliers[at]);
+    }
+}
+
+void dec64_multiply_n_scalar(
+    dec64* products,
+    const dec64* multiplicands,
+    dec64 multiplier,
+    size_t n
+) {
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        products[at] = dec64_inline_multiply(multiplicands[at], multiplier);
+    }
+}
+
+void dec64_neg_n(dec64* negations, const dec64* numbers, size_t n) {
+    size_t at;
+
+#ifdef X86_KERNELS
+    switch (current_kernel()) {
+    case DEC64_ARRAY_AVX512:
+        unary_avx512(negations, numbers, n, 0);
+        return;
+    case DEC64_ARRAY_AVX2:
+        unary_avx2(negations, numbers, n, 0);
+        return;
+    }
+#endif
+    for (at = 0; at < n; at += 1) {
+        negations[at] = neg_one(numbers[at]);
+    }
+}
+
+dec64 dec64_scan_exclusive(
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start
+) {
+    return scan_kernel(totals, numbers, n, start, 1);
+}
+
+dec64 dec64_scan_inclusive(
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start
+) {
+    return scan_kernel(totals, numbers, n, start, 0);
+}
+
+void dec64_signum_n(dec64* signatures, const dec64* numbers, size_t n) {
+    size_t at;
+
+#ifdef X86_KERNELS
+    switch (current_kernel()) {
+    case DEC64_ARRAY_AVX512:
+        unary_avx512(signatures, numbers, n, 2);
+        return;
+    case DEC64_ARRAY_AVX2:
+        unary_avx2(signatures, numbers, n, 2);
+        return;
+    }
+#endif
+    for (at = 0; at < n; at += 1) {
+        signatures[at] = signum_one(numbers[at]);
+    }
+}
+
+void dec64_subtract_n(
+    dec64* differences,
+    const dec64* minuends,
+    const dec64* subtrahends,
+    size_t n
+) {
+    add_dispatch(differences, minuends, subtrahends, 1, n, 1);
+}
+
+void dec64_subtract_n_scalar(
+    dec64* differences,
+    const dec64* minuends,
+    dec64 subtrahend,
+    size_t n
+) {
+    add_dispatch(differences, minuends, &subtrahend, 0, n, 1);
+}
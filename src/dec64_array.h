@@ -0,0 +1,148 @@
+/* dec64_array.h
+
+The dec64_array header file. This is the companion to dec64_array.c.
+
+Each function applies an operator to n elements and writes n results to out.
+In the _scalar variants the second operand (and for fma, the addend too) is a
+single number that is used for every element. out may be the same array as an operand.
+
+dec64_scan_inclusive and dec64_scan_exclusive make running totals: the total
+is start, and each number is added to it in turn with dec64_add. totals[i] is
+the total after numbers[i] (inclusive) or before it (exclusive). The final
+total is returned, so a long stream can be scanned in pieces by passing it as
+the start of the next piece. totals may be the same array as numbers.
+
+On x86-64 the add, subtract, compare, neg, abs and signum loops have AVX2
+and AVX-512 kernels. The widest set the processor supports is chosen on first
+use. dec64_array_use_kernel lowers (or restores) that choice and returns the
+kernel set that is now in use.
+
+Public Domain
+
+No warranty.
+*/
+
+#ifndef DEC64_ARRAY
+#define DEC64_ARRAY
+
+#include <stddef.h>
+#include "dec64.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEC64_ARRAY_GENERIC 0
+#define DEC64_ARRAY_AVX2 1
+#define DEC64_ARRAY_AVX512 2
+
+extern int dec64_array_kernel(void);
+extern int dec64_array_use_kernel(int limit);
+
+extern void dec64_abs_n(dec64* absolutions, const dec64* numbers, size_t n);
+extern void dec64_add_n(
+    dec64* sums,
+    const dec64* augends,
+    const dec64* addends,
+    size_t n
+);
+extern void dec64_add_n_scalar(
+    dec64* sums,
+    const dec64* augends,
+    dec64 addend,
+    size_t n
+);
+extern void dec64_divide_n(
+    dec64* quotients,
+    const dec64* dividends,
+    const dec64* divisors,
+    size_t n
+);
+extern void dec64_divide_n_scalar(
+    dec64* quotients,
+    const dec64* dividends,
+    dec64 divisor,
+    size_t n
+);
+extern void dec64_fma_n(
+    dec64* sums,
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    const dec64* addends,
+    size_t n
+);
+extern void dec64_fma_n_scalar(
+    dec64* sums,
+    const dec64* multiplicands,
+    dec64 multiplier,
+    dec64 addend,
+    size_t n
+);
+extern void dec64_is_equal_n(
+    dec64* comparisons,
+    const dec64* comparahends,
+    const dec64* comparators,
+    size_t n
+);
+extern void dec64_is_equal_n_scalar(
+    dec64* comparisons,
+    const dec64* comparahends,
+    dec64 comparator,
+    size_t n
+);
+extern void dec64_is_less_n(
+    dec64* comparisons,
+    const dec64* comparahends,
+    const dec64* comparators,
+    size_t n
+);
+extern void dec64_is_less_n_scalar(
+    dec64* comparisons,
+    const dec64* comparahends,
+    dec64 comparator,
+    size_t n
+);
+extern void dec64_multiply_n(
+    dec64* products,
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    size_t n
+);
+extern void dec64_multiply_n_scalar(
+    dec64* products,
+    const dec64* multiplicands,
+    dec64 multiplier,
+    size_t n
+);
+extern void dec64_neg_n(dec64* negations, const dec64* numbers, size_t n);
+extern dec64 dec64_scan_exclusive(
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start
+);
+extern dec64 dec64_scan_inclusive(
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start
+);
+extern void dec64_signum_n(dec64* signatures, const dec64* numbers, size_t n);
+extern void dec64_subtract_n(
+    dec64* differences,
+    const dec64* minuends,
+    const dec64* subtrahends,
+    size_t n
+);
+extern void dec64_subtract_n_scalar(
+    dec64* differences,
+    const dec64* minuends,
+    dec64 subtrahend,
+    size_t n
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //DEC64_ARRAY
@@ -0,0 +1,477 @@
+//
+// constexpr C++ port of the arithmetic in dec64.c
+//
+//Every function here gives the same word as its namesake in dec64.c (the C backend), so
+// Dec64 constants and tables can be folded by the compiler and hot loops can be inlined.
+//The C++14 rules for constant expressions apply: no signed overflow and no left shift
+// of negative numbers, so the shifts and the overflow checks are done on unsigned words
+//The 128 bit products use unsigned __int128 when the compiler has it, and a pair of
+// 64 bit words otherwise
+//
+//dec64.h includes this file after its typedefs, so it is included before the guard
+#include "dec64.h"
+
+#ifndef DEC64_CONSTEXPR
+#define DEC64_CONSTEXPR
+
+#include <cstdint>
+
+namespace dec64_constexpr
+{
+    constexpr int64 MAXNUM = 0x007FFFFFFFFFFFFF;
+
+    constexpr uint64 powers10[] = {1ULL,                       // 10^00
+                                   10ULL,                      // 10^01
+                                   100ULL,                     // 10^02
+                                   1000ULL,                    // 10^03
+                                   10000ULL,                   // 10^04
+                                   100000ULL,                  // 10^05
+                                   1000000ULL,                 // 10^06
+                                   10000000ULL,                // 10^07
+                                   100000000ULL,               // 10^08
+                                   1000000000ULL,              // 10^09
+                                   10000000000ULL,             // 10^10
+                                   100000000000ULL,            // 10^11
+                                   1000000000000ULL,           // 10^12
+                                   10000000000000ULL,          // 10^13
+                                   100000000000000ULL,         // 10^14
+                                   1000000000000000ULL,        // 10^15
+                                   10000000000000000ULL,       // 10^16
+                                   100000000000000000ULL,      // 10^17
+                                   1000000000000000000ULL,     // 10^18
+                                   10000000000000000000ULL};   // 10^19
+
+    namespace detail
+    {
+        constexpr int leading_zeros(uint64 x)
+        {
+#if defined(__GNUC__) || defined(__clang__)
+            return __builtin_clzll(x);
+#else
+            int count = 0;
+            while ((x & 0x8000000000000000ULL) == 0)
+            {
+                x <<= 1;
+                count++;
+            }
+            return count;
+#endif
+        }
+
+        constexpr int8_t low_byte(int64 number)
+        {
+            return (int8_t) number;
+        }
+
+        constexpr uint64 magnitude(int64 number)
+        {
+            return number < 0 ? 0 - (uint64) number : (uint64) number;
+        }
+
+        constexpr int64 with_sign(uint64 magnitude, bool negative)
+        {
+            return (int64) (negative ? 0 - magnitude : magnitude);
+        }
+
+        //A signed 128 bit product, as the two words of its two's complement
+        struct wide
+        {
+            uint64 high;
+            uint64 low;
+        };
+
+        constexpr wide multiply(int64 first, int64 second)
+        {
+#if defined(__SIZEOF_INT128__)
+            __extension__ typedef __int128 int128;
+            int128 product = (int128) first * second;
+            return wide{(uint64) (product >> 64), (uint64) product};
+#else
+            //Four 32 bit partial products of the magnitudes, then the sign
+            uint64 a = magnitude(first), b = magnitude(second);
+            uint64 a_low = a & 0xFFFFFFFF, a_high = a >> 32;
+            uint64 b_low = b & 0xFFFFFFFF, b_high = b >> 32;
+            uint64 low_low = a_low * b_low;
+            uint64 middle = a_high * b_low + (low_low >> 32);
+            uint64 middle2 = a_low * b_high + (middle & 0xFFFFFFFF);
+            uint64 high = a_high * b_high + (middle >> 32) + (middle2 >> 32);
+            uint64 low = (middle2 << 32) | (low_low & 0xFFFFFFFF);
+            if ((first < 0) != (second < 0))
+            {
+                low = 0 - low;
+                high = ~high + (low == 0);
+            }
+            return wide{high, low};
+#endif
+        }
+
+        constexpr bool fits(wide number)
+        {
+            return number.high == ((number.low >> 63) ? ~0ULL : 0ULL);
+        }
+
+        //The low word of number / divisor, truncated toward zero like the int128 division in dec64.c
+        constexpr int64 divide(wide number, int64 divisor)
+        {
+#if defined(__SIZEOF_INT128__)
+            __extension__ typedef __int128 int128;
+            __extension__ typedef unsigned __int128 uint128;
+            int128 dividend = (int128) (((uint128) number.high << 64) | number.low);
+            return (int64) (dividend / divisor);
+#else
+            //Long division of the magnitudes, one bit at a time
+            bool negative = (int64) number.high < 0;
+            uint64 high = number.high, low = number.low;
+            if (negative)
+            {
+                low = 0 - low;
+                high = ~high + (low == 0);
+            }
+            uint64 d = magnitude(divisor);
+            uint64 quotient = 0, rest = 0;
+            for (int bit = 127; bit >= 0; bit--)
+            {
+                bool carry = (rest >> 63) != 0;
+                rest = (rest << 1) | ((bit >= 64 ? high >> (bit - 64) : low >> bit) & 1);
+                quotient <<= 1;
+                if (carry || rest >= d)
+                {
+                    rest -= d;
+                    quotient |= 1;
+                }
+            }
+            return with_sign(quotient, negative != (divisor < 0));
+#endif
+        }
+    }
+
+    constexpr int64 dec64_coefficient(int64 number)
+    {
+        return number >> 8;
+    }
+
+    constexpr int64 dec64_exponent(int64 number)
+    {
+        return detail::low_byte(number);
+    }
+
+    constexpr int64 dec64_digits(int64 coeff)
+    {
+        uint64 abs = detail::magnitude(coeff);
+        int bits = 64 - detail::leading_zeros(abs | 1);
+        int digits = (bits * 1233) >> 12;
+        return digits + (abs >= powers10[digits]);
+    }
+
+    constexpr int64 dec64_build(int64 coeff, int64 exp)
+    {
+        return (int64) (((uint64) coeff << 8) | (0x0FF & (uint64) exp));
+    }
+
+    constexpr int64 dec64_pack(int64 coeff, int64 exp)
+    {
+        //Zero is zero, unless it has the nan exponent
+        if (coeff == 0)
+            return exp != -128 ? 0 : DEC64_NAN;
+
+        bool negc = coeff < 0;
+        uint64 maxval = negc ? MAXNUM + 1 : MAXNUM;
+        uint64 abs = detail::magnitude(coeff);
+
+        //The coefficient takes the whole excess of the exponent in a single multiply
+        if (exp > 127)
+        {
+            int64 excess = exp - 127;
+            if (excess > 17 - dec64_digits(coeff) || abs * powers10[excess] > maxval)
+                return DEC64_NAN;
+            abs *= powers10[excess];
+            exp = 127;
+        }
+
+        //The digit count tells at once how many digits must be dropped
+        int64 drop = 0;
+        if (abs > maxval)
+        {
+            drop = dec64_digits(coeff) - 17;
+            if (abs / powers10[drop] > maxval)
+                drop++;
+        }
+        if (exp < -127 - drop)
+            drop = -127 - exp;
+
+        if (drop > 0)
+        {
+            //One division by the power of 10, rounding half away from zero
+            if (drop < 20)
+            {
+                uint64 divisor = powers10[drop];
+                uint64 quotient = abs / divisor;
+                uint64 rest = abs - quotient * divisor;
+                abs = quotient + (rest >= divisor / 2);
+            }
+            else
+                abs = 0;
+            exp += drop;
+
+            //Rounding up may carry into an extra digit
+            if (abs > maxval)
+            {
+                abs = (abs + 5) / 10;
+                exp++;
+            }
+
+            if (exp > 127)
+                return DEC64_NAN;
+        }
+
+        if (abs == 0)
+            return 0;
+
+        return dec64_build(detail::with_sign(abs, negc), exp);
+    }
+
+    constexpr int64 dec64_new(int64 coeff, int64 exp)
+    {
+        return dec64_pack(coeff, exp);
+    }
+
+    constexpr int64 dec64_add_proc(int64 augend, int64 addend, bool subtraction)
+    {
+        int64 exp1 = detail::low_byte(augend);
+        int64 exp2 = detail::low_byte(addend);
+
+        if (exp1 == -128 || exp2 == -128)
+            return DEC64_NAN;
+
+        int64 coeff1 = augend >> 8;
+        int64 coeff2 = addend >> 8;
+
+        //If one of the coefficients is zero, return the other argument
+        if (coeff1 == 0)
+            return coeff2 == 0 ? 0 : subtraction ? dec64_pack(-coeff2, exp2) : addend;
+        if (coeff2 == 0)
+            return augend;
+
+        //If the difference between exponents is bigger than 17, the bigger number isn't affected
+        if (exp1 - exp2 > 17 && exp1 - exp2 - dec64_digits(coeff2) > 17)
+            return augend;
+        if (exp2 - exp1 > 17 && exp2 - exp1 - dec64_digits(coeff1) > 17)
+            return subtraction ? dec64_pack(-coeff2, exp2) : addend;
+
+        //Keep the higher exponent on coeff1|exp1
+        bool inverted = exp1 < exp2;
+        if (inverted)
+        {
+            int64 temp = exp1;
+            exp1 = exp2;
+            exp2 = temp;
+            temp = coeff1;
+            coeff1 = coeff2;
+            coeff2 = temp;
+        }
+
+        bool neg1 = coeff1 < 0;
+        bool neg2 = coeff2 < 0;
+        coeff1 = neg1 ? -coeff1 : coeff1;
+        coeff2 = neg2 ? -coeff2 : coeff2;
+
+        //Scale coeff1 by as many powers of 10 as the exponent difference allows, while it
+        // stays under 18 digits and, when the magnitudes are added, under MAXNUM
+        int64 digits1 = dec64_digits(coeff1);
+        int64 shift = exp1 - exp2;
+        if (shift > 18 - digits1)
+            shift = 18 - digits1;
+        if (subtraction ? neg1 != neg2 : neg1 == neg2)
+        {
+            int64 fits = 16 - digits1;
+            if (fits >= 0 && coeff1 * (int64) powers10[fits + 1] < MAXNUM)
+                fits++;
+            if (shift > fits)
+                shift = fits;
+        }
+        if (shift > 0)
+        {
+            coeff1 *= (int64) powers10[shift];
+            exp1 -= shift;
+        }
+
+        //Divide the other coefficient, rounding half up
+        int64 expdiff = exp1 - exp2;
+        if (expdiff > 17)
+            return dec64_pack(neg1 != (subtraction && inverted) ? -coeff1 : coeff1, exp1);
+        if (expdiff > 0)
+        {
+            coeff2 /= (int64) powers10[expdiff - 1];
+            int64 round = coeff2 % 10;
+            coeff2 += round >= 5 ? 10 - round : 0;
+            coeff2 /= 10;
+        }
+
+        if (coeff2 == 0)
+            return !inverted ? augend : subtraction ? dec64_pack(-(addend >> 8), detail::low_byte(addend)) : addend;
+
+        coeff1 = neg1 ? -coeff1 : coeff1;
+        coeff2 = neg2 ? -coeff2 : coeff2;
+
+        int64 result = !subtraction ? coeff1 + coeff2 : inverted ? coeff2 - coeff1 : coeff1 - coeff2;
+        return dec64_pack(result, exp1);
+    }
+
+    constexpr int64 dec64_add(int64 augend, int64 addend)
+    {
+        return dec64_add_proc(augend, addend, false);
+    }
+
+    constexpr int64 dec64_subtract(int64 minuend, int64 subtrahend)
+    {
+        return dec64_add_proc(minuend, subtrahend, true);
+    }
+
+    constexpr int64 dec64_multiply(int64 multiplicand, int64 multiplier)
+    {
+        bool nan1 = detail::low_byte(multiplicand) == -128;
+        bool nan2 = detail::low_byte(multiplier) == -128;
+        int64 coeff1 = multiplicand >> 8;
+        int64 coeff2 = multiplier >> 8;
+
+        //The result is nan if one or both of the operands is nan and neither of the operands is zero
+        if ((nan1 && (coeff2 != 0 || nan2)) || (nan2 && (coeff1 != 0 || nan1)))
+            return DEC64_NAN;
+
+        int64 exp = (int64) detail::low_byte(multiplicand) + detail::low_byte(multiplier);
+        detail::wide product = detail::multiply(coeff1, coeff2);
+
+        if (detail::fits(product))
+            return product.low == 0 ? DEC64_ZERO : dec64_pack((int64) product.low, exp);
+
+        //Estimate the number of digits of excess from the high word
+        uint64 abs_high = detail::magnitude((int64) product.high);
+        int64 scale = (((63 - detail::leading_zeros(abs_high | 1)) * 77) >> 8) + 2;
+        return dec64_pack(detail::divide(product, (int64) powers10[scale]), exp + scale);
+    }
+
+    constexpr int64 dec64_divide(int64 dividend, int64 divisor)
+    {
+        bool nan1 = detail::low_byte(dividend) == -128;
+        bool nan2 = detail::low_byte(divisor) == -128;
+        int64 coeff1 = dividend >> 8;
+        int64 coeff2 = divisor >> 8;
+
+        if (coeff1 == 0 && !nan1)
+            return DEC64_ZERO;
+        if (nan1 || nan2 || coeff2 == 0)
+            return DEC64_NAN;
+
+        int64 exp = (int64) detail::low_byte(dividend) - detail::low_byte(divisor);
+        int bits2 = 63 - detail::leading_zeros(detail::magnitude(coeff2));
+        int bits1 = 63 - detail::leading_zeros(detail::magnitude(coeff1));
+        int scale = ((bits2 + 58 - bits1) * 77) >> 8;
+
+        //The largest power of 10 that can be held in an int64 is 1e18, so prescale the dividend
+        while (scale > 18)
+        {
+            int prescale = ((58 - bits1) * 77) >> 8;
+            coeff1 *= (int64) powers10[prescale];
+            exp -= prescale;
+            bits1 = 63 - detail::leading_zeros(detail::magnitude(coeff1));
+            scale = ((bits2 + 58 - bits1) * 77) >> 8;
+        }
+
+        detail::wide product = detail::multiply(coeff1, (int64) powers10[scale]);
+        return dec64_pack(detail::divide(product, coeff2), exp - scale);
+    }
+
+    //-1, 0 or 1, as dec64_compare_proc in dec64.c
+    constexpr int dec64_compare_proc(int64 comparahend, int64 comparator)
+    {
+        int64 coeff1 = comparahend >> 8;
+        int64 coeff2 = comparator >> 8;
+        int64 exp1 = detail::low_byte(comparahend);
+        int64 exp2 = detail::low_byte(comparator);
+
+        if ((coeff1 < 0) != (coeff2 < 0) || coeff1 == 0 || coeff2 == 0)
+            return (coeff1 > coeff2) - (coeff1 < coeff2);
+
+        int sign = coeff1 < 0 ? -1 : 1;
+        uint64 abs1 = detail::magnitude(coeff1);
+        uint64 abs2 = detail::magnitude(coeff2);
+        if (exp1 < exp2)
+        {
+            uint64 temp = abs1;
+            abs1 = abs2;
+            abs2 = temp;
+            int64 exp = exp1;
+            exp1 = exp2;
+            exp2 = exp;
+            sign = -sign;
+        }
+        int64 shift = exp1 - exp2;
+        if (shift > 18 - dec64_digits((int64) abs1))
+            return sign;
+        abs1 *= powers10[shift];
+        return abs1 > abs2 ? sign : abs1 < abs2 ? -sign : 0;
+    }
+
+    constexpr int64 dec64_is_equal(int64 comparahend, int64 comparator)
+    {
+        if (comparahend == comparator)
+            return DEC64_ONE;
+
+        //If the exponents match or if their signs are different, then return 0
+        if ((comparahend ^ comparator) < 0 || detail::low_byte(comparahend) == detail::low_byte(comparator))
+            return DEC64_ZERO;
+
+        if (detail::low_byte(comparahend) == -128 || detail::low_byte(comparator) == -128)
+            return DEC64_ZERO;
+        return dec64_compare_proc(comparahend, comparator) == 0 ? DEC64_ONE : DEC64_ZERO;
+    }
+
+    constexpr int64 dec64_is_less(int64 comparahend, int64 comparator)
+    {
+        if (detail::low_byte(comparahend) == -128 || detail::low_byte(comparator) == -128)
+            return DEC64_NAN;
+
+        //If the exponents are the same, or the signs are different, then do a simple compare
+        if (detail::low_byte(comparahend) == detail::low_byte(comparator) || (comparahend ^ comparator) < 0)
+            return comparahend < comparator ? DEC64_ONE : DEC64_ZERO;
+
+        return dec64_compare_proc(comparahend, comparator) < 0 ? DEC64_ONE : DEC64_ZERO;
+    }
+
+    constexpr int64 dec64_normal(int64 number)
+    {
+        if (detail::low_byte(number) == -128)
+            return DEC64_NAN;
+
+        int64 shifted = number & ~0xFFLL;
+        int64 exp = detail::low_byte(number);
+        if (shifted == 0)
+            return DEC64_ZERO;
+        if (exp == 0)
+            return number;
+
+        //While the exponent is positive, multiply by 10 until the coefficient would overflow
+        if (exp > 0)
+        {
+            while (exp > 0)
+            {
+                if (shifted > INT64_MAX / 10 || shifted < INT64_MIN / 10)
+                    return shifted | (exp & 0xFF);
+                shifted *= 10;
+                exp--;
+            }
+            return shifted;
+        }
+
+        //While the exponent is negative, divide by 10 as long as nothing is lost
+        int64 coeff = number >> 8;
+        while (exp < 0 && coeff % 10 == 0)
+        {
+            coeff /= 10;
+            exp++;
+        }
+        return dec64_build(coeff, exp);
+    }
+}
+
+#endif //DEC64_CONSTEXPR
@@ -0,0 +1,192 @@
+/* dec64_dispatch.c
+
+Runtime selection of the dec64 implementation, for DEC64_BACKEND=DISPATCH.
+
+dec64.c is compiled twice into the library: as the portable C port, with the
+dispatched functions named dec64_c_*, and with BMI2, ADX and LZCNT code
+generation, named dec64_bmi2_*. When NASM is available, dec64n.asm is also
+assembled with a nasm_ prefix. This file owns the public names of the
+dispatched functions, and each one makes an indirect call through a table.
+
+Each variant has a constant table, and the one in use is published as a single
+pointer, which is loaded and stored atomically, so a variant can be changed
+while other threads are calling. The pointer starts out at the portable C
+port, so it is always safe to call. A constructor sets it before main for the
+host processor:
+
+    bmi2    if the processor has BMI2, ADX and LZCNT. The compiler uses mulx
+            for the 128 bit products and lzcnt for counting digits.
+    c       otherwise.
+    nasm    only when asked for. The C port packs and aligns in closed form,
+            where the assembly loops one digit at a time.
+
+The DEC64_DISPATCH environment variable (c, nasm or bmi2) overrides the
+choice, for comparing variants on a host without rebuilding.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "dec64.h"
+#include "dec64_dispatch.h"
+
+#define NR_VARIANTS 3
+
+struct dec64_functions {
+    int variant;
+    dec64 (*new)(int64 coefficient, int64 exponent);
+    dec64 (*add)(dec64 augend, dec64 addend);
+    dec64 (*subtract)(dec64 minuend, dec64 subtrahend);
+    dec64 (*multiply)(dec64 multiplicand, dec64 multiplier);
+    dec64 (*divide)(dec64 dividend, dec64 divisor);
+    dec64 (*integer_divide)(dec64 dividend, dec64 divisor);
+    dec64 (*modulo)(dec64 dividend, dec64 divisor);
+    dec64 (*round)(dec64 number, dec64 place);
+};
+
+#define DECLARE_VARIANT(prefix)                                               \
+    extern dec64 prefix##new(int64 coefficient, int64 exponent);              \
+    extern dec64 prefix##add(dec64 augend, dec64 addend);                     \
+    extern dec64 prefix##subtract(dec64 minuend, dec64 subtrahend);           \
+    extern dec64 prefix##multiply(dec64 multiplicand, dec64 multiplier);      \
+    extern dec64 prefix##divide(dec64 dividend, dec64 divisor);               \
+    extern dec64 prefix##integer_divide(dec64 dividend, dec64 divisor);       \
+    extern dec64 prefix##modulo(dec64 dividend, dec64 divisor);               \
+    extern dec64 prefix##round(dec64 number, dec64 place);
+
+#define VARIANT_TABLE(variant, prefix) {                                      \
+    variant,                                                                  \
+    prefix##new,                                                              \
+    prefix##add,                                                              \
+    prefix##subtract,                                                         \
+    prefix##multiply,                                                         \
+    prefix##divide,                                                           \
+    prefix##integer_divide,                                                   \
+    prefix##modulo,                                                           \
+    prefix##round                                                             \
+}
+
+DECLARE_VARIANT(dec64_c_)
+#ifdef DEC64_DISPATCH_NASM
+DECLARE_VARIANT(nasm_dec64_)
+#endif
+#ifdef DEC64_DISPATCH_BMI2
+DECLARE_VARIANT(dec64_bmi2_)
+#endif
+
+static const struct dec64_functions c_functions
+    = VARIANT_TABLE(DEC64_VARIANT_C, dec64_c_);
+#ifdef DEC64_DISPATCH_NASM
+static const struct dec64_functions nasm_functions
+    = VARIANT_TABLE(DEC64_VARIANT_NASM, nasm_dec64_);
+#endif
+#ifdef DEC64_DISPATCH_BMI2
+static const struct dec64_functions bmi2_functions
+    = VARIANT_TABLE(DEC64_VARIANT_BMI2, dec64_bmi2_);
+#endif
+
+static const char* variant_names[NR_VARIANTS] = {"c", "nasm", "bmi2"};
+
+static const struct dec64_functions* table = &c_functions;
+
+static inline const struct dec64_functions* functions() {
+    return __atomic_load_n(&table, __ATOMIC_ACQUIRE);
+}
+
+static const struct dec64_functions* variant_functions(int which) {
+/*
+    The table of a variant, or NULL if it is not in this binary or cannot run
+    on this processor.
+*/
+    switch (which) {
+    case DEC64_VARIANT_C:
+        return &c_functions;
+#ifdef DEC64_DISPATCH_NASM
+    case DEC64_VARIANT_NASM:
+        return &nasm_functions;
+#endif
+#ifdef DEC64_DISPATCH_BMI2
+    case DEC64_VARIANT_BMI2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("bmi2")
+                && __builtin_cpu_supports("adx")
+                && __builtin_cpu_supports("lzcnt")
+            ? &bmi2_functions
+            : NULL;
+#endif
+    }
+    return NULL;
+}
+
+int dec64_dispatch_variant() {
+    return functions()->variant;
+}
+
+int dec64_dispatch_use(int which) {
+    const struct dec64_functions* wanted = variant_functions(which);
+    if (wanted != NULL) {
+        __atomic_store_n(&table, wanted, __ATOMIC_RELEASE);
+    }
+    return dec64_dispatch_variant();
+}
+
+const char* dec64_dispatch_name(int which) {
+    return which >= 0 && which < NR_VARIANTS ? variant_names[which] : NULL;
+}
+
+__attribute__((constructor))
+static void dispatch_select() {
+    const char* wanted = getenv("DEC64_DISPATCH");
+    int which;
+
+    if (wanted != NULL) {
+        for (which = 0; which < NR_VARIANTS; which += 1) {
+            if (strcmp(wanted, variant_names[which]) == 0) {
+                if (dec64_dispatch_use(which) == which) {
+                    return;
+                }
+                break;
+            }
+        }
+    }
+    if (dec64_dispatch_use(DEC64_VARIANT_BMI2) != DEC64_VARIANT_BMI2) {
+        dec64_dispatch_use(DEC64_VARIANT_C);
+    }
+}
+
+/* the public names */
+
+dec64 dec64_new(int64 coefficient, int64 exponent) {
+    return functions()->new(coefficient, exponent);
+}
+
+dec64 dec64_add(dec64 augend, dec64 addend) {
+    return functions()->add(augend, addend);
+}
+
+dec64 dec64_subtract(dec64 minuend, dec64 subtrahend) {
+    return functions()->subtract(minuend, subtrahend);
+}
+
+dec64 dec64_multiply(dec64 multiplicand, dec64 multiplier) {
+    return functions()->multiply(multiplicand, multiplier);
+}
+
+dec64 dec64_divide(dec64 dividend, dec64 divisor) {
+    return functions()->divide(dividend, divisor);
+}
+
+dec64 dec64_integer_divide(dec64 dividend, dec64 divisor) {
+    return functions()->integer_divide(dividend, divisor);
+}
+
+dec64 dec64_modulo(dec64 dividend, dec64 divisor) {
+    return functions()->modulo(dividend, divisor);
+}
+
+dec64 dec64_round(dec64 number, dec64 place) {
+    return functions()->round(number, place);
+}
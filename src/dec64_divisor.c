@@ -0,0 +1,215 @@
+/* dec64_divisor.c
+
+Division by a divisor that does not change.
+
+dec64_divide scales the coefficient of the dividend by a power of ten, so that
+the quotient has about 58 bits, and divides it by the coefficient of the
+divisor with a 128 by 64 bit division, which is one of the slowest instructions
+there is (or a library call). dec64_divide_by does the same scaling, but
+replaces the division with the method of Moller and Granlund ("Improved
+division by invariant integers", 2011): the divisor is shifted left until its
+top bit is set, and a reciprocal of it is computed once, in dec64_divisor_make.
+Each division is then a 64 by 64 bit multiply with a 128 bit product, a few
+additions and at most two corrections, and gives exactly the same quotient as
+the division. The quotient is then packed as dec64_new packs it in
+dec64_divide, so the results are identical.
+
+Without unsigned __int128, dec64_divide_by calls dec64_divide.
+
+Public Domain
+
+No warranty.
+*/
+
+#include "dec64_divisor.h"
+
+#if defined(__SIZEOF_INT128__)
+
+typedef unsigned __int128 uint128;
+
+#define MAXNUM 36028797018963967ULL
+
+static const uint64 powers10[] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL
+};
+
+static inline int bits_of(uint64 magnitude) {
+/*
+    The position of the highest set bit. magnitude is not zero.
+*/
+    return 63 - __builtin_clzll(magnitude);
+}
+
+dec64_divisor dec64_divisor_make(dec64 divisor) {
+/*
+    A nan or zero divisor leaves normalized at zero, and every quotient is nan
+    (except that zero divided by anything is zero). Otherwise the reciprocal is
+    floor((2^128 - 1) / normalized) - 2^64, which is the quotient of the 128
+    bit number with ~normalized on top and all ones below it.
+*/
+    dec64_divisor result;
+    int64 coefficient = divisor >> 8;
+    uint64 magnitude = coefficient < 0 ? 0 - (uint64)coefficient : (uint64)coefficient;
+
+    result.divisor = divisor;
+    result.normalized = 0;
+    result.reciprocal = 0;
+    result.shift = 0;
+    result.bits = 0;
+    if ((divisor & 0xFF) != 0x80 && magnitude != 0) {
+        result.bits = bits_of(magnitude);
+        result.shift = 63 - result.bits;
+        result.normalized = magnitude << result.shift;
+        result.reciprocal = (uint64)(
+            (((uint128)~result.normalized << 64) | ~0ULL) / result.normalized
+        );
+    }
+    return result;
+}
+
+static inline dec64 pack(uint64 magnitude, int negative, int64 exponent) {
+/*
+    dec64_new, for the quotients. They are under 2^59, so at most two digits
+    are dropped, and how many is told by comparing with the largest
+    coefficient times 10 and 100. Dropping them and rounding half away from
+    zero on the first one, as dec64_new does, is adding half of 10^drop and
+    dividing by 10^drop, which is one multiply by a magic number from a table.
+    Anything else is left to dec64_new.
+*/
+    static const uint64 halves[3] = {0, 5, 50};
+    static const uint64 magics[3] = {0, 0xCCCCCCCCCCCCCCCDULL, 0x28F5C28F5C28F5C3ULL};
+    static const int before[3] = {0, 0, 2};
+    static const int after[3] = {0, 3, 2};
+    uint64 largest = MAXNUM + (uint64)(negative != 0);
+    uint64 sign = 0 - (uint64)(negative != 0);
+    uint64 rounded;
+    uint64 keep;
+    int drop = (magnitude > largest) + (magnitude > largest * 10 + 9);
+
+    if (magnitude > largest * 100 + 99 || exponent > 127 || exponent + drop < -127) {
+        return dec64_new((int64)((magnitude ^ sign) - sign), exponent);
+    }
+    rounded = (uint64)(
+        ((uint128)((magnitude + halves[drop]) >> before[drop]) * magics[drop]) >> 64
+    ) >> after[drop];
+    keep = 0 - (uint64)(drop == 0);
+    magnitude = (magnitude & keep) | (rounded & ~keep);
+    exponent += drop;
+    if (magnitude > largest) {
+        magnitude = (magnitude + 5) / 10;
+        exponent += 1;
+    }
+    if (exponent > 127) {
+        return DEC64_NAN;
+    }
+    if (magnitude == 0) {
+        return DEC64_ZERO;
+    }
+    return (dec64)(((magnitude ^ sign) - sign) << 8) | (exponent & 0xFF);
+}
+
+static inline dec64 divide(dec64 dividend, const dec64_divisor* divisor) {
+/*
+    The scale is chosen exactly as in dec64_divide, so that the same number is
+    divided. The quotient is under 2^64, so the top of the shifted dividend is
+    under the normalized divisor, as the method needs.
+*/
+    int64 coefficient = dividend >> 8;
+    int64 exponent;
+    uint64 magnitude;
+    uint64 high;
+    uint64 low;
+    uint64 quotient;
+    uint64 remainder;
+    uint64 adjust;
+    uint128 scaled;
+    uint128 product;
+    int bits;
+    int scale;
+
+    if (coefficient == 0 && (dividend & 0xFF) != 0x80) {
+        return DEC64_ZERO;
+    }
+    if ((dividend & 0xFF) == 0x80 || divisor->normalized == 0) {
+        return DEC64_NAN;
+    }
+    exponent = (int64)(signed char)dividend - (signed char)divisor->divisor;
+    magnitude = coefficient < 0 ? 0 - (uint64)coefficient : (uint64)coefficient;
+    while (1) {
+        bits = bits_of(magnitude);
+        scale = ((divisor->bits + 58 - bits) * 77) >> 8;
+        if (scale <= 18) {
+            break;
+        }
+        scale = ((58 - bits) * 77) >> 8;
+        magnitude *= powers10[scale];
+        exponent -= scale;
+    }
+    scaled = ((uint128)magnitude * powers10[scale]) << divisor->shift;
+    high = (uint64)(scaled >> 64);
+    low = (uint64)scaled;
+    product = (uint128)divisor->reciprocal * high + scaled;
+    quotient = (uint64)(product >> 64) + 1;
+    remainder = low - quotient * divisor->normalized;
+    adjust = 0 - (uint64)(remainder > (uint64)product);
+    quotient += adjust;
+    remainder += adjust & divisor->normalized;
+    if (remainder >= divisor->normalized) {
+        quotient += 1;
+    }
+    return pack(quotient, (dividend < 0) != (divisor->divisor < 0), exponent - scale);
+}
+
+#else
+
+dec64_divisor dec64_divisor_make(dec64 divisor) {
+    dec64_divisor result;
+
+    result.divisor = divisor;
+    result.normalized = 0;
+    result.reciprocal = 0;
+    result.shift = 0;
+    result.bits = 0;
+    return result;
+}
+
+static inline dec64 divide(dec64 dividend, const dec64_divisor* divisor) {
+    return dec64_divide(dividend, divisor->divisor);
+}
+
+#endif
+
+dec64 dec64_divide_by(dec64 dividend, const dec64_divisor* divisor) {
+    return divide(dividend, divisor);
+}
+
+void dec64_divide_by_n(
+    dec64* quotients,
+    const dec64* dividends,
+    const dec64_divisor* divisor,
+    size_t n
+) {
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        quotients[at] = divide(dividends[at], divisor);
+    }
+}
@@ -0,0 +1,170 @@
+/* dec64_inline.h
+
+Inline fast paths for dec64_add, dec64_subtract, dec64_multiply, dec64_fma,
+dec64_is_equal and dec64_is_less.
+
+Most sums in money and ledger work have operands with the same exponent and
+small coefficients. In that case the packed words can be added directly: the
+coefficients occupy the high 56 bits, so once the exponents are masked off a
+64 bit add is a coefficient add, and a 64 bit overflow is a coefficient
+overflow. Anything else (nan, different exponents, overflow) falls back to the
+out-of-line function, so the results are always identical to dec64_add and
+dec64_subtract.
+
+In the same way, a product whose coefficient and exponent fit needs no
+packing, nor does a fused product and sum when the product has the exponent of
+the addend, and numbers with the same exponent compare as words.
+
+Because these are static inline, the compiler can fold the common case into
+the caller's loop instead of making a call per element.
+
+Public Domain
+
+No warranty.
+*/
+
+#ifndef DEC64_INLINE
+#define DEC64_INLINE
+
+#include "dec64.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define DEC64_ADD_OVERFLOW(a, b, result) __builtin_add_overflow((a), (b), (result))
+#define DEC64_SUB_OVERFLOW(a, b, result) __builtin_sub_overflow((a), (b), (result))
+#define DEC64_MUL_OVERFLOW(a, b, result) __builtin_mul_overflow((a), (b), (result))
+#else
+static inline int dec64_add_overflow(int64 a, int64 b, int64* result) {
+    *result = (int64)((uint64)a + (uint64)b);
+    return ((a ^ *result) & (b ^ *result)) < 0;
+}
+
+static inline int dec64_sub_overflow(int64 a, int64 b, int64* result) {
+    *result = (int64)((uint64)a - (uint64)b);
+    return ((a ^ b) & (a ^ *result)) < 0;
+}
+
+static inline int dec64_mul_overflow(int64 a, int64 b, int64* result) {
+/*
+    Conservative: factors of more than 31 bits are reported as overflow, which
+    only sends them to the out-of-line function.
+*/
+    if (
+        a > -2147483648LL && a < 2147483648LL
+        && b > -2147483648LL && b < 2147483648LL
+    ) {
+        *result = a * b;
+        return 0;
+    }
+    return 1;
+}
+
+#define DEC64_ADD_OVERFLOW(a, b, result) dec64_add_overflow((a), (b), (result))
+#define DEC64_SUB_OVERFLOW(a, b, result) dec64_sub_overflow((a), (b), (result))
+#define DEC64_MUL_OVERFLOW(a, b, result) dec64_mul_overflow((a), (b), (result))
+#endif
+
+static inline int dec64_inline_same_exponent(dec64 first, dec64 second) {
+/*
+    True if both numbers have the same exponent and it is not nan.
+*/
+    return ((first ^ second) & 0xFF) == 0 && (first & 0xFF) != 0x80;
+}
+
+static inline dec64 dec64_inline_add(dec64 augend, dec64 addend) {
+    int64 sum;
+    if (
+        dec64_inline_same_exponent(augend, addend)
+        && !DEC64_ADD_OVERFLOW(augend & ~0xFFLL, addend & ~0xFFLL, &sum)
+    ) {
+        return sum == 0 ? DEC64_ZERO : sum | (augend & 0xFF);
+    }
+    return dec64_add(augend, addend);
+}
+
+static inline dec64 dec64_inline_subtract(dec64 minuend, dec64 subtrahend) {
+    int64 difference;
+    if (
+        dec64_inline_same_exponent(minuend, subtrahend)
+        && !DEC64_SUB_OVERFLOW(
+            minuend & ~0xFFLL,
+            subtrahend & ~0xFFLL,
+            &difference
+        )
+    ) {
+        return difference == 0 ? DEC64_ZERO : difference | (minuend & 0xFF);
+    }
+    return dec64_subtract(minuend, subtrahend);
+}
+
+static inline dec64 dec64_inline_multiply(dec64 multiplicand, dec64 multiplier) {
+    int64 product;
+    int64 exponent = (int64)(signed char)multiplicand + (signed char)multiplier;
+    if (
+        (multiplicand & 0xFF) != 0x80
+        && (multiplier & 0xFF) != 0x80
+        && !DEC64_MUL_OVERFLOW(multiplicand >> 8, multiplier >> 8, &product)
+        && product >= -36028797018963968LL
+        && product <= 36028797018963967LL
+        && exponent >= -127
+        && exponent <= 127
+    ) {
+        return product == 0 ? DEC64_ZERO : (product << 8) | (exponent & 0xFF);
+    }
+    return dec64_multiply(multiplicand, multiplier);
+}
+
+static inline dec64 dec64_inline_fma(
+    dec64 multiplicand,
+    dec64 multiplier,
+    dec64 addend
+) {
+    int64 product;
+    int64 sum;
+    int64 exponent = (int64)(signed char)multiplicand + (signed char)multiplier;
+    if (
+        (multiplicand & 0xFF) != 0x80
+        && (multiplier & 0xFF) != 0x80
+        && (addend & 0xFF) != 0x80
+        && exponent == (signed char)addend
+        && !DEC64_MUL_OVERFLOW(multiplicand >> 8, multiplier >> 8, &product)
+        && !DEC64_ADD_OVERFLOW(product, addend >> 8, &sum)
+        && sum >= -36028797018963968LL
+        && sum <= 36028797018963967LL
+    ) {
+        return sum == 0 ? DEC64_ZERO : (sum << 8) | (addend & 0xFF);
+    }
+    return dec64_fma(multiplicand, multiplier, addend);
+}
+
+static inline dec64 dec64_inline_is_equal(dec64 comparahend, dec64 comparator) {
+/*
+    Numbers with the same exponent or with different signs are equal only if
+    they are the same word.
+*/
+    if (comparahend == comparator) {
+        return DEC64_ONE;
+    }
+    if (
+        ((comparahend ^ comparator) & 0xFF) == 0
+        || (comparahend ^ comparator) < 0
+    ) {
+        return DEC64_ZERO;
+    }
+    return dec64_is_equal(comparahend, comparator);
+}
+
+static inline dec64 dec64_inline_is_less(dec64 comparahend, dec64 comparator) {
+    if (
+        (comparahend & 0xFF) != 0x80
+        && (comparator & 0xFF) != 0x80
+        && (
+            ((comparahend ^ comparator) & 0xFF) == 0
+            || (comparahend ^ comparator) < 0
+        )
+    ) {
+        return comparahend < comparator ? DEC64_ONE : DEC64_ZERO;
+    }
+    return dec64_is_less(comparahend, comparator);
+}
+
+#endif //DEC64_INLINE
@@ -0,0 +1,402 @@
+/* dec64_parallel.c
+
+Reductions of large arrays of dec64 numbers over several threads.
+
+The array is cut into one contiguous part per thread. Each thread reduces its
+part on its own, and the caller then combines the partial results in the order
+of the parts:
+
+    sum     each part is summed into its own dec64_accum, and the accumulators
+            are merged. The sums are exact until dec64_accum_finish rounds
+            once, so the result does not depend on how the array was cut.
+    mean    the sum, divided by n.
+    dot     like the sum, with dec64_accum_add_products_n.
+    min     each part finds its smallest number, and the first of the smallest
+    max     wins, as it would in one pass from the left. That matters when
+            equal numbers are written differently, like 1 and 1.0.
+
+The scans are done in two passes. First each part is summed exactly, as for
+the sum, which gives every part a guess at the running total it starts with.
+Then each part is scanned from its guess with dec64_scan_inclusive or
+dec64_scan_exclusive. The scans must match one dec64_scan over the whole array,
+so the caller then checks the parts in order: a part whose guess is not the
+total that the part before it ended with is rescanned from that total. Since
+the scan only looks at the total and the next number, the rescan can stop as
+soon as it gets a total that the first scan also had.
+
+The guesses are right whenever the chain of dec64_add calls is exact, as with
+money, except that they can be written differently (2 and 2.0), and then the
+rescans are short. When the chain rounds, the parts after the rounding are
+rescanned, and the scan is no faster than one pass.
+
+A scan in place can not rescan numbers that it has already overwritten, so it
+first scans every part without writing to find where the part ends, fixes the
+starts, and only then writes.
+
+Parts are at least PART numbers long, so short arrays are done by the caller
+alone, and there are at most MAX_THREADS of them. Without POSIX threads, or
+if a thread can not be started, the caller does the parts itself, with the
+same result.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdlib.h>
+#include "dec64_parallel.h"
+#include "dec64_accum.h"
+#include "dec64_array.h"
+
+#ifdef DEC64_PARALLEL_PTHREADS
+#include <pthread.h>
+#endif
+
+#define PART 16384
+#define MAX_THREADS 256
+
+#define SUM 0
+#define MIN 1
+#define MAX 2
+#define DOT 3
+#define SCAN 4
+#define SCAN_EXCLUSIVE 5
+#define TRACE 6
+
+#define TRACE_BLOCK 256
+
+struct part {
+    const dec64* numbers;
+    const dec64* multipliers;
+    dec64* totals;
+    size_t n;
+    int operation;
+    int nan;
+    dec64 best;
+    dec64 start;
+    dec64 end;
+    dec64_accum accum;
+};
+
+static inline int is_less(dec64 comparahend, dec64 comparator) {
+/*
+    Neither number is nan. With the same exponent, the words compare as the
+    numbers do.
+*/
+    if (((comparahend ^ comparator) & 0xFF) == 0) {
+        return comparahend < comparator;
+    }
+    return dec64_is_less(comparahend, comparator) == DEC64_ONE;
+}
+
+static inline int is_better(int operation, dec64 number, dec64 best) {
+    return operation == MIN ? is_less(number, best) : is_less(best, number);
+}
+
+static dec64 trace(const dec64* numbers, size_t n, dec64 total) {
+/*
+    The total that a scan would end with, without writing the scan.
+*/
+    dec64 totals[TRACE_BLOCK];
+    size_t at;
+
+    for (at = 0; at < n; at += TRACE_BLOCK) {
+        total = dec64_scan_inclusive(
+            totals,
+            numbers + at,
+            n - at < TRACE_BLOCK ? n - at : TRACE_BLOCK,
+            total
+        );
+    }
+    return total;
+}
+
+static dec64 rescan(struct part* part, dec64 total, int exclusive) {
+/*
+    Scan the part again from the right start, until a total matches the one
+    that the first scan wrote. From there on, the first scan was right.
+*/
+    size_t at;
+
+    for (at = 0; at < part->n; at += 1) {
+        if (exclusive) {
+            if (part->totals[at] == total) {
+                return part->end;
+            }
+            part->totals[at] = total;
+            total = dec64_add(total, part->numbers[at]);
+        } else {
+            total = dec64_add(total, part->numbers[at]);
+            if (part->totals[at] == total) {
+                return part->end;
+            }
+            part->totals[at] = total;
+        }
+    }
+    return total;
+}
+
+static void* reduce(void* argument) {
+    struct part* part = (struct part*)argument;
+    const dec64* numbers = part->numbers;
+    size_t n = part->n;
+    int operation = part->operation;
+    size_t at;
+    dec64 number;
+    dec64 best;
+
+    if (operation == SUM) {
+        dec64_accum_init(&part->accum);
+        dec64_accum_add_n(&part->accum, numbers, n);
+        return NULL;
+    }
+    if (operation == DOT) {
+        dec64_accum_init(&part->accum);
+        dec64_accum_add_products_n(&part->accum, numbers, part->multipliers, n);
+        return NULL;
+    }
+    if (operation == SCAN || operation == SCAN_EXCLUSIVE) {
+        part->end = operation == SCAN
+            ? dec64_scan_inclusive(part->totals, numbers, n, part->start)
+            : dec64_scan_exclusive(part->totals, numbers, n, part->start);
+        return NULL;
+    }
+    if (operation == TRACE) {
+        part->end = trace(numbers, n, part->start);
+        return NULL;
+    }
+    best = n > 0 ? numbers[0] : DEC64_NAN;
+    part->nan = 0;
+    for (at = 0; at < n; at += 1) {
+        number = numbers[at];
+        if ((number & 0xFF) == 0x80) {
+            part->nan = 1;
+            break;
+        }
+        if (is_better(operation, number, best)) {
+            best = number;
+        }
+    }
+    part->best = best;
+    return NULL;
+}
+
+static void run(struct part* parts, int nr_parts) {
+/*
+    Start a thread for every part but the first, which the caller does.
+*/
+    int at;
+#ifdef DEC64_PARALLEL_PTHREADS
+    pthread_t threads[MAX_THREADS];
+    int started[MAX_THREADS];
+
+    for (at = 1; at < nr_parts; at += 1) {
+        started[at] = pthread_create(&threads[at], NULL, reduce, &parts[at]) == 0;
+    }
+    reduce(&parts[0]);
+    for (at = 1; at < nr_parts; at += 1) {
+        if (started[at]) {
+            pthread_join(threads[at], NULL);
+        } else {
+            reduce(&parts[at]);
+        }
+    }
+#else
+    for (at = 0; at < nr_parts; at += 1) {
+        reduce(&parts[at]);
+    }
+#endif
+}
+
+static int split(
+    struct part** parts,
+    const dec64* numbers,
+    const dec64* multipliers,
+    dec64* totals,
+    size_t n,
+    int nthreads
+) {
+/*
+    Cut the arrays into parts. *parts points at a single part, which is used if
+    there is only one, or if the parts can not be allocated.
+*/
+    int nr_parts = 1;
+    int at;
+    struct part* allocated;
+
+    if (nthreads > MAX_THREADS) {
+        nthreads = MAX_THREADS;
+    }
+    if (nthreads > 1 && n / PART > 1) {
+        nr_parts = n / PART < (size_t)nthreads ? (int)(n / PART) : nthreads;
+        allocated = (struct part*)malloc(sizeof(struct part) * nr_parts);
+        if (allocated == NULL) {
+            nr_parts = 1;
+        } else {
+            *parts = allocated;
+        }
+    }
+    for (at = 0; at < nr_parts; at += 1) {
+        (*parts)[at].numbers = numbers + n * at / nr_parts;
+        (*parts)[at].multipliers = multipliers + n * at / nr_parts;
+        (*parts)[at].totals = totals + n * at / nr_parts;
+        (*parts)[at].n = n * (at + 1) / nr_parts - n * at / nr_parts;
+    }
+    return nr_parts;
+}
+
+static dec64 parallel(
+    int operation,
+    const dec64* numbers,
+    const dec64* multipliers,
+    size_t n,
+    int nthreads
+) {
+    struct part single;
+    struct part* parts = &single;
+    int nr_parts = split(&parts, numbers, multipliers, NULL, n, nthreads);
+    int at;
+    dec64 result;
+
+    for (at = 0; at < nr_parts; at += 1) {
+        parts[at].operation = operation;
+    }
+    run(parts, nr_parts);
+    if (operation == SUM || operation == DOT) {
+        for (at = 1; at < nr_parts; at += 1) {
+            dec64_accum_merge(&parts[0].accum, &parts[at].accum);
+        }
+        result = dec64_accum_finish(&parts[0].accum);
+    } else {
+        result = parts[0].best;
+        for (at = 0; at < nr_parts; at += 1) {
+            if (parts[at].nan) {
+                result = DEC64_NAN;
+                break;
+            }
+            if (at > 0 && is_better(operation, parts[at].best, result)) {
+                result = parts[at].best;
+            }
+        }
+    }
+    if (parts != &single) {
+        free(parts);
+    }
+    return result;
+}
+
+dec64 dec64_parallel_dot(
+    const dec64* multiplicands,
+    const dec64* multipliers,
+    size_t n,
+    int nthreads
+) {
+    return parallel(DOT, multiplicands, multipliers, n, nthreads);
+}
+
+dec64 dec64_parallel_max(const dec64* numbers, size_t n, int nthreads) {
+    return parallel(MAX, numbers, numbers, n, nthreads);
+}
+
+dec64 dec64_parallel_mean(const dec64* numbers, size_t n, int nthreads) {
+    if (n == 0) {
+        return DEC64_NAN;
+    }
+    return dec64_divide(
+        parallel(SUM, numbers, numbers, n, nthreads),
+        dec64_new((int64)n, 0)
+    );
+}
+
+dec64 dec64_parallel_min(const dec64* numbers, size_t n, int nthreads) {
+    return parallel(MIN, numbers, numbers, n, nthreads);
+}
+
+static dec64 scan(
+    int operation,
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start,
+    int nthreads
+) {
+    struct part single;
+    struct part* parts = &single;
+    int nr_parts = split(&parts, numbers, numbers, totals, n, nthreads);
+    int in_place = totals == numbers;
+    int at;
+    dec64 total;
+    dec64_accum accum;
+
+    if (nr_parts == 1) {
+        return operation == SCAN
+            ? dec64_scan_inclusive(totals, numbers, n, start)
+            : dec64_scan_exclusive(totals, numbers, n, start);
+    }
+
+/*
+    The first pass: each part is summed, and the sums before it make its guess.
+*/
+
+    for (at = 0; at < nr_parts; at += 1) {
+        parts[at].operation = SUM;
+    }
+    run(parts, nr_parts);
+    dec64_accum_init(&accum);
+    dec64_accum_add(&accum, start);
+    for (at = 0; at < nr_parts; at += 1) {
+        parts[at].start = at == 0 ? start : dec64_accum_finish(&accum);
+        parts[at].operation = in_place ? TRACE : operation;
+        dec64_accum_merge(&accum, &parts[at].accum);
+    }
+
+/*
+    The second pass, and the fixes, in order.
+*/
+
+    run(parts, nr_parts);
+    total = parts[0].end;
+    for (at = 1; at < nr_parts; at += 1) {
+        if (parts[at].start != total) {
+            if (in_place) {
+                parts[at].start = total;
+                parts[at].end = trace(parts[at].numbers, parts[at].n, total);
+            } else {
+                parts[at].end = rescan(&parts[at], total, operation == SCAN_EXCLUSIVE);
+            }
+        }
+        total = parts[at].end;
+    }
+    if (in_place) {
+        for (at = 0; at < nr_parts; at += 1) {
+            parts[at].operation = operation;
+        }
+        run(parts, nr_parts);
+    }
+    free(parts);
+    return total;
+}
+
+dec64 dec64_parallel_scan_exclusive(
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start,
+    int nthreads
+) {
+    return scan(SCAN_EXCLUSIVE, totals, numbers, n, start, nthreads);
+}
+
+dec64 dec64_parallel_scan_inclusive(
+    dec64* totals,
+    const dec64* numbers,
+    size_t n,
+    dec64 start,
+    int nthreads
+) {
+    return scan(SCAN, totals, numbers, n, start, nthreads);
+}
+
+dec64 dec64_parallel_sum(const dec64* numbers, size_t n, int nthreads) {
+    return parallel(SUM, numbers, numbers, n, nthreads);
+}
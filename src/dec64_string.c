@@ -9,13 +9,38 @@ Public Domain
 No warranty.
 
 This file contains dec64_to_string and dec64_from_string, and dec64_string-*
-configuration functions.
+configuration functions, and dec64_to_chars and dec64_from_chars, which need
+no state object and work on buffers that are not \0 terminated.
+
+A state can be in the caller's storage, with dec64_string_state_init, and
+every thread has one of its own, from dec64_string_default.
+
+dec64_to_string_cached keeps the strings of numbers that are formatted again
+and again in a cache made by dec64_string_cache_begin.
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include "dec64.h"
 #include "dec64_string.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SSE2_SEARCH 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define THREAD_LOCAL _Thread_local
+#else
+#define THREAD_LOCAL __thread
+#endif
+
 static const int e = 'e';
 static const int64 confirmed = 0xFFDEADFACEC0DECELL;
 
@@ -39,186 +64,349 @@ static const int64 power[17] = {
     10000000000000000,
 };
 
+/*
+    The digits of 0 to 99, two characters each.
+*/
+
+static const dec64_string_char pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
 /* functions in service to dec64_to_string */
 
-static void digitize(dec64_string_state state) {
-    int64 coefficient;
-    int digit;
-    int place;
-
-    coefficient = dec64_coefficient(state->number);
-    if (coefficient < 0) {
-        coefficient = -coefficient;
-    }
-    state->nr_digits = 0;
-    state->nr_zeros = 0;
-    for (place = 16; place >= 0; place -= 1) {
-        digit = (int)(coefficient / power[place]);
-        state->digits[state->nr_digits] = digit + '0';
-        if (digit == 0) {
-            if (state->nr_digits != 0) {
-                state->nr_digits += 1;
-            }
-            state->nr_zeros += 1;
-        } else {
-            state->nr_digits += 1;
-            state->nr_zeros = 0;
-        }
-        coefficient -= digit * power[place];
-    }
+/*
+    The spec of a new state.
+*/
+
+static const struct dec64_string_spec defaults = {
+    0,              /* places */
+    3,              /* separation */
+    standard_mode,  /* mode */
+    '.',            /* decimal_point */
+    0               /* separator */
+};
+
+/*
+    The state of one thread that has not been given one, made on first use.
+*/
+
+static THREAD_LOCAL struct dec64_string_state default_state;
+
+/*
+    A conversion to characters writes only into a scratch on its own stack,
+    and only reads the spec, so a state can be shared by threads that convert
+    with it, as long as none of them configures it at the same time. The
+    digits of the last number are kept, for a column of repeated numbers.
+*/
+
+struct scratch {
+    const struct dec64_string_spec* spec;
+    dec64_string_char* string;
+    dec64 number;
+    int length;
+    int nr_digits;
+    int nr_zeros;
+    dec64_string_char digits[32];
+};
+
+static int bits_of(uint64 magnitude) {
+/*
+    The position of the highest set bit. magnitude is not zero.
+*/
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, magnitude);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(magnitude);
+#endif
 }
 
-static emit(dec64_string_state state, int c) {
-    if (state->string != NULL) {
-        if (c > 0) {
-            state->string[state->length] = (dec64_string_char)c;
-            state->length += 1;
-        }
+static void digitize_four(dec64_string_char* at, uint64 four) {
+/*
+    Deposit the four digits of a number under 10^4. Dividing by 100 is a
+    multiply and a shift.
+*/
+    uint64 high = (four * 5243) >> 19;
+
+    memcpy(at, pairs + 2 * high, 2);
+    memcpy(at + 2, pairs + 2 * (four - high * 100), 2);
+}
+
+static void digitize_eight(dec64_string_char* at, uint64 eight) {
+/*
+    Deposit the eight digits of a number under 10^8. Dividing by 10^4 is a
+    multiply and a shift.
+*/
+    uint64 high = (eight * 109951163) >> 40;
+
+    digitize_four(at, high);
+    digitize_four(at + 4, eight - high * 10000);
+}
+
+static void digitize(struct scratch* scratch) {
+/*
+    Put the digits of the coefficient in scratch->digits, without leading
+    zeros.
+    The number of digits comes from the position of the highest bit, and the
+    digits are deposited from the right, eight, then two at a time.
+*/
+    int64 coefficient = dec64_coefficient(scratch->number);
+    uint64 magnitude = coefficient < 0 ? 0 - (uint64)coefficient : (uint64)coefficient;
+    uint64 quotient;
+    int estimate;
+    int at;
+
+    estimate = ((bits_of(magnitude) + 1) * 1233) >> 12;
+    scratch->nr_digits = estimate + (magnitude >= (uint64)power[estimate]);
+    at = scratch->nr_digits;
+    while (at > 8) {
+        quotient = magnitude / 100000000;
+        at -= 8;
+        digitize_eight(scratch->digits + at, magnitude - quotient * 100000000);
+        magnitude = quotient;
+    }
+    while (at > 1) {
+        quotient = magnitude / 100;
+        at -= 2;
+        memcpy(
+            scratch->digits + at,
+            pairs + 2 * (magnitude - quotient * 100),
+            2
+        );
+        magnitude = quotient;
+    }
+    if (at > 0) {
+        scratch->digits[0] = (dec64_string_char)('0' + magnitude);
+    }
+    scratch->nr_zeros = 0;
+    while (scratch->digits[scratch->nr_digits - 1 - scratch->nr_zeros] == '0') {
+        scratch->nr_zeros += 1;
     }
 }
 
-static void emit_at(dec64_string_state state, int64 at) {
-    emit(
-        state,
-        (
-            at >= state->nr_digits || at < 0
-            ? '0'
-            : state->digits[at]
-        )
-    );
+static void emit(struct scratch* scratch, int c) {
+    if (c > 0) {
+        scratch->string[scratch->length] = (dec64_string_char)c;
+        scratch->length += 1;
+    }
 }
 
-static void emit_decimal_point(dec64_string_state state) {
-    emit(state, state->decimal_point);
+static void emit_decimal_point(struct scratch* scratch) {
+    emit(scratch, scratch->spec->decimal_point);
 }
 
-static void emit_digits(dec64_string_state state, int from, int to) {
-    int at;
-    for (at = from; at < to; at += 1) {
-        emit_at(state, at);
+static void emit_digits(struct scratch* scratch, int from, int to) {
+/*
+    Emit the digits from from up to to. Places before the first digit and
+    after the last are zeros. The digits are copied, and the zeros are set,
+    a run at a time.
+*/
+    dec64_string_char* string = scratch->string + scratch->length;
+    int stop;
+
+    if (from >= to) {
+        return;
+    }
+    scratch->length += to - from;
+    if (from < 0) {
+        stop = to < 0 ? to : 0;
+        memset(string, '0', stop - from);
+        string += stop - from;
+        from = stop;
+    }
+    stop = to < scratch->nr_digits ? to : scratch->nr_digits;
+    if (from < stop) {
+        memcpy(string, scratch->digits + from, stop - from);
+        string += stop - from;
+        from = stop;
+    }
+    if (from < to) {
+        memset(string, '0', to - from);
     }
 }
 
-static void emit_digits_separated(dec64_string_state state, int from, int to) {
+static void emit_digits_separated(struct scratch* scratch, int from, int to) {
     int sep;
-    if (state->separation <= 0) {
-        emit_digits(state, from, to);
+    if (scratch->spec->separation <= 0 || scratch->spec->separator <= 0) {
+        emit_digits(scratch, from, to);
+        return;
     }
-    sep = to % state->separation;
+    sep = to % scratch->spec->separation;
     if (sep <= 0) {
-        sep = state->separation;
+        sep = scratch->spec->separation;
     }
     while (1) {
-        emit_digits(state, from, sep);
+        emit_digits(scratch, from, sep);
         from = sep;
         if (from >= to) {
             break;
         }
-        emit(state, state->separator);
-        sep += state->separation;
+        emit(scratch, scratch->spec->separator);
+        sep += scratch->spec->separation;
     }
 }
 
-static void emit_end(dec64_string_state state) {
-    if (state->string != NULL) {
-        state->string[state->length] = 0;
-    }
+static void emit_end(struct scratch* scratch) {
+    scratch->string[scratch->length] = 0;
 }
 
-static void emit_exponent(dec64_string_state state, int64 exponent) {
+static void emit_exponent(struct scratch* scratch, int64 exponent) {
     int go = 0;
     if (exponent != 0) {
-        emit(state, e);
+        emit(scratch, e);
         if (exponent < 0) {
             exponent = -exponent;
-            emit(state, '-');
+            emit(scratch, '-');
         }
         if (exponent >= 100) {
-            emit(state, '1');
+            emit(scratch, '1');
             exponent -= 100;
             go = 1;
         }
         if (exponent >= 10 || go) {
-            emit(state, '0' + (dec64_string_char)(exponent / 10));
+            emit(scratch, '0' + (dec64_string_char)(exponent / 10));
         }
-        emit(state, '0' + exponent % 10);
+        emit(scratch, '0' + exponent % 10);
     }
 }
 
-static void emit_separator(dec64_string_state state) {
-    emit(state, state->separator);
+static void emit_separator(struct scratch* scratch) {
+    emit(scratch, scratch->spec->separator);
 }
 
-static void emit_engineering(dec64_string_state state) {
-    int64 exponent = dec64_exponent(state->number) + state->nr_digits;
-    int to = state->nr_digits - state->nr_zeros;
+static void emit_engineering(struct scratch* scratch) {
+    int64 exponent = dec64_exponent(scratch->number) + scratch->nr_digits;
+    int to = scratch->nr_digits - scratch->nr_zeros;
     int trine = (int)exponent % 3;
     if (trine <= 0) {
         trine += 3;
     }
-    emit_digits(state, 0, trine);
+    emit_digits(scratch, 0, trine);
     if (trine < to) {
-        emit_decimal_point(state);
-        emit_digits(state, trine, to);
+        emit_decimal_point(scratch);
+        emit_digits(scratch, trine, to);
     }
-    emit_exponent(state, exponent - trine);
+    emit_exponent(scratch, exponent - trine);
 }
 
-static void emit_scientific(dec64_string_state state) {
-    int64 exponent = dec64_exponent(state->number) + state->nr_digits;
-    int nr_digits = (state->nr_digits - state->nr_zeros);
-    int at = 1;
-    emit_at(state, 0);
-    if (at < nr_digits) {
-        emit_decimal_point(state);
-        emit_digits(state, 1, nr_digits);
+static void emit_scientific(struct scratch* scratch) {
+    int64 exponent = dec64_exponent(scratch->number) + scratch->nr_digits;
+    int nr_digits = (scratch->nr_digits - scratch->nr_zeros);
+    emit_digits(scratch, 0, 1);
+    if (1 < nr_digits) {
+        emit_decimal_point(scratch);
+        emit_digits(scratch, 1, nr_digits);
     }
-    emit_exponent(state, exponent - 1);
+    emit_exponent(scratch, exponent - 1);
 }
 
-static void emit_standard(dec64_string_state state) {
+static void emit_standard(struct scratch* scratch) {
     int from = 0;
     int to;
     int places;
     int sep = 0;
-    int64 exponent = dec64_exponent(state->number);
+    int64 exponent = dec64_exponent(scratch->number);
     if (exponent >= 0) {
-        to = state->nr_digits + (int)exponent;
-        if (to + state->places > 20) {
-            emit_scientific(state);
+        to = scratch->nr_digits + (int)exponent;
+        if (to + scratch->spec->places > 20) {
+            emit_scientific(scratch);
         } else {
-            emit_digits_separated(state, 0, to);
-            if (state->places > 0) {
-                emit_decimal_point(state);
-                emit_digits(state, to, state->places + to);
+            emit_digits_separated(scratch, 0, to);
+            if (scratch->spec->places > 0) {
+                emit_decimal_point(scratch);
+                emit_digits(scratch, to, scratch->spec->places + to);
             }
         }
     } else {
-        from = (int)exponent + state->nr_digits;
-        to = state->nr_digits - state->nr_zeros;
+        from = (int)exponent + scratch->nr_digits;
+        to = scratch->nr_digits - scratch->nr_zeros;
         if (from <= 0) {
             places = to - from;
             if (places > 18) {
-                emit_scientific(state);
+                emit_scientific(scratch);
             } else {
-                emit(state, '0');
-                emit_decimal_point(state);
-                if (places < state->places) {
-                    to = state->places + from;
+                emit(scratch, '0');
+                emit_decimal_point(scratch);
+                if (places < scratch->spec->places) {
+                    to = scratch->spec->places + from;
                 }
-                emit_digits(state, from, to);
+                emit_digits(scratch, from, to);
             }
         } else {
-            emit_digits_separated(state, 0, from);
-            emit_decimal_point(state);
-            if (to - from < state->places) {
-                to = state->places + from;
+            emit_digits_separated(scratch, 0, from);
+            emit_decimal_point(scratch);
+            if (to - from < scratch->spec->places) {
+                to = scratch->spec->places + from;
             }
-            emit_digits(state, from, to);
+            emit_digits(scratch, from, to);
         }
     }
 }
 
+static void emit_number(struct scratch* scratch, dec64 number) {
+/*
+    Emit the number in the mode of the spec. nan is the empty string, and
+    every zero is 0. They are told from the word itself, because dec64_is_nan
+    and dec64_is_zero return 1, not DEC64_TRUE.
+*/
+    if ((number & 0xFF) == 0x80) {
+        return;
+    }
+    if ((number >> 8) == 0) {
+        emit(scratch, '0');
+        return;
+    }
+    if (number != scratch->number) {
+        scratch->number = number;
+        digitize(scratch);
+    }
+    if (number < 0) {
+        emit(scratch, '-');
+    }
+    switch (scratch->spec->mode) {
+    case engineering_mode:
+        emit_engineering(scratch);
+        break;
+    case scientific_mode:
+        emit_scientific(scratch);
+        break;
+    case standard_mode:
+        emit_standard(scratch);
+        break;
+    }
+}
+
+static void begin_scratch(
+    struct scratch* scratch,
+    const struct dec64_string_spec* spec,
+    dec64_string_char* string
+) {
+    scratch->spec = spec;
+    scratch->string = string;
+    scratch->number = DEC64_NAN;
+    scratch->length = 0;
+    scratch->nr_digits = 0;
+    scratch->nr_zeros = 0;
+}
+
+static void configure(dec64_string_state state) {
+/*
+    The default configuration.
+*/
+    state->owned = 0;
+    state->spec = defaults;
+    state->valid = confirmed;
+}
+
 /* creation */
 
 dec64_string_state dec64_string_begin() {
@@ -232,29 +420,48 @@ dec64_string_state dec64_string_begin() {
         (dec64_string_state)malloc(sizeof (struct dec64_string_state))
     );
     if (state != NULL) {
-        state->decimal_point = '.';
-        state->mode = standard_mode;
-        state->nr_digits = 0;
-        state->nr_zeros = 0;
-        state->number = DEC64_NAN;
-        state->places = 0;
-        state->separation = 3;
-        state->separator = 0;
-        state->string = 0;
-        state->valid = confirmed;
+        configure(state);
+        state->owned = 1;
     }
     return state;
 }
 
+void dec64_string_state_init(struct dec64_string_state* state) {
+/*
+    Make a state object in storage that the caller owns, such as a local
+    variable or a member of a larger struct, with the default configuration.
+    Nothing is allocated, and it does not need dec64_string_end.
+*/
+    if (state != NULL) {
+        configure(state);
+    }
+}
+
+dec64_string_state dec64_string_default() {
+/*
+    The state object of the calling thread, with the default configuration
+    until the thread configures it. Every thread has its own, so it can be
+    configured and used without a lock. It lasts as long as the thread, and
+    must not be passed to dec64_string_end.
+*/
+    if (default_state.valid != confirmed) {
+        configure(&default_state);
+    }
+    return &default_state;
+}
+
 /* destruction */
 
 void dec64_string_end(dec64_string_state state) {
 /*
-    Dispose of the state object.
+    Dispose of the state object. A state made by dec64_string_state_init is
+    only marked as no longer valid, because its storage is the caller's.
 */
-    if (state != NULL && state->valid == confirmed) {
+    if (state != NULL && state->valid == confirmed && state != &default_state) {
         state->valid = 0;
-        free(state);
+        if (state->owned) {
+            free(state);
+        }
     }
 }
 
@@ -270,7 +477,7 @@ void dec64_string_engineering(dec64_string_state state) {
     be up to three digits before the decimal point.
 */
     if (state != NULL && state->valid == confirmed) {
-        state->mode = engineering_mode;
+        state->spec.mode = engineering_mode;
     }
 }
 
@@ -281,7 +488,7 @@ void dec64_string_scientific(dec64_string_state state) {
     prefixed with 'e' is appended if necessary.
 */
     if (state != NULL && state->valid == confirmed) {
-        state->mode = scientific_mode;
+        state->spec.mode = scientific_mode;
     }
 }
 
@@ -292,7 +499,7 @@ void dec64_string_standard(dec64_string_state state) {
     mode might be used instead.
 */
     if (state != NULL && state->valid == confirmed) {
-        state->mode = standard_mode;
+        state->spec.mode = standard_mode;
     }
 }
 
@@ -308,7 +515,7 @@ void dec64_string_decimal_point(
     dec64_to_string and dec64_from_string.
 */
     if (state != NULL && state->valid == confirmed) {
-        state->decimal_point = decimal_point;
+        state->spec.decimal_point = decimal_point;
     }
 }
 
@@ -318,7 +525,7 @@ void dec64_string_places(dec64_string_state state, dec64_string_char places) {
     standard mode. This is commonly used to format money values.
 */
     if (state != NULL && state->valid == confirmed) {
-        state->places = places;
+        state->spec.places = places;
     }
 }
 
@@ -332,7 +539,7 @@ void dec64_string_separation(dec64_string_state state, int separation) {
         if (separation < 2) {
             separation = 0;
         }
-        state->separation = separation;
+        state->spec.separation = separation;
     }
 }
 
@@ -349,18 +556,165 @@ void dec64_string_separator(
     dec64_from_string will ignore this character.
 */
     if (state != NULL && state->valid == confirmed) {
-        state->separator = separator;
+        state->spec.separator = separator;
     }
 }
 
-/* Action. */
+/* functions in service to dec64_from_string, dec64_from_chars and dec64_parse_column */
 
-dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
 /*
-    Convert a string into a dec64. If conversion is not possible for any
-    reason, the result will be DEC64_NAN.
+    The fast path reads the common shape of a number, -?\d+(\.\d+)?. Where
+    eight characters are left, they are loaded into a 64 bit word, and the
+    digits at the start of it are turned into a number with a few shifts and
+    three multiplies (SWAR, SIMD within a register, as in simdjson and
+    fast_float). The last few characters are taken one at a time. Anything
+    else, and numbers of more than 18 significant digits, are left to the
+    loops, which give the same results.
 */
-    int at;
+
+static const uint64 powers18[19] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL
+};
+
+static inline int count_trailing_zeros(uint64 word) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+static inline const dec64_string_char* eat_digits(
+    const dec64_string_char* at,
+    const dec64_string_char* last,
+    uint64* value
+) {
+/*
+    Add the digits at the start of the characters to *value, and return the
+    end of them, or NULL if *value would reach 10^18.
+*/
+    uint64 word;
+    uint64 nondigits;
+    int nr_digits;
+    int c;
+
+    while (last - at >= 8) {
+        memcpy(&word, at, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+/*
+    Digits are the bytes 0x30 to 0x39, which are 0 to 9 after the xor. Adding
+    0x76 to a byte sets its high bit if it is 10 or more. A carry out of a
+    byte that is not a digit can only spoil the bytes after it.
+*/
+        word ^= 0x3030303030303030ULL;
+        nondigits = ((word + 0x7676767676767676ULL) | word) & 0x8080808080808080ULL;
+        nr_digits = nondigits == 0 ? 8 : count_trailing_zeros(nondigits) >> 3;
+        if (nr_digits == 0) {
+            return at;
+        }
+        if (*value >= powers18[18 - nr_digits]) {
+            return NULL;
+        }
+/*
+    The first digit is in the low byte. Shift out the bytes that are not
+    digits, so that the digits are the last of eight, after zeros. Then pairs,
+    fours and all eight are put together.
+*/
+        word <<= 64 - 8 * nr_digits;
+        word = word * 10 + (word >> 8);
+        word = (
+            (word & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))
+            + ((word >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))
+        ) >> 32;
+        *value = *value * powers18[nr_digits] + (word & 0xFFFFFFFF);
+        at += nr_digits;
+        if (nr_digits < 8) {
+            return at;
+        }
+    }
+    while (at < last) {
+        c = *at;
+        if (c < '0' || c > '9') {
+            break;
+        }
+        if (*value >= powers18[17]) {
+            return NULL;
+        }
+        *value = *value * 10 + (c - '0');
+        at += 1;
+    }
+    return at;
+}
+
+static const dec64_string_char* from_simple(
+    const dec64_string_char* first,
+    const dec64_string_char* last,
+    dec64_string_char decimal_point,
+    dec64* number
+) {
+/*
+    Read a number of the shape -?\d+(\.\d+)? with at most 18 significant
+    digits, and return its end, or NULL if it is not of that shape. The digits
+    make the coefficient, and the digits after the decimal point make the
+    exponent, as in the loop of dec64_from_string.
+*/
+    const dec64_string_char* at = first;
+    const dec64_string_char* end;
+    uint64 value = 0;
+    int64 exponent = 0;
+    int negative = at < last && *at == '-';
+
+    at += negative;
+    end = eat_digits(at, last, &value);
+    if (end == NULL || end == at) {
+        return NULL;
+    }
+    at = end;
+    if (at < last && *at == decimal_point) {
+        at += 1;
+        end = eat_digits(at, last, &value);
+        if (end == NULL || end == at) {
+            return NULL;
+        }
+        exponent = at - end;
+        at = end;
+    }
+    *number = dec64_new(negative ? -(int64)value : (int64)value, exponent);
+    return at;
+}
+
+static dec64 from_characters(
+    const struct dec64_string_spec* spec,
+    const dec64_string_char* string,
+    int64 length
+) {
+/*
+    The loop of dec64_from_string, on the length characters of string. A \0
+    among them is not part of a number.
+*/
+    int64 at;
     int c;
     int digits;
     int leading;
@@ -373,13 +727,10 @@ dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
     int64 sign;
     int64 sign_exp;
 
-    if (state == NULL || state->valid != confirmed || string == NULL) {
-        return DEC64_NAN;
-    }
 /*
     Get the first character.
 */
-    c = string[0];
+    c = length > 0 ? string[0] : 0;
     coefficient = 0;
     digits = 0;
     exponent = 0;
@@ -390,7 +741,7 @@ dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
     Minus sign.
 */
     if (c == '-') {
-        c = string[1];
+        c = length > 1 ? string[1] : 0;
         at = 1;
         sign = -1;
     } else {
@@ -404,7 +755,7 @@ dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
 /*
     Skip the separator character.
 */
-        if (c != state->separator) {
+        if (c != spec->separator) {
 /*
     Is the character a zero?
 */
@@ -463,7 +814,7 @@ dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
     There is a decimal point. If there is more than one decimal point,
     return DEC64_NAN.
 */
-            } else if (c == state->decimal_point) {
+            } else if (c == spec->decimal_point) {
                 if (point) {
                     return DEC64_NAN;
                 }
@@ -478,17 +829,17 @@ dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
                         exp = 0;
                         sign_exp = 1;
                         at += 1;
-                        c = string[at];
+                        c = at < length ? string[at] : 0;
 /*
     Optional minus or plus
 */
                         if (c == '-') {
                             sign_exp = -1;
                             at += 1;
-                            c = string[at];
+                            c = at < length ? string[at] : 0;
                         } else if (c == '+') {
                             at += 1;
-                            c = string[at];
+                            c = at < length ? string[at] : 0;
                         }
 /*
     The exponent digits.
@@ -504,13 +855,13 @@ dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
                                 return DEC64_NAN;
                             }
                             at += 1;
-                            c = string[at];
+                            c = at < length ? string[at] : 0;
                         }
                     }
 /*
     If everything is ok, incorporate the exponent in the new number.
 */
-                    if (ok) {
+                    if (ok && at == length) {
                         return dec64_new(
                             sign * coefficient,
                             (sign_exp * exp) + exponent
@@ -527,18 +878,109 @@ dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
     Get the next charcter.
 */
         at += 1;
-        c = string[at];
+        c = at < length ? string[at] : 0;
     }
 /*
-    If everything is ok, return the number.
+    If everything is ok, and the loop was not stopped by a \0, return the
+    number.
 */
     return (
-        ok
+        ok && at == length
         ? dec64_new(sign * coefficient, exponent)
         : DEC64_NAN
     );
 }
 
+static int simple_fits(const struct dec64_string_spec* spec) {
+/*
+    The fast path can be used unless the separator or the decimal point could
+    be mistaken for a part of a number.
+*/
+    return (
+        (spec->separator < '0' || spec->separator > '9')
+        && spec->separator != '-'
+        && (spec->decimal_point < '0' || spec->decimal_point > '9')
+        && spec->decimal_point != '-'
+        && spec->decimal_point != spec->separator
+    );
+}
+
+static dec64 from_field(
+    const struct dec64_string_spec* spec,
+    const dec64_string_char* first,
+    const dec64_string_char* last,
+    int simple
+) {
+/*
+    Convert the characters from first up to last as dec64_from_string does.
+    Try the fast path if they start like a number.
+*/
+    const dec64_string_char* at = first + (first < last && *first == '-');
+    dec64 number;
+
+    if (simple && at < last && *at >= '0' && *at <= '9') {
+        if (from_simple(first, last, spec->decimal_point, &number) == last) {
+            return number;
+        }
+    }
+    return from_characters(spec, first, last - first);
+}
+
+static const dec64_string_char* find_separator(
+    const dec64_string_char* at,
+    const dec64_string_char* last,
+    dec64_string_char separator
+) {
+/*
+    The first separator from at, or last if there is none. With SSE2, which
+    every x86-64 has, 16 characters are compared at a time. Elsewhere, memchr
+    does the search.
+*/
+#ifdef SSE2_SEARCH
+    __m128i wanted = _mm_set1_epi8(separator);
+    int mask;
+
+    while (last - at >= 16) {
+        mask = _mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)at), wanted)
+        );
+        if (mask != 0) {
+            return at + count_trailing_zeros((uint64)mask);
+        }
+        at += 16;
+    }
+    while (at < last && *at != separator) {
+        at += 1;
+    }
+    return at;
+#else
+    const dec64_string_char* found = (const dec64_string_char*)memchr(
+        at,
+        separator,
+        last - at
+    );
+    return found != NULL ? found : last;
+#endif
+}
+
+/* Action. */
+
+dec64 dec64_from_string(dec64_string_state state, dec64_string_char string[]) {
+/*
+    Convert a string into a dec64. If conversion is not possible for any
+    reason, the result will be DEC64_NAN.
+*/
+    if (state == NULL || state->valid != confirmed || string == NULL) {
+        return DEC64_NAN;
+    }
+    return from_field(
+        &state->spec,
+        string,
+        string + strlen(string),
+        simple_fits(&state->spec)
+    );
+}
+
 int dec64_to_string(
     dec64_string_state state,
     dec64 number,
@@ -559,37 +1001,406 @@ int dec64_to_string(
     trailing zeros or zeros immediately after the decimal point. In that
     case scientific notation will be used instead.
 */
+    struct scratch scratch;
+    dec64_string_char count[256];
+
     if (state == NULL || state->valid != confirmed) {
         return 0;
     }
+    begin_scratch(&scratch, &state->spec, string != NULL ? string : count);
+    emit_number(&scratch, number);
+    emit_end(&scratch);
+    return scratch.length;
+}
 
-    state->length = 0;
-    state->string = string;
-    if (dec64_is_nan(number) != DEC64_TRUE) {
-        if (dec64_is_zero(number) == DEC64_TRUE) {
-            emit(state, '0');
-        } else {
-            if (number != state->number) {
-                state->number = number;
-                digitize(state);
-            }
-            if (number < 0) {
-                emit(state, '-');
-            }
-            switch (state->mode) {
-            case engineering_mode:
-                emit_engineering(state);
-                break;
-            case scientific_mode:
-                emit_scientific(state);
+size_t dec64_format_column(
+    dec64_string_state state,
+    const dec64* numbers,
+    size_t n,
+    dec64_string_char separator,
+    dec64_string_char* buffer,
+    size_t capacity,
+    size_t* cursor
+) {
+/*
+    dec64_format_column converts the numbers as dec64_to_string does, into
+    the buffer, with the separator between them, and returns the number of
+    characters deposited. No \0 is added. The state is checked once, not for
+    every number, and it is only read, so it can be shared.
+
+    *cursor is the number to start with, 0 for a new column. It is advanced
+    past the numbers that were deposited, so the caller can loop while it is
+    less than n, starting every call after the first with a separator. The
+    buffer must have room for the longest number and a separator, which is 65
+    characters plus the places. If it does not, nothing is deposited and
+    *cursor is left alone. Otherwise every call deposits at least one number.
+
+    While there is room for the longest number, the characters are deposited
+    in place. Near the end of the buffer, they are made in a scratch buffer
+    and copied if they fit.
+*/
+    struct scratch scratch;
+    dec64_string_char near_end[256];
+    size_t length = 0;
+    size_t longest;
+    size_t at;
+
+    if (
+        state == NULL
+        || state->valid != confirmed
+        || buffer == NULL
+        || cursor == NULL
+    ) {
+        return 0;
+    }
+    longest = 65 + (state->spec.places > 0 ? state->spec.places : 0);
+    if (capacity < longest) {
+        return 0;
+    }
+    begin_scratch(&scratch, &state->spec, NULL);
+    at = *cursor;
+    while (at < n) {
+        scratch.string = (
+            capacity - length >= longest
+            ? buffer + length
+            : near_end
+        );
+        scratch.length = 0;
+        if (at > 0) {
+            emit(&scratch, separator);
+        }
+        emit_number(&scratch, numbers[at]);
+        if (scratch.string == near_end) {
+            if ((size_t)scratch.length > capacity - length) {
                 break;
-            case standard_mode:
-                emit_standard(state);
+            }
+            memcpy(buffer + length, near_end, scratch.length);
+        }
+        length += scratch.length;
+        at += 1;
+    }
+    *cursor = at;
+    return length;
+}
+
+size_t dec64_parse_column(
+    dec64_string_state state,
+    const dec64_string_char* buffer,
+    size_t length,
+    int last_chunk,
+    dec64_string_char separator,
+    dec64* numbers,
+    size_t max,
+    size_t* consumed,
+    size_t* errors,
+    size_t* nr_errors
+) {
+/*
+    dec64_parse_column converts the fields of the buffer, which are separated
+    by the separator, as dec64_from_string does, into numbers, until there are
+    max of them or the buffer ends. The fields are read in place. A separator
+    at the end of the buffer does not start another field. It returns the
+    number of fields, and sets *consumed to the number of characters used,
+    including the separator after the last field, so the next call can start
+    there.
+
+    A field is only taken when a separator ends it, because the rest of it
+    could be in the next chunk that the caller reads. The characters after
+    the last separator are left unconsumed, unless last_chunk is not 0, when
+    the end of the buffer ends the last field too.
+
+    A field that is not a number is nan, and its index is put in errors, which
+    must have room for max indices, and counted in *nr_errors. consumed,
+    errors, and nr_errors can be NULL.
+*/
+    const dec64_string_char* at = buffer;
+    const dec64_string_char* last = buffer + length;
+    const dec64_string_char* end;
+    size_t n = 0;
+    size_t nr_bad = 0;
+    int simple;
+
+    if (state != NULL && state->valid == confirmed && buffer != NULL) {
+        simple = simple_fits(&state->spec);
+        while (n < max && at < last) {
+            end = find_separator(at, last, separator);
+            if (end == last && !last_chunk) {
                 break;
             }
+            numbers[n] = from_field(&state->spec, at, end, simple);
+            if ((numbers[n] & 0xFF) == 0x80) {
+                if (errors != NULL) {
+                    errors[nr_bad] = n;
+                }
+                nr_bad += 1;
+            }
+            n += 1;
+            at = end + (end < last);
         }
     }
-    emit_end(state);
-    state->string = NULL;
-    return state->length;
+    if (consumed != NULL) {
+        *consumed = at - buffer;
+    }
+    if (nr_errors != NULL) {
+        *nr_errors = nr_bad;
+    }
+    return n;
+}
+
+/* the cache of dec64_to_string_cached */
+
+/*
+    The cache is direct mapped. The number and the spec are hashed by a
+    multiply, whose top bits choose the one entry that they can be in. An
+    entry holds a string of fewer than 32 characters with its \0, so a hit is
+    a copy of 32 characters. Longer strings, which take many places, are not
+    kept. An empty entry has a spec that no state can have.
+*/
+
+#define MAX_CACHE_BITS 20
+
+static uint64 spec_key(const struct dec64_string_spec* spec) {
+/*
+    The whole spec in one word. places and the characters are bytes, and
+    separation is not negative.
+*/
+    return (
+        (uint64)(unsigned char)spec->places
+        | ((uint64)(unsigned char)spec->decimal_point << 8)
+        | ((uint64)(unsigned char)spec->separator << 16)
+        | ((uint64)spec->mode << 24)
+        | ((uint64)(unsigned int)spec->separation << 32)
+    );
+}
+
+dec64_string_cache dec64_string_cache_begin(size_t nr_entries) {
+/*
+    Create a cache of formatted strings for dec64_to_string_cached, with
+    nr_entries rounded up to a power of two, from 2 to 2^20. Each entry takes
+    56 bytes. It can return NULL if memory allocation fails.
+*/
+    dec64_string_cache cache;
+    size_t at;
+    int bits = 1;
+
+    while (((size_t)1 << bits) < nr_entries && bits < MAX_CACHE_BITS) {
+        bits += 1;
+    }
+    cache = (dec64_string_cache)malloc(sizeof (struct dec64_string_cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->entries = (struct dec64_string_entry*)malloc(
+        sizeof (struct dec64_string_entry) << bits
+    );
+    if (cache->entries == NULL) {
+        free(cache);
+        return NULL;
+    }
+    for (at = 0; at < ((size_t)1 << bits); at += 1) {
+        cache->entries[at].number = DEC64_NAN;
+        cache->entries[at].spec = ~0ULL;
+        cache->entries[at].length = 0;
+    }
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->shift = 64 - bits;
+    cache->valid = confirmed;
+    return cache;
+}
+
+void dec64_string_cache_end(dec64_string_cache cache) {
+/*
+    Dispose of the cache.
+*/
+    if (cache != NULL && cache->valid == confirmed) {
+        cache->valid = 0;
+        free(cache->entries);
+        free(cache);
+    }
+}
+
+size_t dec64_string_cache_hits(dec64_string_cache cache) {
+/*
+    The number of conversions that were found in the cache.
+*/
+    if (cache == NULL || cache->valid != confirmed) {
+        return 0;
+    }
+    return cache->hits;
+}
+
+size_t dec64_string_cache_misses(dec64_string_cache cache) {
+/*
+    The number of conversions that were not found in the cache.
+*/
+    if (cache == NULL || cache->valid != confirmed) {
+        return 0;
+    }
+    return cache->misses;
+}
+
+int dec64_to_string_cached(
+    dec64_string_state state,
+    dec64_string_cache cache,
+    dec64 number,
+    dec64_string_char string[]
+) {
+/*
+    dec64_to_string_cached converts as dec64_to_string does, and gives the
+    same result, but first looks for the number, formatted by the same spec,
+    in the cache. A miss is converted and kept in the cache, replacing what
+    was in its entry. The cache is changed by every call, so a thread should
+    have its own. Without a valid cache, it is dec64_to_string.
+*/
+    struct dec64_string_entry* entry;
+    struct scratch scratch;
+    dec64_string_char converted[256];
+    uint64 spec;
+
+    if (cache == NULL || cache->valid != confirmed) {
+        return dec64_to_string(state, number, string);
+    }
+    if (state == NULL || state->valid != confirmed) {
+        return 0;
+    }
+    spec = spec_key(&state->spec);
+    entry = &cache->entries[
+        ((uint64)number ^ spec) * 0x9E3779B97F4A7C15ULL >> cache->shift
+    ];
+    if (entry->number == number && entry->spec == spec) {
+        cache->hits += 1;
+        if (string != NULL) {
+            memcpy(string, entry->chars, 32);
+        }
+        return entry->length;
+    }
+    cache->misses += 1;
+    begin_scratch(&scratch, &state->spec, converted);
+    emit_number(&scratch, number);
+    emit_end(&scratch);
+    if (scratch.length < 32) {
+        entry->number = number;
+        entry->spec = spec;
+        entry->length = scratch.length;
+        memcpy(entry->chars, converted, 32);
+    }
+    if (string != NULL) {
+        memcpy(string, converted, scratch.length + 1);
+    }
+    return scratch.length;
+}
+
+const dec64_string_char* dec64_from_chars(
+    const dec64_string_char* first,
+    const dec64_string_char* last,
+    dec64* number
+) {
+/*
+    dec64_from_chars converts the longest number at the start of the
+    characters from first up to last, which need not end with \0. The number is
+    written as dec64_from_string reads it without separators: an optional
+    minus sign, digits with at most one '.' among them, and an optional
+    exponent. The number goes in *number, and the end of it is returned. If
+    there is no number, first is returned and *number is DEC64_NAN.
+
+    An 'e' that is not followed by exponent digits is not part of the number.
+*/
+    const dec64_string_char* at = first;
+    const dec64_string_char* end;
+    int64 coefficient = 0;
+    int64 exponent = 0;
+    int64 exp = 0;
+    int64 sign = 1;
+    int64 sign_exp = 1;
+    int digits = 0;
+    int ok = 0;
+    int point = 0;
+
+/*
+    The fast path, unless an exponent follows.
+*/
+    end = from_simple(first, last, '.', number);
+    if (end != NULL && (end == last || (*end != 'e' && *end != 'E'))) {
+        return end;
+    }
+    if (at < last && *at == '-') {
+        sign = -1;
+        at += 1;
+    }
+/*
+    The coefficient. As in dec64_from_string, only the first 18 digits are
+    accumulated, and the excess digits only move the exponent.
+*/
+    for (; at < last; at += 1) {
+        if (*at >= '0' && *at <= '9') {
+            ok = 1;
+            if (coefficient == 0 && *at == '0') {
+                exponent -= point;
+            } else if (digits < 18) {
+                digits += 1;
+                coefficient = coefficient * 10 + (*at - '0');
+                exponent -= point;
+            } else {
+                exponent += 1 - point;
+            }
+        } else if (*at == '.' && !point) {
+            point = 1;
+        } else {
+            break;
+        }
+    }
+    if (!ok) {
+        *number = DEC64_NAN;
+        return first;
+    }
+/*
+    The exponent. Past 100000 it is nan or zero anyway, so it stops growing.
+*/
+    end = at;
+    if (at < last && (*at == 'e' || *at == 'E')) {
+        at += 1;
+        if (at < last && (*at == '-' || *at == '+')) {
+            sign_exp = *at == '-' ? -1 : 1;
+            at += 1;
+        }
+        for (; at < last && *at >= '0' && *at <= '9'; at += 1) {
+            end = at + 1;
+            if (exp < 100000) {
+                exp = exp * 10 + (*at - '0');
+            }
+        }
+    }
+    *number = dec64_new(sign * coefficient, sign_exp * exp + exponent);
+    return end;
+}
+
+dec64_string_char* dec64_to_chars(
+    dec64_string_char* first,
+    dec64_string_char* last,
+    dec64 number,
+    enum dec64_string_mode mode
+) {
+/*
+    dec64_to_chars converts a number as dec64_to_string does in the given mode
+    with the default configuration, into the characters from first up to
+    last. No \0 is added. It returns the end of the characters, or NULL if
+    they do not fit. nan is no characters at all. With room for 32
+    characters, which is always enough, they are deposited in place.
+*/
+    struct dec64_string_spec spec = defaults;
+    struct scratch scratch;
+    dec64_string_char string[32];
+
+    spec.mode = mode;
+    begin_scratch(&scratch, &spec, last - first >= 32 ? first : string);
+    emit_number(&scratch, number);
+    if (scratch.string == first) {
+        return first + scratch.length;
+    }
+    if (last - first < scratch.length) {
+        return NULL;
+    }
+    memcpy(first, string, scratch.length);
+    return first + scratch.length;
 }
@@ -9,6 +9,8 @@ Public Domain
 No warranty.
 */
 
+#include <stddef.h>
+
 enum dec64_string_mode {
     engineering_mode,
     scientific_mode,
@@ -17,30 +19,60 @@ enum dec64_string_mode {
 
 typedef char dec64_string_char;
 
-typedef struct dec64_string_state {
+struct dec64_string_spec {
 /*
-    For internal use only.
+    The format spec. It is only read by the conversions.
 */
-    dec64 valid;
-    dec64 number;
-    dec64_string_char* string;
-    int digits[32];
-    int length;
-    int nr_digits;
-    int nr_zeros;
     int places;
     int separation;
     enum dec64_string_mode mode;
     dec64_string_char decimal_point;
     dec64_string_char separator;
+};
+
+typedef struct dec64_string_state {
+/*
+    For internal use only. The struct is public so that the caller can own
+    the storage, with dec64_string_state_init.
+*/
+    dec64 valid;
+    struct dec64_string_spec spec;
+    int owned;
 }  * dec64_string_state;
 
+struct dec64_string_entry {
+/*
+    For internal use only.
+*/
+    dec64 number;
+    uint64 spec;
+    int length;
+    dec64_string_char chars[32];
+};
+
+typedef struct dec64_string_cache {
+/*
+    For internal use only.
+*/
+    dec64 valid;
+    struct dec64_string_entry* entries;
+    size_t hits;
+    size_t misses;
+    int shift;
+}  * dec64_string_cache;
+
 /*
     creation
 */
 
 extern dec64_string_state dec64_string_begin();
 
+extern void dec64_string_state_init(
+    struct dec64_string_state* state
+);
+
+extern dec64_string_state dec64_string_default();
+
 /*
     destruction
 */
@@ -99,3 +131,74 @@ extern int dec64_to_string(
     dec64 number,
     dec64_string_char string[]
 );
+
+/*
+    column action
+*/
+
+extern size_t dec64_format_column(
+    dec64_string_state state,
+    const dec64* numbers,
+    size_t n,
+    dec64_string_char separator,
+    dec64_string_char* buffer,
+    size_t capacity,
+    size_t* cursor
+);
+
+extern size_t dec64_parse_column(
+    dec64_string_state state,
+    const dec64_string_char* buffer,
+    size_t length,
+    int last_chunk,
+    dec64_string_char separator,
+    dec64* numbers,
+    size_t max,
+    size_t* consumed,
+    size_t* errors,
+    size_t* nr_errors
+);
+
+/*
+    cached action
+*/
+
+extern dec64_string_cache dec64_string_cache_begin(
+    size_t nr_entries
+);
+
+extern void dec64_string_cache_end(
+    dec64_string_cache cache
+);
+
+extern size_t dec64_string_cache_hits(
+    dec64_string_cache cache
+);
+
+extern size_t dec64_string_cache_misses(
+    dec64_string_cache cache
+);
+
+extern int dec64_to_string_cached(
+    dec64_string_state state,
+    dec64_string_cache cache,
+    dec64 number,
+    dec64_string_char string[]
+);
+
+/*
+    stateless action, on characters from first up to last
+*/
+
+extern const dec64_string_char* dec64_from_chars(
+    const dec64_string_char* first,
+    const dec64_string_char* last,
+    dec64* number
+);
+
+extern dec64_string_char* dec64_to_chars(
+    dec64_string_char* first,
+    dec64_string_char* last,
+    dec64 number,
+    enum dec64_string_mode mode
+);
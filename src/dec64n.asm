@@ -164,6 +164,23 @@ global dec64_signum;(number: dec64)
 ;global dec64_new;(coefficient: int64, exponent: int64);   returns number: dec64
 ;global dec64_subtract;(minuend: dec64, subtrahend: dec64);   returns d%ifference: dec64
 
+; The functions above are normally provided by dec64.c. When this file is
+; assembled with DEC64_EXPORT_ALL (and a --prefix, so the names do not collide
+; with the C port), every routine is exported. dec64_bench uses that to compare
+; the C port against this file.
+
+%ifdef DEC64_EXPORT_ALL
+global dec64_add
+global dec64_ceiling
+global dec64_coefficient
+global dec64_dec
+global dec64_exponent
+global dec64_floor
+global dec64_inc
+global dec64_new
+global dec64_subtract
+%endif
+
 ;  -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- -- --
 
 ; Repair the register names. Over the long and twisted evolution of x86, the
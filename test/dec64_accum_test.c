@@ -0,0 +1,297 @@
+/* dec64_accum_test.c
+
+This is a test of dec64_accum.c.
+
+Where a chain of dec64_add is exact (money and integers with one exponent),
+the accumulator must give exactly the same words. Where the chain rounds, the
+accumulator must give the exact sum, rounded once. Splitting a column into
+pieces that are merged, in any order, must not change the result.
+
+dec64_dot is checked against chains of dec64_multiply and dec64_add where
+those are exact, and against dec64_fma, which also rounds once, for two
+products where the second one is exact.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "dec64.h"
+#include "dec64_accum.h"
+#include "dec64_harness.h"
+
+#define MAX_N 1000
+
+static dec64 column[MAX_N];
+static dec64 weights[MAX_N];
+static dec64 strided[MAX_N * 3];
+
+static const size_t lengths[] = {0, 1, 2, 63, 64, 65, 127, 128, 129, 1000};
+
+/* judgement */
+
+static void judge(const char* name, size_t n, dec64 expected, dec64 actual) {
+    if (judged(expected, actual)) {
+        printf("\n\nFAIL %s n=%i", name, (int)n);
+        if (level >= 2) {
+            print_mismatch(expected, actual);
+        }
+    }
+}
+
+static dec64 sum_of(const dec64* numbers, size_t n) {
+    dec64_accum accum;
+
+    dec64_accum_init(&accum);
+    dec64_accum_add_n(&accum, numbers, n);
+    return dec64_accum_finish(&accum);
+}
+
+static void test_sum(const char* name, const dec64* numbers, size_t n, dec64 expected) {
+/*
+    The sum is taken with add_n, with add one at a time, and in two pieces
+    that are merged both ways around.
+*/
+    dec64_accum accum;
+    dec64_accum other;
+    size_t at;
+    size_t split = n / 3;
+
+    judge(name, n, expected, sum_of(numbers, n));
+    dec64_accum_init(&accum);
+    for (at = 0; at < n; at += 1) {
+        dec64_accum_add(&accum, numbers[at]);
+    }
+    judge(name, n, expected, dec64_accum_finish(&accum));
+    dec64_accum_init(&accum);
+    dec64_accum_init(&other);
+    dec64_accum_add_n(&accum, numbers, split);
+    dec64_accum_add_n(&other, numbers + split, n - split);
+    dec64_accum_merge(&accum, &other);
+    judge(name, n, expected, dec64_accum_finish(&accum));
+    dec64_accum_init(&accum);
+    dec64_accum_add_n(&accum, numbers, split);
+    dec64_accum_merge(&other, &accum);
+    judge(name, n, expected, dec64_accum_finish(&other));
+}
+
+static void test_fold(const char* name, int64 low, int64 high, int64 exponent) {
+/*
+    Numbers with one exponent, whose dec64_add chain is exact.
+*/
+    size_t length;
+    size_t at;
+    dec64 expected;
+
+    for (length = 0; length < sizeof lengths / sizeof lengths[0]; length += 1) {
+        expected = DEC64_ZERO;
+        for (at = 0; at < lengths[length]; at += 1) {
+            column[at] = dec64_new(random_range(low, high), exponent);
+            expected = dec64_add(expected, column[at]);
+        }
+        test_sum(name, column, lengths[length], expected);
+    }
+}
+
+static void test_repeat(const char* name, dec64 number, size_t n, dec64 expected) {
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        column[at] = number;
+    }
+    test_sum(name, column, n, expected);
+}
+
+static void test_all_exact() {
+    dec64 numbers[4];
+
+    test_repeat("empty", DEC64_ONE, 0, DEC64_ZERO);
+    test_repeat("cents", dec64_new(1, -2), 100, dec64_new(100, -2));
+    test_repeat("minnum", dec64_new(1, -127), 10, dec64_new(10, -127));
+    test_repeat(
+        "maxint * 1000",
+        dec64_new(36028797018963967, 0),
+        1000,
+        dec64_new(36028797018963967, 3)
+    );
+    test_repeat("maxnum * 2", dec64_new(36028797018963967, 127), 2, DEC64_NAN);
+    numbers[0] = dec64_new(1, 16);
+    numbers[1] = dec64_new(5, -1);
+    numbers[2] = dec64_new(5, -1);
+    test_sum("1e16 + 0.5 + 0.5", numbers, 3, dec64_new(10000000000000001, 0));
+    numbers[0] = dec64_new(36028797018963967, 127);
+    numbers[1] = dec64_new(1, -2);
+    numbers[2] = dec64_new(-36028797018963967, 127);
+    test_sum("maxnum + cent - maxnum", numbers, 3, dec64_new(1, -2));
+    numbers[0] = dec64_new(12345678901234567, 0);
+    numbers[1] = dec64_new(5, -1);
+    test_sum("round up", numbers, 2, dec64_new(12345678901234568, 0));
+    numbers[0] = dec64_new(-12345678901234567, 0);
+    numbers[1] = dec64_new(-5, -1);
+    test_sum("round down", numbers, 2, dec64_new(-12345678901234568, 0));
+    numbers[0] = dec64_new(12345678901234567, 0);
+    numbers[1] = dec64_new(4, -1);
+    numbers[2] = dec64_new(9, -100);
+    test_sum("0.4 and a bit", numbers, 3, dec64_new(12345678901234567, 0));
+    numbers[0] = dec64_new(-3, 0);
+    numbers[1] = dec64_new(1, 0);
+    numbers[2] = dec64_new(25, -1);
+    numbers[3] = dec64_new(-1, -1);
+    test_sum("negative", numbers, 4, dec64_new(4, -1));
+    numbers[0] = dec64_new(3, 0);
+    numbers[1] = dec64_new(-3, 0);
+    test_sum("cancel", numbers, 2, DEC64_ZERO);
+    numbers[0] = dec64_new(1, 0);
+    numbers[1] = DEC64_NAN;
+    numbers[2] = dec64_new(1, 0);
+    test_sum("nan", numbers, 3, DEC64_NAN);
+}
+
+static void test_all_fold() {
+    test_fold("money", -1000000, 1000000, -2);
+    test_fold("integer", -100000, 100000, 0);
+    test_fold("big integer", -3602879701896, 3602879701896, 0);
+}
+
+static void test_all_mixed() {
+/*
+    Numbers with every exponent cancel out exactly when each is added with
+    both signs, leaving only the cent.
+*/
+    size_t at;
+    size_t half = MAX_N / 2 - 1;
+
+    for (at = 0; at < half; at += 1) {
+        column[at] = dec64_new(
+            random_range(-36028797018963967, 36028797018963967),
+            random_range(-127, 127)
+        );
+        column[MAX_N - 1 - at] = dec64_neg(column[at]);
+    }
+    column[half] = dec64_new(1, -2);
+    column[half + 1] = DEC64_ZERO;
+    test_sum("mixed", column, MAX_N, dec64_new(1, -2));
+}
+
+static void test_dot(const char* name, size_t n, dec64 expected) {
+/*
+    The dot product of column and weights is taken with dec64_dot, from
+    interleaved copies with dec64_dot_strided, and with add_product.
+*/
+    dec64_accum accum;
+    size_t at;
+
+    judge(name, n, expected, dec64_dot(column, weights, n));
+    for (at = 0; at < n; at += 1) {
+        strided[at * 3] = column[at];
+        strided[at * 3 + 2] = weights[at];
+    }
+    judge(name, n, expected, dec64_dot_strided(strided, 3, strided + 2, 3, n));
+    dec64_accum_init(&accum);
+    for (at = 0; at < n; at += 1) {
+        dec64_accum_add_product(&accum, column[at], weights[at]);
+    }
+    judge(name, n, expected, dec64_accum_finish(&accum));
+}
+
+static void test_dot_fold(
+    const char* name,
+    int64 limit1,
+    int64 exponent1,
+    int64 limit2,
+    int64 exponent2
+) {
+/*
+    Coefficients small enough that the chain of dec64_multiply and dec64_add
+    is exact.
+*/
+    size_t length;
+    size_t at;
+    dec64 expected;
+
+    for (length = 0; length < sizeof lengths / sizeof lengths[0]; length += 1) {
+        expected = DEC64_ZERO;
+        for (at = 0; at < lengths[length]; at += 1) {
+            column[at] = dec64_new(random_range(-limit1, limit1), exponent1);
+            weights[at] = dec64_new(random_range(-limit2, limit2), exponent2);
+            expected = dec64_add(expected, dec64_multiply(column[at], weights[at]));
+        }
+        test_dot(name, lengths[length], expected);
+    }
+}
+
+static void test_all_dot() {
+    int at;
+
+    test_dot_fold("price * quantity", 100000000, -2, 100000, 0);
+    test_dot_fold("big price * quantity", 3000000000, -4, 1000, 0);
+    test_dot_fold("price * weight", 10000000, -2, 1000000, -6);
+    for (at = 0; at < 100; at += 1) {
+        column[0] = dec64_new(
+            random_range(-36028797018963967, 36028797018963967),
+            random_range(-100, 100)
+        );
+        weights[0] = dec64_new(
+            random_range(-36028797018963967, 36028797018963967),
+            random_range(-100, 100)
+        );
+        column[1] = dec64_new(random_range(-100000, 100000), random_range(-100, 100));
+        weights[1] = dec64_new(random_range(-100000, 100000), random_range(-100, 100));
+        test_dot(
+            "fma",
+            2,
+            dec64_fma(column[0], weights[0], dec64_multiply(column[1], weights[1]))
+        );
+    }
+    column[0] = dec64_new(36028797018963967, 0);
+    weights[0] = dec64_new(36028797018963967, 0);
+    column[1] = dec64_new(-36028797018963967, 0);
+    weights[1] = dec64_new(36028797018963967, 0);
+    column[2] = dec64_new(1, -2);
+    weights[2] = dec64_new(1, 0);
+    test_dot("maxint^2 - maxint^2 + cent", 3, dec64_new(1, -2));
+    column[0] = DEC64_NAN;
+    weights[0] = DEC64_ZERO;
+    column[1] = dec64_new(3, 0);
+    weights[1] = dec64_new(4, 0);
+    test_dot("nan * 0 + 3 * 4", 2, dec64_new(12, 0));
+    weights[0] = DEC64_ONE;
+    test_dot("nan * 1 + 3 * 4", 2, DEC64_NAN);
+    column[0] = dec64_new(1, -127);
+    weights[0] = dec64_new(5, -1);
+    test_dot("minnum * 0.5", 1, dec64_new(1, -127));
+    weights[0] = dec64_new(4, -1);
+    test_dot("minnum * 0.4", 1, DEC64_ZERO);
+}
+
+static int do_tests(int level_of_detail) {
+/*
+    Level of detail:
+        3 full
+        2 errors only
+        1 error summary
+        0 none
+*/
+    int round;
+
+    level = level_of_detail;
+    nr_fail = 0;
+    nr_pass = 0;
+
+    test_all_exact();
+    test_all_dot();
+    for (round = 0; round < 20; round += 1) {
+        test_all_fold();
+        test_all_mixed();
+    }
+
+    printf("\n\n%i pass, %i fail.\n", nr_pass, nr_fail);
+    return nr_fail;
+}
+
+int main(int argc, char* argv[]) {
+    seed = 0x853C49E6748FEA9BULL;
+    return do_tests(2);
+}
@@ -0,0 +1,342 @@
+/* dec64_array_test.c
+
+This is a test of dec64_array.c.
+
+Every batched function must give exactly the words that the scalar function
+gives for each element, and the scans the words of a chain of dec64_add. The
+columns are made of runs of money, integers, numbers near the overflow limits,
+nans and a mix of everything, with lengths around the block size, and each
+function is also tried in place. Every kernel set that the processor supports
+is tested in turn.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "dec64.h"
+#include "dec64_array.h"
+#include "dec64_harness.h"
+
+#define MAX_N 100
+#define NR_KINDS 6
+
+typedef dec64 (*unary_function)(dec64);
+typedef dec64 (*binary_function)(dec64, dec64);
+typedef void (*unary_array_function)(dec64*, const dec64*, size_t);
+typedef void (*array_function)(dec64*, const dec64*, const dec64*, size_t);
+typedef void (*scalar_function)(dec64*, const dec64*, dec64, size_t);
+
+static dec64 first[MAX_N];
+static dec64 second[MAX_N];
+static dec64 third[MAX_N];
+static dec64 results[MAX_N];
+
+static const int lengths[] = {0, 1, 2, 15, 16, 17, 31, 32, 33, 64, 99, 100};
+
+static const char* kernel_names[] = {"generic", "avx2", "avx512"};
+
+static const char* kind_names[NR_KINDS] = {
+    "money",
+    "integer",
+    "limits",
+    "nan",
+    "special",
+    "mixed"
+};
+
+/* columns */
+
+static dec64 make_one(int kind) {
+    switch (kind) {
+    case 0:
+        return dec64_new(random_range(-1000000, 1000000), -2);
+    case 1:
+        return dec64_new(random_range(-100000, 100000), 0);
+    case 2:
+        return dec64_new(
+            random_range(0, 1) == 0
+                ? random_range(36028797018963000, 36028797018963967)
+                : random_range(-36028797018963968, -36028797018963000),
+            0
+        );
+    case 3:
+        return next_random() % 4 == 0
+            ? specials[next_random() % 2]
+            : dec64_new(random_range(-1000000, 1000000), -2);
+    case 4:
+        return specials[next_random() % nr_specials];
+    default:
+        return make_one((int)(next_random() % (NR_KINDS - 1)));
+    }
+}
+
+static void fill(int kind) {
+    int at;
+
+    for (at = 0; at < MAX_N; at += 1) {
+        first[at] = make_one(kind);
+        second[at] = make_one(kind);
+        third[at] = make_one(kind);
+    }
+}
+
+/* judgement */
+
+static void judge(
+    const char* name,
+    const char* kind,
+    size_t n,
+    size_t at,
+    dec64 left,
+    dec64 right,
+    dec64 expected,
+    dec64 actual
+) {
+    if (judged(expected, actual)) {
+        printf(
+            "\n\nFAIL %s (%s): %s n=%i at %i",
+            name,
+            kernel_names[dec64_array_kernel()],
+            kind,
+            (int)n,
+            (int)at
+        );
+        if (level >= 2) {
+            printf("\n%-4s", "");
+            print_dec64(left);
+            printf("\n%-4s", "");
+            print_dec64(right);
+            print_mismatch(expected, actual);
+        }
+    }
+}
+
+static void test_array(
+    const char* name,
+    array_function batched,
+    binary_function function,
+    int kind
+) {
+/*
+    Try the function on every length, once into a separate array and once in
+    place over the first operand.
+*/
+    size_t length;
+    size_t at;
+    size_t n;
+    dec64 in_place[MAX_N];
+
+    for (length = 0; length < sizeof lengths / sizeof lengths[0]; length += 1) {
+        n = lengths[length];
+        batched(results, first, second, n);
+        memcpy(in_place, first, sizeof in_place);
+        batched(in_place, in_place, second, n);
+        for (at = 0; at < n; at += 1) {
+            dec64 expected = function(first[at], second[at]);
+            judge(name, kind_names[kind], n, at, first[at], second[at], expected, results[at]);
+            judge(name, "in place", n, at, first[at], second[at], expected, in_place[at]);
+        }
+    }
+}
+
+static void test_unary(
+    const char* name,
+    unary_array_function batched,
+    unary_function function,
+    int kind
+) {
+    size_t length;
+    size_t at;
+    size_t n;
+    dec64 in_place[MAX_N];
+
+    for (length = 0; length < sizeof lengths / sizeof lengths[0]; length += 1) {
+        n = lengths[length];
+        batched(results, first, n);
+        memcpy(in_place, first, sizeof in_place);
+        batched(in_place, in_place, n);
+        for (at = 0; at < n; at += 1) {
+            dec64 expected = function(first[at]);
+            judge(name, kind_names[kind], n, at, first[at], 0, expected, results[at]);
+            judge(name, "in place", n, at, first[at], 0, expected, in_place[at]);
+        }
+    }
+}
+
+static void test_scalar(
+    const char* name,
+    scalar_function batched,
+    binary_function function,
+    int kind
+) {
+/*
+    The scalar is taken from the second column, so that it is sometimes nan or
+    has a different exponent than the elements.
+*/
+    size_t length;
+    size_t at;
+    size_t n;
+    dec64 scalar;
+
+    for (length = 0; length < sizeof lengths / sizeof lengths[0]; length += 1) {
+        n = lengths[length];
+        scalar = second[length];
+        batched(results, first, scalar, n);
+        for (at = 0; at < n; at += 1) {
+            judge(
+                name,
+                kind_names[kind],
+                n,
+                at,
+                first[at],
+                scalar,
+                function(first[at], scalar),
+                results[at]
+            );
+        }
+    }
+}
+
+static void test_fma(int kind) {
+/*
+    fma has three columns. The scalar form takes its multiplier and addend from
+    the second and third columns.
+*/
+    size_t length;
+    size_t at;
+    size_t n;
+    dec64 in_place[MAX_N];
+
+    for (length = 0; length < sizeof lengths / sizeof lengths[0]; length += 1) {
+        n = lengths[length];
+        dec64_fma_n(results, first, second, third, n);
+        memcpy(in_place, third, sizeof in_place);
+        dec64_fma_n(in_place, first, second, in_place, n);
+        for (at = 0; at < n; at += 1) {
+            dec64 expected = dec64_fma(first[at], second[at], third[at]);
+            judge("fma_n", kind_names[kind], n, at, first[at], second[at], expected, results[at]);
+            judge("fma_n", "in place", n, at, first[at], second[at], expected, in_place[at]);
+        }
+        dec64_fma_n_scalar(results, first, second[length], third[length], n);
+        for (at = 0; at < n; at += 1) {
+            judge(
+                "fma_n_scalar",
+                kind_names[kind],
+                n,
+                at,
+                first[at],
+                second[length],
+                dec64_fma(first[at], second[length], third[length]),
+                results[at]
+            );
+        }
+    }
+}
+
+static void test_scan(int kind) {
+/*
+    The scans must match a chain of dec64_add, in place too. The start comes
+    from the second column, and the final total must be the end of the chain.
+*/
+    size_t length;
+    size_t at;
+    size_t n;
+    int exclusive;
+    dec64 in_place[MAX_N];
+    dec64 start;
+    dec64 total;
+    dec64 expected;
+    dec64 result;
+    dec64 result_in_place;
+
+    for (length = 0; length < sizeof lengths / sizeof lengths[0]; length += 1) {
+        n = lengths[length];
+        start = length % 2 == 0 ? DEC64_ZERO : second[length];
+        for (exclusive = 0; exclusive <= 1; exclusive += 1) {
+            const char* name = exclusive ? "scan_exclusive" : "scan_inclusive";
+            memcpy(in_place, first, sizeof in_place);
+            if (exclusive) {
+                result = dec64_scan_exclusive(results, first, n, start);
+                result_in_place = dec64_scan_exclusive(in_place, in_place, n, start);
+            } else {
+                result = dec64_scan_inclusive(results, first, n, start);
+                result_in_place = dec64_scan_inclusive(in_place, in_place, n, start);
+            }
+            total = start;
+            for (at = 0; at < n; at += 1) {
+                expected = exclusive ? total : dec64_add(total, first[at]);
+                judge(name, kind_names[kind], n, at, total, first[at], expected, results[at]);
+                judge(name, "in place", n, at, total, first[at], expected, in_place[at]);
+                total = dec64_add(total, first[at]);
+            }
+            judge(name, kind_names[kind], n, n, start, DEC64_ZERO, total, result);
+            judge(name, "in place", n, n, start, DEC64_ZERO, total, result_in_place);
+        }
+    }
+}
+
+static void test_all_kind(int kind) {
+    fill(kind);
+    test_array("add_n", dec64_add_n, dec64_add, kind);
+    test_array("divide_n", dec64_divide_n, dec64_divide, kind);
+    test_array("is_equal_n", dec64_is_equal_n, dec64_is_equal, kind);
+    test_array("is_less_n", dec64_is_less_n, dec64_is_less, kind);
+    test_array("multiply_n", dec64_multiply_n, dec64_multiply, kind);
+    test_array("subtract_n", dec64_subtract_n, dec64_subtract, kind);
+    test_fma(kind);
+    test_scan(kind);
+    test_unary("abs_n", dec64_abs_n, dec64_abs, kind);
+    test_unary("neg_n", dec64_neg_n, dec64_neg, kind);
+    test_unary("signum_n", dec64_signum_n, dec64_signum, kind);
+    test_scalar("add_n_scalar", dec64_add_n_scalar, dec64_add, kind);
+    test_scalar("divide_n_scalar", dec64_divide_n_scalar, dec64_divide, kind);
+    test_scalar("is_equal_n_scalar", dec64_is_equal_n_scalar, dec64_is_equal, kind);
+    test_scalar("is_less_n_scalar", dec64_is_less_n_scalar, dec64_is_less, kind);
+    test_scalar("multiply_n_scalar", dec64_multiply_n_scalar, dec64_multiply, kind);
+    test_scalar("subtract_n_scalar", dec64_subtract_n_scalar, dec64_subtract, kind);
+}
+
+static int do_tests(int level_of_detail) {
+/*
+    Level of detail:
+        3 full
+        2 errors only
+        1 error summary
+        0 none
+*/
+    int kernel;
+    int kind;
+    int round;
+
+    level = level_of_detail;
+    nr_fail = 0;
+    nr_pass = 0;
+
+    for (kernel = DEC64_ARRAY_GENERIC; kernel <= DEC64_ARRAY_AVX512; kernel += 1) {
+        if (dec64_array_use_kernel(kernel) != kernel) {
+            printf("\n%s kernels not supported", kernel_names[kernel]);
+            continue;
+        }
+        if (level >= 3) {
+            printf("\n%s kernels", kernel_names[kernel]);
+        }
+        for (round = 0; round < 20; round += 1) {
+            for (kind = 0; kind < NR_KINDS; kind += 1) {
+                test_all_kind(kind);
+            }
+        }
+    }
+
+    printf("\n\n%i pass, %i fail.\n", nr_pass, nr_fail);
+    return nr_fail;
+}
+
+int main(int argc, char* argv[]) {
+    seed = 0x2545F4914F6CDD1DULL;
+    define_specials();
+    return do_tests(2);
+}
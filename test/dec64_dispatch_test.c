@@ -0,0 +1,162 @@
+/* dec64_dispatch_test.c
+
+This is a test of dec64_dispatch.c.
+
+Every variant that can run on this processor must give exactly the words that
+the portable C port gives. The operands are money, integers, numbers near the
+overflow limits and special numbers, in every combination.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "dec64.h"
+#include "dec64_dispatch.h"
+#include "dec64_harness.h"
+
+#define NR_OPERANDS 400
+#define NR_FUNCTIONS 8
+
+typedef dec64 (*binary_function)(dec64, dec64);
+
+static dec64 operands[NR_OPERANDS];
+static dec64 expected[NR_FUNCTIONS][NR_OPERANDS][NR_OPERANDS / 8];
+
+static const char* function_names[NR_FUNCTIONS] = {
+    "new",
+    "add",
+    "subtract",
+    "multiply",
+    "divide",
+    "integer_divide",
+    "modulo",
+    "round"
+};
+
+static dec64 dispatched_new(dec64 coefficient, dec64 exponent) {
+/*
+    dec64_new takes raw integers. The low byte of the second operand becomes
+    an exponent from -100 to 155, so that both scaling up and scaling down
+    are tried.
+*/
+    return dec64_new(coefficient >> 8, (int64)(exponent & 0xFF) - 100);
+}
+
+static const binary_function functions[NR_FUNCTIONS] = {
+    dispatched_new,
+    dec64_add,
+    dec64_subtract,
+    dec64_multiply,
+    dec64_divide,
+    dec64_integer_divide,
+    dec64_modulo,
+    dec64_round
+};
+
+/* operands */
+
+static void define_operands() {
+    int at;
+
+    define_specials();
+    for (at = 0; at < nr_specials; at += 1) {
+        operands[at] = specials[at];
+    }
+    while (at < NR_OPERANDS) {
+        switch (next_random() % 4) {
+        case 0:
+            operands[at++] = dec64_new(random_range(-1000000, 1000000), -2);
+            break;
+        case 1:
+            operands[at++] = dec64_new(random_range(-100000, 100000), 0);
+            break;
+        case 2:
+            operands[at++] = dec64_new(
+                random_range(-36028797018963968, 36028797018963967),
+                random_range(-20, 20)
+            );
+            break;
+        default:
+            operands[at++] = (dec64)next_random();
+        }
+    }
+}
+
+/* judgement */
+
+static void run(int record) {
+/*
+    Each function is tried on every operand against every eighth operand,
+    either recording the results or comparing with the recorded ones.
+*/
+    int function;
+    int left;
+    int right;
+    dec64 result;
+
+    for (function = 0; function < NR_FUNCTIONS; function += 1) {
+        for (left = 0; left < NR_OPERANDS; left += 1) {
+            for (right = 0; right < NR_OPERANDS / 8; right += 1) {
+                result = functions[function](operands[left], operands[right * 8]);
+                if (record) {
+                    expected[function][left][right] = result;
+                } else if (judged(expected[function][left][right], result)) {
+                    printf(
+                        "\n\nFAIL %s (%s): %016llx %016llx",
+                        function_names[function],
+                        dec64_dispatch_name(dec64_dispatch_variant()),
+                        (unsigned long long)operands[left],
+                        (unsigned long long)operands[right * 8]
+                    );
+                    if (level >= 2) {
+                        printf(
+                            "\n    ? %016llx\n    = %016llx",
+                            (unsigned long long)result,
+                            (unsigned long long)expected[function][left][right]
+                        );
+                    }
+                }
+            }
+        }
+    }
+}
+
+static int do_tests(int level_of_detail) {
+/*
+    Level of detail:
+        3 full
+        2 errors only
+        1 error summary
+        0 none
+*/
+    int chosen = dec64_dispatch_variant();
+    int variant;
+
+    level = level_of_detail;
+    nr_fail = 0;
+    nr_pass = 0;
+
+    printf("\nchosen variant: %s", dec64_dispatch_name(chosen));
+    dec64_dispatch_use(DEC64_VARIANT_C);
+    run(1);
+    for (variant = DEC64_VARIANT_C; variant <= DEC64_VARIANT_BMI2; variant += 1) {
+        if (dec64_dispatch_use(variant) != variant) {
+            printf("\n%s variant not available", dec64_dispatch_name(variant));
+            continue;
+        }
+        run(0);
+    }
+    dec64_dispatch_use(chosen);
+
+    printf("\n\n%i pass, %i fail.\n", nr_pass, nr_fail);
+    return nr_fail;
+}
+
+int main(int argc, char* argv[]) {
+    seed = 0x9E3779B97F4A7C15ULL;
+    define_operands();
+    return do_tests(2);
+}
@@ -0,0 +1,125 @@
+/* dec64_divisor_test.c
+
+This is a test of dec64_divisor.c.
+
+For every divisor, dec64_divide_by and dec64_divide_by_n must give exactly the
+words that dec64_divide gives, in place too. The divisors and dividends are
+the special numbers, numbers of every length from 1 to 56 bits, and small
+integers and rates like the ones that columns are divided by.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "dec64.h"
+#include "dec64_divisor.h"
+#include "dec64_harness.h"
+
+#define MAX_N 2000
+#define NR_DIVISORS 400
+
+static dec64 dividends[MAX_N];
+static dec64 quotients[MAX_N];
+static dec64 in_place[MAX_N];
+static dec64 divisors[NR_DIVISORS];
+
+/* operands */
+
+static dec64 make_one(int kind) {
+/*
+    A number with a coefficient of 1 to 56 bits, a small integer, a rate or
+    a special number.
+*/
+    int64 coefficient;
+
+    switch (kind) {
+    case 0:
+        coefficient = (int64)(next_random() >> random_range(9, 63));
+        return dec64_new(
+            random_range(0, 1) == 0 ? coefficient : -coefficient,
+            random_range(-127, 127)
+        );
+    case 1:
+        return dec64_new(random_range(-1000, 1000), 0);
+    case 2:
+        return dec64_new(random_range(1, 99999999), -(int64)random_range(0, 8));
+    default:
+        return specials[next_random() % nr_specials];
+    }
+}
+
+/* judgement */
+
+static void judge(
+    const char* name,
+    dec64 dividend,
+    dec64 divisor,
+    dec64 expected,
+    dec64 actual
+) {
+    if (judged(expected, actual)) {
+        printf("\n\nFAIL %s", name);
+        if (level >= 2) {
+            printf("\n%-4s", "");
+            print_dec64(dividend);
+            printf("\n%-4s", "/");
+            print_dec64(divisor);
+            print_mismatch(expected, actual);
+        }
+    }
+}
+
+static void test_divisor(dec64 number, size_t n) {
+    dec64_divisor divisor = dec64_divisor_make(number);
+    size_t at;
+
+    dec64_divide_by_n(quotients, dividends, &divisor, n);
+    memcpy(in_place, dividends, sizeof(dec64) * n);
+    dec64_divide_by_n(in_place, in_place, &divisor, n);
+    for (at = 0; at < n; at += 1) {
+        dec64 expected = dec64_divide(dividends[at], number);
+        judge("divide_by", dividends[at], number, expected, dec64_divide_by(dividends[at], &divisor));
+        judge("divide_by_n", dividends[at], number, expected, quotients[at]);
+        judge("divide_by_n in place", dividends[at], number, expected, in_place[at]);
+    }
+}
+
+static void test_all() {
+    int at;
+
+    for (at = 0; at < MAX_N; at += 1) {
+        dividends[at] = make_one(at % 4);
+    }
+    for (at = 0; at < NR_DIVISORS; at += 1) {
+        divisors[at] = at < nr_specials ? specials[at] : make_one(at % 4);
+        test_divisor(divisors[at], MAX_N - at);
+    }
+}
+
+static int do_tests(int level_of_detail) {
+/*
+    Level of detail:
+        3 full
+        2 errors only
+        1 error summary
+        0 none
+*/
+    level = level_of_detail;
+    nr_fail = 0;
+    nr_pass = 0;
+
+    test_all();
+
+    printf("\n\n%i pass, %i fail.\n", nr_pass, nr_fail);
+    return nr_fail;
+}
+
+int main(int argc, char* argv[]) {
+    seed = 0x6A09E667F3BCC909ULL;
+    define_specials();
+    return do_tests(2);
+}
@@ -0,0 +1,124 @@
+/* dec64_harness.h
+
+The parts that the test programs and the benchmark share.
+
+Each program sets seed, so that its numbers are always the same, and then
+takes them from next_random and random_range, a xorshift generator that does
+not depend on dec64_random. The benchmark defines DEC64_HARNESS_SPLITMIX
+before including this, to keep the splitmix64 generator it always had. A test counts its results with judged, which
+returns true for a failure that should be reported at the current level of
+detail, and prints the two words with print_mismatch. define_specials fills
+specials with the numbers that every operation should be tried on.
+
+Public Domain
+
+No warranty.
+*/
+
+#ifndef DEC64_HARNESS
+#define DEC64_HARNESS
+
+#include <stdio.h>
+#include "dec64.h"
+
+static int level;
+static int nr_fail;
+static int nr_pass;
+
+static dec64 specials[24];
+static int nr_specials;
+
+static uint64 seed;
+
+/* operands */
+
+#ifdef DEC64_HARNESS_SPLITMIX
+static inline uint64 next_random() {
+    uint64 z = (seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+#else
+static inline uint64 next_random() {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    return seed;
+}
+#endif
+
+static inline int64 random_range(int64 low, int64 high) {
+    return low + (int64)(next_random() % (uint64)(high - low + 1));
+}
+
+static inline int64 power_of_ten(int64 exponent) {
+    int64 result = 1;
+    while (exponent > 0) {
+        result *= 10;
+        exponent -= 1;
+    }
+    return result;
+}
+
+static inline void define_specials() {
+    nr_specials = 0;
+    specials[nr_specials++] = DEC64_NAN;                /* nan */
+    specials[nr_specials++] = 32896;                    /* a non-normal nan */
+    specials[nr_specials++] = DEC64_ZERO;               /* 0 */
+    specials[nr_specials++] = 1;                        /* a non normal 0 */
+    specials[nr_specials++] = 0x1FE;                    /* 1e-2, zero coefficient */
+    specials[nr_specials++] = DEC64_ONE;                /* 1 */
+    specials[nr_specials++] = DEC64_NEGATIVE_ONE;       /* -1 */
+    specials[nr_specials++] = dec64_new(3, 0);          /* 3 */
+    specials[nr_specials++] = dec64_new(7, 0);          /* 7 */
+    specials[nr_specials++] = dec64_new(1, -2);         /* 0.01 */
+    specials[nr_specials++] = dec64_new(-1, -2);        /* -0.01 */
+    specials[nr_specials++] = dec64_new(10, -1);        /* 1.0 */
+    specials[nr_specials++] = dec64_new(10842, -4);     /* a rate */
+    specials[nr_specials++] = dec64_new(1, -127);       /* minnum */
+    specials[nr_specials++] = dec64_new(-1, -127);      /* -minnum */
+    specials[nr_specials++] = dec64_new(36028797018963967, 0);
+                                                        /* maxint */
+    specials[nr_specials++] = dec64_new(-36028797018963968, 0);
+                                                        /* -maxint */
+    specials[nr_specials++] = dec64_new(36028797018963967, 127);
+                                                        /* maxnum */
+    specials[nr_specials++] = dec64_new(-36028797018963968, 127);
+                                                        /* -maxnum */
+    specials[nr_specials++] = dec64_new(31415926535897932, -16);
+                                                        /* pi */
+    specials[nr_specials++] = dec64_new(-31415926535897932, -16);
+                                                        /* -pi */
+    specials[nr_specials++] = dec64_new(1, -16);        /* epsilon */
+    specials[nr_specials++] = dec64_new(9999999999999999, -16);
+                                                        /* almost one */
+}
+
+/* judgement */
+
+static inline void print_dec64(dec64 number) {
+    printf("%20lli e%-4i", dec64_coefficient(number), (int)dec64_exponent(number));
+}
+
+static inline int judged(dec64 expected, dec64 actual) {
+/*
+    Count the result. It is true if the words differ and failures are being
+    reported.
+*/
+    if (expected == actual) {
+        nr_pass += 1;
+        return 0;
+    }
+    nr_fail += 1;
+    return level >= 1;
+}
+
+static inline void print_mismatch(dec64 expected, dec64 actual) {
+    printf("\n%-4s", "?");
+    print_dec64(actual);
+    printf("\n%-4s", "=");
+    print_dec64(expected);
+}
+
+#endif //DEC64_HARNESS
@@ -0,0 +1,237 @@
+/* dec64_parallel_test.c
+
+This is a test of dec64_parallel.c.
+
+Every reduction must give exactly the same word for every number of threads,
+and the same word as a single pass over the array: dec64_accum for the sum,
+and the first of the smallest or largest numbers for min and max. The dot
+product of the array with itself reversed must match dec64_dot. The scans must
+write the same totals as dec64_scan_inclusive and dec64_scan_exclusive, in
+place too.
+
+Public Domain
+
+No warranty.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include "dec64.h"
+#include "dec64_accum.h"
+#include "dec64_array.h"
+#include "dec64_parallel.h"
+#include "dec64_harness.h"
+
+#define MAX_N 200000
+#define NR_KINDS 4
+
+static dec64 column[MAX_N];
+static dec64 reversed[MAX_N];
+static dec64 expected_totals[MAX_N];
+static dec64 totals[MAX_N];
+
+static const size_t lengths[] = {0, 1, 1000, 32768, 32769, 100000, 200000};
+static const int threads[] = {0, 1, 2, 3, 4, 7, 8, 16, 300};
+
+static const char* kind_names[NR_KINDS] = {
+    "money",
+    "mixed",
+    "equal",
+    "nan"
+};
+
+/* operands */
+
+static void fill(int kind, size_t n) {
+/*
+    In the equal kind, every number is 1 or -1, written in several ways, so
+    min and max must take the first one.
+*/
+    size_t at;
+    int64 places;
+
+    for (at = 0; at < n; at += 1) {
+        switch (kind) {
+        case 0:
+            column[at] = dec64_new(random_range(-1000000, 1000000), -2);
+            break;
+        case 1:
+            column[at] = dec64_new(
+                random_range(-36028797018963967, 36028797018963967),
+                random_range(-20, 20)
+            );
+            break;
+        case 2:
+            places = random_range(0, 10);
+            column[at] = dec64_new(
+                (random_range(0, 1) * 2 - 1) * power_of_ten(places),
+                -places
+            );
+            break;
+        default:
+            column[at] = next_random() % 50000 == 0
+                ? DEC64_NAN
+                : dec64_new(random_range(-1000000, 1000000), -2);
+        }
+    }
+}
+
+/* judgement */
+
+static void judge(
+    const char* name,
+    const char* kind,
+    size_t n,
+    int nthreads,
+    dec64 expected,
+    dec64 actual
+) {
+    if (judged(expected, actual)) {
+        printf("\n\nFAIL %s: %s n=%i threads=%i", name, kind, (int)n, nthreads);
+        if (level >= 2) {
+            print_mismatch(expected, actual);
+        }
+    }
+}
+
+static void judge_scan(
+    const char* name,
+    const char* kind,
+    size_t n,
+    int nthreads,
+    dec64 expected,
+    dec64 actual
+) {
+/*
+    Judge the final totals, or the first total that differs.
+*/
+    size_t at;
+
+    for (at = 0; at < n; at += 1) {
+        if (expected_totals[at] != totals[at]) {
+            judge(name, kind, n, nthreads, expected_totals[at], totals[at]);
+            return;
+        }
+    }
+    judge(name, kind, n, nthreads, expected, actual);
+}
+
+/* the single pass */
+
+static dec64 single_extreme(size_t n, int largest) {
+    size_t at;
+    dec64 best = n > 0 ? column[0] : DEC64_NAN;
+    dec64 less;
+
+    for (at = 0; at < n; at += 1) {
+        less = largest ? dec64_is_less(best, column[at]) : dec64_is_less(column[at], best);
+        if (less == DEC64_NAN) {
+            return DEC64_NAN;
+        }
+        if (less == DEC64_ONE) {
+            best = column[at];
+        }
+    }
+    return best;
+}
+
+static void test_kind(int kind) {
+    size_t length;
+    size_t n;
+    size_t thread;
+    int nthreads;
+    dec64 sum;
+    dec64 min;
+    dec64 max;
+    dec64 mean;
+    dec64 dot;
+    dec64 start;
+    dec64 total;
+    size_t at;
+    int exclusive;
+    dec64_accum accum;
+
+    for (length = 0; length < sizeof lengths / sizeof lengths[0]; length += 1) {
+        n = lengths[length];
+        fill(kind, n);
+        dec64_accum_init(&accum);
+        dec64_accum_add_n(&accum, column, n);
+        sum = dec64_accum_finish(&accum);
+        mean = n == 0 ? DEC64_NAN : dec64_divide(sum, dec64_new((int64)n, 0));
+        min = single_extreme(n, 0);
+        max = single_extreme(n, 1);
+        for (at = 0; at < n; at += 1) {
+            reversed[at] = column[n - 1 - at];
+        }
+        dot = dec64_dot(column, reversed, n);
+        for (thread = 0; thread < sizeof threads / sizeof threads[0]; thread += 1) {
+            nthreads = threads[thread];
+            judge("sum", kind_names[kind], n, nthreads, sum, dec64_parallel_sum(column, n, nthreads));
+            judge("mean", kind_names[kind], n, nthreads, mean, dec64_parallel_mean(column, n, nthreads));
+            judge("min", kind_names[kind], n, nthreads, min, dec64_parallel_min(column, n, nthreads));
+            judge("max", kind_names[kind], n, nthreads, max, dec64_parallel_max(column, n, nthreads));
+            judge("dot", kind_names[kind], n, nthreads, dot, dec64_parallel_dot(column, reversed, n, nthreads));
+        }
+        start = kind == 0 ? dec64_new(12345, -2) : DEC64_ZERO;
+        for (exclusive = 0; exclusive <= 1; exclusive += 1) {
+            const char* name = exclusive ? "scan_exclusive" : "scan_inclusive";
+            const char* in_place = exclusive ? "scan_exclusive in place" : "scan_inclusive in place";
+            total = exclusive
+                ? dec64_scan_exclusive(expected_totals, column, n, start)
+                : dec64_scan_inclusive(expected_totals, column, n, start);
+            for (thread = 0; thread < sizeof threads / sizeof threads[0]; thread += 1) {
+                nthreads = threads[thread];
+                judge_scan(
+                    name,
+                    kind_names[kind],
+                    n,
+                    nthreads,
+                    total,
+                    exclusive
+                        ? dec64_parallel_scan_exclusive(totals, column, n, start, nthreads)
+                        : dec64_parallel_scan_inclusive(totals, column, n, start, nthreads)
+                );
+                for (at = 0; at < n; at += 1) {
+                    totals[at] = column[at];
+                }
+                judge_scan(
+                    in_place,
+                    kind_names[kind],
+                    n,
+                    nthreads,
+                    total,
+                    exclusive
+                        ? dec64_parallel_scan_exclusive(totals, totals, n, start, nthreads)
+                        : dec64_parallel_scan_inclusive(totals, totals, n, start, nthreads)
+                );
+            }
+        }
+    }
+}
+
+static int do_tests(int level_of_detail) {
+/*
+    Level of detail:
+        3 full
+        2 errors only
+        1 error summary
+        0 none
+*/
+    int kind;
+
+    level = level_of_detail;
+    nr_fail = 0;
+    nr_pass = 0;
+
+    for (kind = 0; kind < NR_KINDS; kind += 1) {
+        test_kind(kind);
+    }
+
+    printf("\n\n%i pass, %i fail.\n", nr_pass, nr_fail);
+    return nr_fail;
+}
+
+int main(int argc, char* argv[]) {
+    seed = 0xDA3E39CB94B95BDBULL;
+    return do_tests(2);
+}
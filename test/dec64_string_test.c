@@ -19,6 +19,8 @@ static int level;
 static int nr_fail;
 static int nr_pass;
 static dec64_string_state state;
+static int check_chars;
+static enum dec64_string_mode chars_mode;
 
 /* constants */
 
@@ -111,7 +113,7 @@ static void print_dec64(dec64 number) {
 
 static void test_from(dec64_string_char * string, dec64 expected) {
     dec64 actual = dec64_from_string(state, string);
-    if (dec64_is_equal(expected, actual) == DEC64_TRUE) {
+    if (dec64_is_equal(expected, actual) == DEC64_ONE) {
         nr_pass += 1;
         if (level >= 3) {
             printf("\n\npass from: %s", string);
@@ -132,10 +134,99 @@ static void test_from(dec64_string_char * string, dec64 expected) {
     }
 }
 
+static void judge_chars(
+    char * name,
+    dec64 number,
+    dec64_string_char * expected,
+    int ok,
+    dec64_string_char * actual,
+    int length
+) {
+    if (ok) {
+        nr_pass += 1;
+    } else {
+        nr_fail += 1;
+        if (level >= 1) {
+            printf("\n\nFAIL %s: ", name);
+            print_dec64(number);
+            if (level >= 2) {
+                printf("\n%-4s\"%.*s\"", "?", length, actual);
+                printf("\n%-4s\"%s\"", "=", expected);
+            }
+        }
+    }
+}
+
+static void test_to_chars(dec64 number, dec64_string_char * expected) {
+/*
+    dec64_to_chars must give what dec64_to_string gives, without a \0, and
+    must give NULL if the characters do not fit.
+*/
+    dec64_string_char actual[32];
+    dec64_string_char * end;
+    int length = (int)strlen(expected);
+
+    memset(actual, '#', sizeof actual);
+    end = dec64_to_chars(actual, actual + 32, number, chars_mode);
+    judge_chars(
+        "to_chars",
+        number,
+        expected,
+        end == actual + length && memcmp(actual, expected, length) == 0 && actual[length] == '#',
+        actual,
+        end == NULL ? 0 : (int)(end - actual)
+    );
+    end = dec64_to_chars(actual, actual + length, number, chars_mode);
+    judge_chars("to_chars exact", number, expected, end == actual + length, actual, length);
+    if (length > 0) {
+        end = dec64_to_chars(actual, actual + length - 1, number, chars_mode);
+        judge_chars("to_chars short", number, expected, end == NULL, actual, 0);
+    }
+}
+
+static void test_from_chars(
+    dec64_string_char * string,
+    int length,
+    dec64 expected
+) {
+/*
+    dec64_from_chars must read length characters of string, and no more.
+*/
+    dec64 actual;
+    const dec64_string_char * end = dec64_from_chars(
+        string,
+        string + strlen(string),
+        &actual
+    );
+    if (
+        end == string + length
+        && dec64_is_equal(expected, actual) == DEC64_ONE
+    ) {
+        nr_pass += 1;
+    } else {
+        nr_fail += 1;
+        if (level >= 1) {
+            printf("\n\nFAIL from_chars: %s", string);
+            if (level >= 2) {
+                printf("\n%-4s", "?");
+                print_dec64(actual);
+                printf(" after %i", (int)(end - string));
+                printf("\n%-4s", "=");
+                print_dec64(expected);
+                printf(" after %i", length);
+            }
+        }
+    }
+}
+
 static void test_to(dec64 number, dec64_string_char * expected) {
     dec64_string_char actual[32];
-    dec64_to_string(state, number, actual);
-    if (strcmp(expected, actual) == 0) {
+    int length = dec64_to_string(state, number, actual);
+    if (
+        strcmp(expected, actual) == 0
+        && length == (int)strlen(expected)
+        && dec64_to_string(state, number, NULL) == length
+    ) {
         nr_pass += 1;
         if (level >= 3) {
             printf("\n\npass to: ");
@@ -153,9 +244,14 @@ static void test_to(dec64 number, dec64_string_char * expected) {
             }
         }
     }
+    if (check_chars) {
+        test_to_chars(number, expected);
+    }
 }
 
 static void test_to_standard() {
+    check_chars = 1;
+    chars_mode = standard_mode;
     test_to(nan, "");
     test_to(nannan, "");
     test_to(zero, "0");
@@ -189,6 +285,7 @@ static void test_to_standard() {
 }
 
 static void test_to_separated() {
+    check_chars = 0;
     dec64_string_separation(state, 3);
     dec64_string_separator(state, ',');
 
@@ -292,6 +389,8 @@ static void test_to_place() {
 
 static void test_to_scientific() {
     dec64_string_scientific(state);
+    check_chars = 1;
+    chars_mode = scientific_mode;
 
     test_to(nan, "");
     test_to(nannan, "");
@@ -354,6 +453,8 @@ static void test_to_scientific() {
 
 static void test_to_engineering() {
     dec64_string_engineering(state);
+    check_chars = 1;
+    chars_mode = engineering_mode;
 
     test_to(nan, "");
     test_to(nannan, "");
@@ -464,6 +565,12 @@ static void test_all_from() {
     test_from("36028797018963970", maxint_plus);
     test_from("36.02879701896397e15", maxint_plus);
     test_from("36,028,797,018,963,970.000,000", maxint_plus);
+    test_from("12345678", dec64_new(12345678, 0));
+    test_from("-12345678.87654321", dec64_new(-1234567887654321, -8));
+    test_from("0.00000000000000012345678", dec64_new(12345678, -23));
+    test_from("123456789012345678", dec64_new(123456789012345678, 0));
+    test_from("1234567890123456789", dec64_new(123456789012345678, 1));
+    test_from("12345678901234567.89", dec64_new(123456789012345678, -1));
     test_from("360.28797018963967e141", maxnum);
     test_from("3.6028797018963967e143", maxnum);
     test_from("36028797018963967e127", maxnum);
@@ -550,6 +657,646 @@ static void test_all_from() {
     test_from("12.345e-3", dec64_new(12345, -6));
     test_from("0.0012345", dec64_new(12345, -7));
     test_from("1.2345e-3", dec64_new(12345, -7));
+
+    test_from("1234x678", nan);
+    test_from("1.", one);
+    test_from("-", nan);
+    test_from("-1.", negative_one);
+    test_from("1234567", dec64_new(1234567, 0));
+    test_from("123456789", dec64_new(123456789, 0));
+    test_from("123456789012345", dec64_new(123456789012345, 0));
+    test_from("1234567890123456", dec64_new(1234567890123456, 0));
+    test_from("12345678901234567", dec64_new(12345678901234567, 0));
+    test_from("-123.456", dec64_new(-123456, -3));
+    test_from("1234567.", dec64_new(1234567, 0));
+    test_from("1234567.1", dec64_new(12345671, -1));
+    test_from("1234567.12345678", dec64_new(123456712345678, -8));
+    test_from("12345678.9012345", dec64_new(123456789012345, -7));
+    test_from("0.1234567890123456", dec64_new(1234567890123456, -16));
+    test_from("00000000012", dec64_new(12, 0));
+    test_from("-0000000000000000012.5", dec64_new(-125, -1));
+    test_from("000000000.000000001", dec64_new(1, -9));
+    test_from("999999999999999999", dec64_new(999999999999999999, 0));
+    test_from("-999999999999999999", dec64_new(-999999999999999999, 0));
+    test_from("9999999999999999999", dec64_new(999999999999999999, 1));
+    test_from("1000000000000000000", dec64_new(1, 18));
+    test_from("99999999.9999999999", dec64_new(999999999999999999, -10));
+    test_from("99999999.99999999999", dec64_new(999999999999999999, -10));
+    test_from("12.x", nan);
+    test_from("12.3x", nan);
+    test_from("12.34567890x", nan);
+    test_from("1234567.1234567x", nan);
+    test_from("12.3.4", nan);
+}
+
+static uint64 from_seed = 88172645463325252ULL;
+
+static uint64 from_random() {
+    from_seed ^= from_seed << 13;
+    from_seed ^= from_seed >> 7;
+    from_seed ^= from_seed << 17;
+    return from_seed;
+}
+
+static void test_all_from_fast() {
+/*
+    The fast path must give what the byte loop gives. A separator of '-' turns
+    the fast path off, so the same characters, without their sign, are read a
+    second time by the loop alone. The strings are mostly digits, of every
+    length up to 24, with leading zeros, decimal points and garbage.
+*/
+    static const char alphabet[] = "0123456789012345678900000.x";
+    dec64_string_state loop_state = dec64_string_begin();
+    dec64_string_char string[32];
+    dec64 fast;
+    dec64 slow;
+    int length;
+    int negative;
+    int at;
+    int trial;
+
+    dec64_string_separator(loop_state, '-');
+    for (trial = 0; trial < 100000; trial += 1) {
+        length = (int)(from_random() % 25);
+        negative = (from_random() & 3) == 0;
+        string[0] = '-';
+        for (at = 0; at < length; at += 1) {
+            string[negative + at] = (
+                (from_random() & 7) == 0
+                ? alphabet[from_random() % (sizeof alphabet - 1)]
+                : (dec64_string_char)('0' + from_random() % 10)
+            );
+        }
+        string[negative + length] = 0;
+        fast = dec64_from_string(state, string);
+        slow = dec64_from_string(loop_state, string + negative);
+        if (negative) {
+            slow = dec64_neg(slow);
+        }
+        if (dec64_is_equal(fast, slow) == DEC64_ONE) {
+            nr_pass += 1;
+        } else {
+            nr_fail += 1;
+            if (level >= 1) {
+                printf("\n\nFAIL from fast: %s", string);
+                if (level >= 2) {
+                    printf("\n%-4s", "?");
+                    print_dec64(fast);
+                    printf("\n%-4s", "=");
+                    print_dec64(slow);
+                }
+            }
+        }
+    }
+    dec64_string_end(loop_state);
+}
+
+static void test_all_from_chars() {
+    test_from_chars("", 0, nan);
+    test_from_chars("-", 0, nan);
+    test_from_chars(".", 0, nan);
+    test_from_chars("nan", 0, nan);
+    test_from_chars("-.e1", 0, nan);
+    test_from_chars(",1", 0, nan);
+
+    test_from_chars("0", 1, zero);
+    test_from_chars("-0.", 3, zero);
+    test_from_chars("0.00e-999", 9, zero);
+    test_from_chars("1", 1, one);
+    test_from_chars("1.00", 4, one);
+    test_from_chars(".100e00000000001", 16, one);
+    test_from_chars("10.00e-00000000001", 18, one);
+    test_from_chars("1e1", 3, ten);
+    test_from_chars("1E+1", 4, ten);
+    test_from_chars("36028797018963967", 17, maxint);
+    test_from_chars("36028797018963970", 17, maxint_plus);
+    test_from_chars("3.6028797018963967e143", 22, maxnum);
+    test_from_chars("1e+999", 6, nan);
+    test_from_chars("100e-129", 8, minnum);
+    test_from_chars("0.000000000000000100000000000000000000", 38, epsilon);
+    test_from_chars("-.9999999999999999", 18, almost_negative_one);
+    test_from_chars("-31415926535897932E-16", 22, negative_pi);
+    test_from_chars("-36028797018963968e127", 22, negative_maxnum);
+
+    test_from_chars("12.5,7", 4, dec64_new(125, -1));
+    test_from_chars("12.5\t7", 4, dec64_new(125, -1));
+    test_from_chars("12.5.7", 4, dec64_new(125, -1));
+    test_from_chars("1,000", 1, one);
+    test_from_chars("7e", 1, seven);
+    test_from_chars("7e+", 1, seven);
+    test_from_chars("7e-x", 1, seven);
+    test_from_chars("7ex", 1, seven);
+    test_from_chars("-9E-0000000000000000000000;", 26, negative_nine);
+    test_from_chars("1.2345e3 ", 8, dec64_new(12345, -1));
+    test_from_chars("1234x678", 4, dec64_new(1234, 0));
+    test_from_chars("12345678x", 8, dec64_new(12345678, 0));
+    test_from_chars("1.", 2, one);
+    test_from_chars("12.3x", 4, dec64_new(123, -1));
+    test_from_chars("000000000012.5x", 14, dec64_new(125, -1));
+    test_from_chars("1234567890123456789,", 19, dec64_new(123456789012345678, 1));
+}
+
+static void judge_count(const char* name, size_t expected, size_t actual) {
+    if (expected == actual) {
+        nr_pass += 1;
+    } else {
+        nr_fail += 1;
+        if (level >= 1) {
+            printf("\n\nFAIL %s: %i, not %i", name, (int)actual, (int)expected);
+        }
+    }
+}
+
+static void test_format_column(
+    int places,
+    dec64_string_char separator,
+    size_t capacity
+) {
+/*
+    dec64_format_column must give what dec64_to_string gives for every
+    number, with the separator between them, however many calls the buffer
+    makes it take.
+*/
+    dec64 numbers[100];
+    dec64_string_char expected[8000];
+    dec64_string_char actual[8000];
+    dec64_string_char buffer[4096];
+    dec64_string_char string[256];
+    dec64_string_state column_state = dec64_string_begin();
+    size_t expected_length = 0;
+    size_t actual_length = 0;
+    size_t length;
+    size_t cursor = 0;
+    int nr_calls = 0;
+    int at;
+
+    dec64_string_places(column_state, (dec64_string_char)places);
+    dec64_string_separator(column_state, ',');
+    numbers[0] = nan;
+    numbers[1] = zero;
+    numbers[2] = maxnum;
+    numbers[3] = negative_maxint;
+    numbers[4] = epsilon;
+    numbers[5] = negative_pi;
+    numbers[6] = minnum;
+    for (at = 7; at < 100; at += 1) {
+        numbers[at] = dec64_new((int64)at * 7919 * (at % 2 == 0 ? 1 : -1), -(at % 5));
+    }
+    for (at = 0; at < 100; at += 1) {
+        if (at > 0 && separator != 0) {
+            expected[expected_length] = separator;
+            expected_length += 1;
+        }
+        length = dec64_to_string(column_state, numbers[at], string);
+        memcpy(expected + expected_length, string, length);
+        expected_length += length;
+    }
+    do {
+        length = dec64_format_column(
+            column_state,
+            numbers,
+            100,
+            separator,
+            buffer,
+            capacity,
+            &cursor
+        );
+        memcpy(actual + actual_length, buffer, length);
+        actual_length += length;
+        nr_calls += 1;
+    } while (cursor < 100 && nr_calls < 1000);
+    if (
+        actual_length == expected_length
+        && memcmp(actual, expected, expected_length) == 0
+        && (capacity < expected_length || nr_calls == 1)
+    ) {
+        nr_pass += 1;
+    } else {
+        nr_fail += 1;
+        if (level >= 1) {
+            printf("\n\nFAIL format_column: places %i capacity %i", places, (int)capacity);
+            if (level >= 2) {
+                printf("\n%-4s\"%.*s\"", "?", (int)actual_length, actual);
+                printf("\n%-4s\"%.*s\"", "=", (int)expected_length, expected);
+            }
+        }
+    }
+    dec64_string_end(column_state);
+}
+
+static void test_format_columns() {
+/*
+    Two columns formatted in turn with one state must each continue from
+    their own cursor. A buffer with no room for the longest number must
+    deposit nothing and leave the cursor alone.
+*/
+    dec64 numbers[2][50];
+    dec64_string_char expected[2][4000];
+    dec64_string_char actual[2][4000];
+    dec64_string_char string[256];
+    size_t expected_length[2] = {0, 0};
+    size_t actual_length[2] = {0, 0};
+    size_t cursor[2] = {0, 0};
+    size_t length;
+    int nr_calls = 0;
+    int which;
+    int at;
+
+    for (at = 0; at < 50; at += 1) {
+        numbers[0][at] = dec64_new((int64)at * 31337, -(at % 4));
+        numbers[1][at] = dec64_new(-(int64)at * 7, at % 3);
+    }
+    for (which = 0; which < 2; which += 1) {
+        for (at = 0; at < 50; at += 1) {
+            if (at > 0) {
+                expected[which][expected_length[which]] = ';';
+                expected_length[which] += 1;
+            }
+            length = dec64_to_string(state, numbers[which][at], string);
+            memcpy(expected[which] + expected_length[which], string, length);
+            expected_length[which] += length;
+        }
+    }
+    while ((cursor[0] < 50 || cursor[1] < 50) && nr_calls < 1000) {
+        for (which = 0; which < 2; which += 1) {
+            actual_length[which] += dec64_format_column(
+                state,
+                numbers[which],
+                50,
+                ';',
+                actual[which] + actual_length[which],
+                80,
+                &cursor[which]
+            );
+        }
+        nr_calls += 1;
+    }
+    for (which = 0; which < 2; which += 1) {
+        judge_count("format_columns length", expected_length[which], actual_length[which]);
+        judge_count(
+            "format_columns characters",
+            0,
+            (size_t)(memcmp(actual[which], expected[which], expected_length[which]) != 0)
+        );
+    }
+    cursor[0] = 7;
+    judge_count(
+        "format_column small",
+        0,
+        dec64_format_column(state, numbers[0], 50, ';', string, 64, &cursor[0])
+    );
+    judge_count("format_column small cursor", 7, cursor[0]);
+    judge_count(
+        "format_column null cursor",
+        0,
+        dec64_format_column(state, numbers[0], 50, ';', string, 256, NULL)
+    );
+}
+
+static void test_all_format_column() {
+    test_format_column(0, ';', 4096);
+    test_format_column(0, '\n', 65);
+    test_format_column(0, 0, 100);
+    test_format_column(2, '\t', 67);
+    test_format_column(2, ';', 200);
+    test_format_column(10, ';', 1000);
+    test_format_columns();
+}
+
+static void judge_state(
+    const char* name,
+    dec64 number,
+    dec64_string_char * expected,
+    dec64_string_char * actual
+) {
+    if (strcmp(expected, actual) == 0) {
+        nr_pass += 1;
+    } else {
+        nr_fail += 1;
+        if (level >= 1) {
+            printf("\n\nFAIL %s: ", name);
+            print_dec64(number);
+            if (level >= 2) {
+                printf("\n%-4s\"%s\"", "?", actual);
+                printf("\n%-4s\"%s\"", "=", expected);
+            }
+        }
+    }
+}
+
+static void configure_state(dec64_string_state target, int how) {
+    dec64_string_places(target, (dec64_string_char)(how == 1 ? 2 : 0));
+    dec64_string_separator(target, (dec64_string_char)(how == 1 ? ',' : 0));
+    dec64_string_decimal_point(target, (dec64_string_char)(how == 1 ? ',' : '.'));
+    if (how == 1) {
+        dec64_string_separator(target, '.');
+    }
+    if (how == 2) {
+        dec64_string_scientific(target);
+    } else if (how == 3) {
+        dec64_string_engineering(target);
+    } else {
+        dec64_string_standard(target);
+    }
+}
+
+static void test_all_state() {
+/*
+    A state in the caller's storage and the default state of the thread must
+    convert as a state from dec64_string_begin does, in every configuration.
+*/
+    struct dec64_string_state local;
+    dec64_string_state allocated = dec64_string_begin();
+    dec64_string_state thread = dec64_string_default();
+    dec64_string_char expected[256];
+    dec64_string_char actual[256];
+    dec64 numbers[8];
+    int how;
+    int at;
+
+    numbers[0] = nan;
+    numbers[1] = zero;
+    numbers[2] = pi;
+    numbers[3] = negative_maxint;
+    numbers[4] = maxnum;
+    numbers[5] = minnum;
+    numbers[6] = cent;
+    numbers[7] = dec64_new(-1234567, -3);
+    dec64_string_state_init(&local);
+    for (how = 0; how < 4; how += 1) {
+        configure_state(allocated, how);
+        configure_state(&local, how);
+        configure_state(thread, how);
+        for (at = 0; at < 8; at += 1) {
+            dec64_to_string(allocated, numbers[at], expected);
+            dec64_to_string(&local, numbers[at], actual);
+            judge_state("state_init", numbers[at], expected, actual);
+            dec64_to_string(thread, numbers[at], actual);
+            judge_state("string_default", numbers[at], expected, actual);
+        }
+    }
+    configure_state(thread, 0);
+    dec64_string_end(thread);
+    dec64_to_string(dec64_string_default(), pi, actual);
+    judge_state(
+        "string_default",
+        pi,
+        thread == dec64_string_default() ? "3.1415926535897932" : "",
+        actual
+    );
+    dec64_string_end(&local);
+    strcpy(actual, "x");
+    dec64_to_string(&local, pi, actual);
+    judge_state("state_init end", pi, "x", actual);
+    dec64_string_end(allocated);
+}
+
+static void test_cache(size_t nr_entries) {
+/*
+    dec64_to_string_cached must give what dec64_to_string gives, whether it
+    hits or misses, as the spec changes and entries are replaced. A number
+    converted again at once is a hit, unless its string is too long to keep,
+    and no other number repeats with the same spec.
+*/
+    dec64_string_state cache_state = dec64_string_begin();
+    dec64_string_cache cache = dec64_string_cache_begin(nr_entries);
+    dec64_string_char expected[256];
+    dec64_string_char actual[256];
+    dec64 number;
+    size_t nr_calls = 0;
+    size_t nr_hits = 0;
+    int expected_length;
+    int length;
+    int how;
+    int at;
+
+    for (how = 0; how < 5; how += 1) {
+        configure_state(cache_state, how % 4);
+        if (how == 4) {
+            dec64_string_places(cache_state, 40);
+        }
+        for (at = 0; at < 300; at += 1) {
+            number = (
+                at == 0 ? nan
+                : at == 1 ? maxnum
+                : at == 2 ? negative_minnum
+                : dec64_new((int64)(at % 97) * 100003 - 4000000, -(at % 4))
+            );
+            expected_length = dec64_to_string(cache_state, number, expected);
+            length = dec64_to_string_cached(cache_state, cache, number, actual);
+            judge_state("to_string_cached", number, expected, actual);
+            judge_count("to_string_cached length", expected_length, length);
+            length = dec64_to_string_cached(cache_state, cache, number, NULL);
+            judge_count("to_string_cached count", expected_length, length);
+            nr_calls += 2;
+            nr_hits += expected_length < 32;
+        }
+    }
+    judge_count(
+        "cache calls",
+        nr_calls,
+        dec64_string_cache_hits(cache) + dec64_string_cache_misses(cache)
+    );
+    judge_count("cache hits", nr_hits, dec64_string_cache_hits(cache));
+    dec64_string_cache_end(cache);
+    dec64_string_end(cache_state);
+}
+
+static void test_all_cache() {
+    test_cache(1);
+    test_cache(7);
+    test_cache(4096);
+    judge_count("to_string_cached no cache", 18, dec64_to_string_cached(
+        state,
+        NULL,
+        pi,
+        NULL
+    ));
+}
+
+static void test_parse_column(
+    dec64_string_char * buffer,
+    size_t length,
+    int last_chunk,
+    dec64_string_char separator,
+    size_t max,
+    size_t expected_consumed,
+    size_t expected_n,
+    const dec64 * expected
+) {
+/*
+    dec64_parse_column must give the expected numbers and use the expected
+    number of characters. The errors must be the fields that are nan.
+*/
+    dec64 actual[20];
+    size_t errors[20];
+    size_t consumed;
+    size_t nr_errors;
+    size_t nr_nans = 0;
+    size_t at;
+    size_t n = dec64_parse_column(
+        state,
+        buffer,
+        length,
+        last_chunk,
+        separator,
+        actual,
+        max,
+        &consumed,
+        errors,
+        &nr_errors
+    );
+    int ok = n == expected_n && consumed == expected_consumed;
+
+    for (at = 0; ok && at < n; at += 1) {
+        if (dec64_exponent(expected[at]) == -128) {
+            ok = dec64_exponent(actual[at]) == -128
+                && nr_nans < nr_errors
+                && errors[nr_nans] == at;
+            nr_nans += 1;
+        } else {
+            ok = dec64_is_equal(expected[at], actual[at]) == DEC64_ONE;
+        }
+    }
+    if (ok && nr_nans == nr_errors) {
+        nr_pass += 1;
+    } else {
+        nr_fail += 1;
+        if (level >= 1) {
+            printf("\n\nFAIL parse_column: %.*s", (int)length, buffer);
+            if (level >= 2) {
+                for (at = 0; at < n; at += 1) {
+                    printf("\n%-4s", "?");
+                    print_dec64(actual[at]);
+                }
+                printf("\n%-4s%i fields, %i characters, %i errors", "?", (int)n, (int)consumed, (int)nr_errors);
+                for (at = 0; at < expected_n; at += 1) {
+                    printf("\n%-4s", "=");
+                    print_dec64(expected[at]);
+                }
+                printf("\n%-4s%i fields, %i characters", "=", (int)expected_n, (int)expected_consumed);
+            }
+        }
+    }
+}
+
+static void test_round_trip_column(dec64_string_char separator) {
+/*
+    A column written by dec64_format_column must be read back by
+    dec64_parse_column, a few fields at a time, from chunks of at most 40
+    characters, as a reader of a file would get them. A field cut by the end
+    of a chunk must be left for the next one.
+*/
+    dec64 numbers[100];
+    dec64 actual[100];
+    dec64_string_char buffer[4096];
+    size_t length;
+    size_t consumed;
+    size_t chunk;
+    size_t cursor = 0;
+    size_t total = 0;
+    size_t n = 0;
+    int nr_calls = 0;
+    int ok = 1;
+    int at;
+
+    for (at = 0; at < 100; at += 1) {
+        numbers[at] = dec64_new((int64)at * 104729 * (at % 3 == 0 ? -1 : 1), -(at % 7));
+    }
+    numbers[10] = maxint;
+    numbers[20] = negative_maxnum;
+    numbers[30] = almost_one;
+    numbers[40] = minnum;
+    length = dec64_format_column(state, numbers, 100, separator, buffer, sizeof buffer, &cursor);
+    while (n < 100 && total < length && nr_calls < 1000) {
+        chunk = length - total < 40 ? length - total : 40;
+        n += dec64_parse_column(
+            state,
+            buffer + total,
+            chunk,
+            total + chunk == length,
+            separator,
+            actual + n,
+            7,
+            &consumed,
+            NULL,
+            NULL
+        );
+        total += consumed;
+        nr_calls += 1;
+    }
+    for (at = 0; at < 100 && ok; at += 1) {
+        ok = dec64_is_equal(numbers[at], actual[at]) == DEC64_ONE;
+    }
+    if (ok && n == 100 && total == length) {
+        nr_pass += 1;
+    } else {
+        nr_fail += 1;
+        if (level >= 1) {
+            printf("\n\nFAIL parse_column round trip: %.*s", (int)length, buffer);
+        }
+    }
+}
+
+static void test_all_parse_column() {
+    dec64 mixed[6];
+    dec64 money[3];
+    dec64 long_fields[4];
+    dec64 counting[4];
+
+    mixed[0] = one;
+    mixed[1] = dec64_new(25, -1);
+    mixed[2] = dec64_new(-3, 0);
+    mixed[3] = nan;
+    mixed[4] = nan;
+    mixed[5] = dec64_new(1, 3);
+    test_parse_column("1,2.5,-3,,x,1e3", 15, 1, ',', 20, 15, 6, mixed);
+    test_parse_column("1,2.5,-3,,x,1e3,", 16, 1, ',', 20, 16, 6, mixed);
+    test_parse_column("1,2.5,-3,,x,1e3", 15, 1, ',', 4, 10, 4, mixed);
+    test_parse_column("-3,,x,1e3", 9, 1, ',', 2, 4, 2, mixed + 2);
+    test_parse_column("", 0, 1, ',', 20, 0, 0, mixed);
+    test_parse_column("1\n2.5\n", 6, 1, '\n', 20, 6, 2, mixed);
+    test_parse_column("1\0002.5", 5, 1, '\n', 20, 5, 1, mixed + 3);
+    test_parse_column("1,2.5,-3,,x,1e3", 15, 0, ',', 20, 12, 5, mixed);
+    test_parse_column("1,2.5,-3,,x,1e3,", 16, 0, ',', 20, 16, 6, mixed);
+    test_parse_column("1,2.5,-3,,x,1e3", 15, 0, ',', 4, 10, 4, mixed);
+    test_parse_column("1,12.3", 6, 0, ',', 20, 2, 1, mixed);
+    test_parse_column("2.5", 3, 0, ',', 20, 0, 0, mixed + 1);
+    test_parse_column("2.5", 3, 1, ',', 20, 3, 1, mixed + 1);
+    test_parse_column("", 0, 0, ',', 20, 0, 0, mixed);
+
+    long_fields[0] = maxint;
+    long_fields[1] = epsilon;
+    long_fields[2] = pi;
+    long_fields[3] = negative_maxnum;
+    test_parse_column(
+        "36028797018963967|0.000000000000000100000000000|3.1415926535897932|-36028797018963968e127",
+        89,
+        1,
+        '|',
+        20,
+        89,
+        4,
+        long_fields
+    );
+
+    counting[0] = dec64_new(1234567, 0);
+    counting[1] = dec64_new(-12345678901234567, -8);
+    counting[2] = nan;
+    counting[3] = ten;
+    test_parse_column("1,234,567\t-123456789.01234567\t1-2\t10", 36, 1, '\t', 20, 36, 4, counting);
+
+    dec64_string_decimal_point(state, ',');
+    dec64_string_separator(state, '.');
+    money[0] = dec64_new(12345, -1);
+    money[1] = seven;
+    money[2] = dec64_new(-5, -2);
+    test_parse_column("1.234,5;7;-0,05", 15, 1, ';', 20, 15, 3, money);
+    dec64_string_decimal_point(state, '.');
+    dec64_string_separator(state, ',');
+
+    test_round_trip_column(';');
+    test_round_trip_column('\n');
 }
 
 static int do_tests(int level_of_detail) {
@@ -570,8 +1317,14 @@ static int do_tests(int level_of_detail) {
     test_to_place();
     test_to_scientific();
     test_to_engineering();
+    test_all_format_column();
+    test_all_state();
+    test_all_cache();
 
     test_all_from();
+    test_all_from_fast();
+    test_all_from_chars();
+    test_all_parse_column();
 
     printf("\n\n%i pass, %i fail.\n", nr_pass, nr_fail);
     dec64_string_end(state);
@@ -11,6 +11,7 @@ No warranty.
 
 #include <stdio.h>
 #include "dec64.h"
+#include "dec64_inline.h"
 
 #define false DEC64_FALSE
 #define true  DEC64_TRUE
@@ -325,6 +326,11 @@ static void test_ceiling(dec64 first, dec64 expected, char* comment) {
     judge_unary(first, expected, actual, "ceiling", "c", comment);
 }
 
+static void test_digits(int64 coefficient, int64 expected, char* comment) {
+    dec64 actual = dec64_new(dec64_digits(coefficient), 0);
+    judge_is_false(dec64_new(expected, 0), actual, "digits", comment);
+}
+
 static void test_divide(
     dec64 first,
     dec64 second,
@@ -340,6 +346,37 @@ static void test_floor(dec64 first, dec64 expected, char* comment) {
     judge_unary(first, expected, actual, "floor", "f", comment);
 }
 
+static void test_fma(
+    dec64 first,
+    dec64 second,
+    dec64 third,
+    dec64 expected,
+    char* comment
+) {
+/*
+    The sum is judged with the product and the addend, and the addend is
+    printed on its own line when the test fails.
+*/
+    dec64 actual = dec64_fma(first, second, third);
+    judge_binary(first, second, expected, actual, "fma", "*", comment);
+    if (level >= 2 && !compare(expected, actual)) {
+        printf("\n%-4s", "+");
+        print_dec64(third);
+    }
+}
+
+static void test_inline_add(dec64 first, dec64 second, char* comment) {
+    dec64 expected = dec64_add(first, second);
+    dec64 actual = dec64_inline_add(first, second);
+    judge_communitive(first, second, expected, actual, "inline_add", "+", comment);
+}
+
+static void test_inline_subtract(dec64 first, dec64 second, char* comment) {
+    dec64 expected = dec64_subtract(first, second);
+    dec64 actual = dec64_inline_subtract(first, second);
+    judge_binary(first, second, expected, actual, "inline_subtract", "-", comment);
+}
+
 static void test_integer_divide(
     dec64 first,
     dec64 second,
@@ -537,6 +574,25 @@ static void test_all_add() {
     test_add(dec64_new(7182818284590704, -16), dec64_new(10, -1), dec64_new(17182818284590704, -16), "7182818284590704e-16 + 10e-1");
     test_add(dec64_new(4000000000000000, -16), dec64_new(10, -1), dec64_new(14000000000000000, -16), "4000000000000000e-16 + 10e-1");
     test_add(dec64_new(1, -1), dec64_new(2, -1), dec64_new(3, -1), "0.1 + 0.2");
+    test_add(
+        dec64_new(-17134056954809823, 17),
+        dec64_new(-11990717747192499, -9),
+        dec64_new(-17134056954809823, 17),
+        "-1.7e33 + -1.2e7"
+    );
+    test_add(
+        dec64_new(-177905096900, 13),
+        dec64_new(-9694644281974603, -10),
+        dec64_new(-17790509690000000, 8),
+        "-1.8e24 + -9.7e5"
+    );
+    test_add(dec64_new(-4, -17), five, five, "-4e-17 + 5");
+    test_add(
+        dec64_new(12345678901234567, -20),
+        one,
+        dec64_new(10001234567890123, -16),
+        "1.2345678901234567e-4 + 1"
+    );
 }
 
 static void test_all_ceiling() {
@@ -593,6 +649,29 @@ static void test_all_ceiling() {
     test_ceiling(dec64_new(-9999999999999998, -16), zero, "-0.9...8");
 }
 
+static void test_all_digits() {
+    test_digits(0, 0, "zero");
+    test_digits(1, 1, "one");
+    test_digits(-1, 1, "negative one");
+    test_digits(9, 1, "nine");
+    test_digits(10, 2, "ten");
+    test_digits(-10, 2, "negative ten");
+    test_digits(99, 2, "99");
+    test_digits(100, 3, "100");
+    test_digits(999999999, 9, "999999999");
+    test_digits(1000000000, 10, "1000000000");
+    test_digits(9999999999999999, 16, "9999999999999999");
+    test_digits(10000000000000000, 17, "10000000000000000");
+    test_digits(36028797018963967, 17, "maxint");
+    test_digits(-36028797018963968, 17, "negative maxint");
+    test_digits(99999999999999999, 17, "99999999999999999");
+    test_digits(100000000000000000, 18, "100000000000000000");
+    test_digits(999999999999999999, 18, "999999999999999999");
+    test_digits(1000000000000000000, 19, "1000000000000000000");
+    test_digits(9223372036854775807, 19, "int64 max");
+    test_digits(-9223372036854775807 - 1, 19, "int64 min");
+}
+
 static void test_all_divide() {
     test_divide(six, three, dec64_new(20000000000000000, -16), "6 / 3");
     test_divide(nonnan, two, nan, "nonnan / 2");
@@ -684,6 +763,70 @@ static void test_all_divide() {
     test_divide(one, 0x52D09F700003LL, dec64_new(28114572543455208, -31), "1/17!");
 }
 
+static void test_all_fma() {
+    test_fma(nan, one, one, nonnan, "nan * 1 + 1");
+    test_fma(one, one, nonnan, nonnan, "1 * 1 + nonnan");
+    test_fma(nan, zero, one, one, "nan * 0 + 1");
+    test_fma(zero, zero, zero, zero, "0 * 0 + 0");
+    test_fma(zero, maxnum, pi, pi, "0 * maxnum + pi");
+    test_fma(pi, one, zero, pi, "pi * 1 + 0");
+    test_fma(dec64_new(1999, -2), three, dec64_new(250, -2), dec64_new(6247, -2), "19.99 * 3 + 2.50");
+    test_fma(dec64_new(1999, -2), dec64_new(3, 0), dec64_new(-5997, -2), zero, "19.99 * 3 - 59.97");
+    test_fma(two, three, dec64_new(5, -1), dec64_new(65, -1), "2 * 3 + 0.5");
+    test_fma(
+        dec64_new(10000000000000001, -16),
+        dec64_new(10000000000000001, -16),
+        negative_one,
+        dec64_new(20000000000000001, -32),
+        "(1 + 1e-16) ^ 2 - 1 keeps the last digit"
+    );
+    test_fma(
+        dec64_new(12345678901234565, 0),
+        three,
+        zero,
+        dec64_new(3703703670370370, 1),
+        "a tie rounds away from zero"
+    );
+    test_fma(
+        dec64_new(12345678901234565, 0),
+        three,
+        dec64_new(-1, -100),
+        dec64_new(3703703670370369, 1),
+        "a tiny addend below a tie rounds down"
+    );
+    test_fma(
+        dec64_new(-12345678901234565, 0),
+        three,
+        dec64_new(1, -100),
+        dec64_new(-3703703670370369, 1),
+        "a tiny addend above a negative tie rounds toward zero"
+    );
+    test_fma(
+        dec64_new(12345678901234565, 0),
+        three,
+        dec64_new(1, -100),
+        dec64_new(3703703670370370, 1),
+        "a tiny addend above a tie rounds up"
+    );
+    test_fma(
+        dec64_new(5, -127),
+        dec64_new(1, -1),
+        dec64_new(-1, -127),
+        dec64_new(-1, -127),
+        "-5e-128 rounds once to -minnum"
+    );
+    test_fma(minnum, dec64_new(1, -10), minnum, minnum, "minnum * 1e-10 + minnum");
+    test_fma(maxnum, ten, one, nonnan, "maxnum * 10 + 1");
+    test_fma(maxnum, one, negative_maxnum, dec64_new(-1, 127), "maxnum * 1 + negative_maxnum");
+    test_fma(
+        dec64_new(36028797018963967, 0),
+        dec64_new(36028797018963967, 0),
+        negative_one,
+        dec64_new(12980742146337068, 17),
+        "maxint * maxint - 1"
+    );
+}
+
 static void test_all_floor() {
     test_floor(nan, nan, "nan");
     test_floor(nonnan, nan, "nonnan");
@@ -752,6 +895,35 @@ static void test_all_floor() {
     test_floor(dec64_new(-9999999999999998, -16), negative_one, "-0.9...8");
 }
 
+static void test_all_inline() {
+    test_inline_add(nan, zero, "nan + zero");
+    test_inline_add(nan, nan, "nan + nan");
+    test_inline_add(nonnan, nonnan, "nonnan + nonnan");
+    test_inline_add(zero, zip, "zero + zip");
+    test_inline_add(zip, zip, "zip + zip");
+    test_inline_add(one, one, "one + one");
+    test_inline_add(one, negative_one, "one + -1");
+    test_inline_add(cent, cent, "cent + cent");
+    test_inline_add(dec64_new(1999, -2), dec64_new(-1999, -2), "money to zero");
+    test_inline_add(dec64_new(1999, -2), dec64_new(2501, -2), "money");
+    test_inline_add(pi, e, "same exponent");
+    test_inline_add(pi, one, "different exponents");
+    test_inline_add(maxint, one, "overflow");
+    test_inline_add(negative_maxint, negative_one, "negative overflow");
+    test_inline_add(maxnum, maxnum, "maxnum + maxnum");
+    test_inline_subtract(nan, zero, "nan - zero");
+    test_inline_subtract(zero, nan, "zero - nan");
+    test_inline_subtract(zip, zip, "zip - zip");
+    test_inline_subtract(zero, negative_maxint, "0 - -maxint");
+    test_inline_subtract(one, one, "one - one");
+    test_inline_subtract(ten, six, "10 - 6");
+    test_inline_subtract(dec64_new(1999, -2), dec64_new(2501, -2), "money");
+    test_inline_subtract(negative_pi, pi, "-pi - pi");
+    test_inline_subtract(one, epsilon, "different exponents");
+    test_inline_subtract(negative_maxint, one, "overflow");
+    test_inline_subtract(maxint, negative_one, "negative overflow");
+}
+
 static void test_all_integer_divide() {
     test_integer_divide(nan, three, nan, "nan / 3");
     test_integer_divide(six, nan, nan, "6 / nan");
@@ -953,6 +1125,22 @@ static void test_all_is_less() {
     test_is_less(negative_epsilon, negative_maxint, false, "-epsilon < -maxint");
     test_is_less(negative_maxint_minus, negative_maxint, true, "-maxint < -maxint-1");
     test_is_less(negative_minnum, negative_maxnum, false, "-minnum < -maxnum");
+
+    //The backends answer 1 or 0. Numbers of one sign that a subtraction could not
+    // tell apart, because it rounds or overflows
+    test_is_less(negative_maxint_minus, negative_maxint, one, "-maxint-1 < -maxint is 1");
+    test_is_less(negative_maxint, negative_maxint_minus, zero, "-maxint < -maxint-1 is 0");
+    test_is_less(negative_minnum, negative_maxnum, zero, "-minnum < -maxnum is 0");
+    test_is_less(negative_maxnum, negative_minnum, one, "-maxnum < -minnum is 1");
+    test_is_less(minnum, maxnum, one, "minnum < maxnum is 1");
+    test_is_less(
+        dec64_new(-17134056954809823, 17),
+        dec64_new(-11990717747192499, -9),
+        one,
+        "-1.7e33 < -1.2e7 is 1"
+    );
+    test_is_less(dec64_new(36028797018963967, -1), dec64_new(3602879701896397, 0), one, "3602879701896396.7 < 3602879701896397 is 1");
+    test_is_less(dec64_new(10, -1), one, zero, "1.0 < 1 is 0");
 }
 
 static void test_all_is_nan() {
@@ -1180,6 +1368,14 @@ static void test_all_new() {
     test_new(9223372036854775807, -145, (9LL << 8) + (0xff & -127), "9223372036854775807e-145");
     test_new(-9223372036854775807, -146, 0xFFFFFFFFFFFFFF00 + (0x81), "-9223372036854775807e-146");
     test_new(9223372036854775807, -146, (1LL << 8) + (0xff & -127), "9223372036854775807e-146");
+    test_new(360287970189639675, -1, (3602879701896397LL << 8) + 1, "rounding carries into an extra digit");
+    test_new(-360287970189639685, -1, (-3602879701896397LL << 8) + 1, "negative rounding carries into an extra digit");
+    test_new(1, 130, (1000LL << 8) + 127, "1e130");
+    test_new(-3602879701896396, 128, (-36028797018963960LL << 8) + 127, "-3602879701896396e128");
+    test_new(3602879701896397, 128, nonnan, "3602879701896397e128");
+    test_new(1, 145, nonnan, "1e145");
+    test_new(499999999999999999, -146, 0, "499999999999999999e-146");
+    test_new(500000000000000000, -145, minnum, "500000000000000000e-145");
 }
 
 void test_all_normal() {
@@ -1408,6 +1604,36 @@ static void test_all_subtract() {
     test_subtract(maxnum, negative_maxint, maxnum, "maxnum - -maxint");
     test_subtract(maxnum, maxnum, zero, "maxnum - maxnum");
     test_subtract(almost_negative_one, almost_negative_one, zero, "almost_negative_one - almost_negative_one");
+    test_subtract(
+        dec64_new(-17134056954809823, 17),
+        dec64_new(-11990717747192499, -9),
+        dec64_new(-17134056954809823, 17),
+        "-1.7e33 - -1.2e7"
+    );
+    test_subtract(dec64_new(1, -17), maxint, dec64_new(-36028797018963967, 0), "1e-17 - maxint");
+    test_subtract(
+        dec64_new(11990717747192499, -9),
+        dec64_new(17134056954809823, 17),
+        dec64_new(-17134056954809823, 17),
+        "1.2e7 - 1.7e33"
+    );
+    test_subtract(
+        dec64_new(-139497, 11),
+        dec64_new(422739148927212, 18),
+        dec64_new(-422739148927212, 18),
+        "-1.4e16 - 4.2e32"
+    );
+    test_subtract(dec64_new(-4, -17), five, dec64_new(-5, 0), "-4e-17 - 5");
+    test_subtract(dec64_new(1320, -18), dec64_new(1808467989, -6), dec64_new(-1808467989, -6), "1.32e-15 - 1808.467989");
+    test_subtract(negative_minnum, negative_maxnum, nonnan, "-minnum - -maxnum");
+    test_subtract(minnum, negative_maxnum, nonnan, "minnum - -maxnum");
+    test_subtract(minnum, maxnum, dec64_new(-36028797018963967, 127), "minnum - maxnum");
+    test_subtract(
+        dec64_new(12345678901234567, -20),
+        one,
+        dec64_new(-9998765432109877, -16),
+        "1.2345678901234567e-4 - 1"
+    );
 }
 
 static int do_tests(int level_of_detail) {
@@ -1425,8 +1651,11 @@ static int do_tests(int level_of_detail) {
     test_all_abs();
     test_all_add();
     test_all_ceiling();
+    test_all_digits();
     test_all_divide();
     test_all_floor();
+    test_all_fma();
+    test_all_inline();
     test_all_integer_divide();
     test_all_is_equal();
     test_all_is_false();
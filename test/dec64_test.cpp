@@ -11,7 +11,7 @@ No warranty.
 */
 
 #include <cstdio>
-#include <Dec64.h>
+#include "dec64.h"
 #include <iostream>
 
 
@@ -57,11 +57,11 @@ Dec64 negative_maxnum;
 Dec64 negative_pi;
 
 static void define_constants() {
-    dec64nan         = Dec64(DEC64_NAN , 0, true);   /* not a number */
-    nannan           = Dec64(32896     , 0, true);   /* a non-normal nan */
-    zero             = Dec64(DEC64_ZERO, 0, true);   /* 0 */
-    zip              = Dec64(250       , 0, true);   /* a non normal 0 */
-    one              = Dec64(DEC64_ONE , 0, true);   /* 1 */
+    dec64nan         = Dec64(dec64_raw, DEC64_NAN );   /* not a number */
+    nannan           = Dec64(dec64_raw, 32896     );   /* a non-normal nan */
+    zero             = Dec64(dec64_raw, DEC64_ZERO);   /* 0 */
+    zip              = Dec64(dec64_raw, 250       );   /* a non normal 0 */
+    one              = Dec64(dec64_raw, DEC64_ONE );   /* 1 */
     two              = Dec64(2);          	/* 2 */
     three            = Dec64(3);        	/* 3 */
     four             = Dec64(4);         	/* 4 */
@@ -294,6 +294,11 @@ static void test_floor(Dec64 first, Dec64 expected, std::string comment) {
     judge_unary(first, expected, actual, "floor", "f", comment);
 }
 
+static void test_fma(Dec64 first, Dec64 second, Dec64 third, Dec64 expected, std::string comment) {
+    Dec64 actual = first.fma(second, third);
+    judge_binary(first, second, expected, actual, "fma", "*", comment);
+}
+
 static void test_half(Dec64 first, Dec64 expected, std::string comment) {
     Dec64 actual = first.half();
     judge_unary(first, expected, actual, "half", "h", comment);
@@ -305,7 +310,7 @@ static void test_inc(Dec64 first, Dec64 expected, std::string comment) {
 }
 
 static void test_int(Dec64 first, Dec64 expected, std::string comment) {
-    Dec64 actual = Dec64(first.to_int(),0,true);
+    Dec64 actual = Dec64(dec64_raw, first.to_int());
     judge_unary(first, expected, actual, "int", "i", comment);
 }
 
@@ -384,7 +389,7 @@ static void test_all_abs() {
     test_abs(nannan,   dec64nan, "nannan");
     test_abs(zero, zero, "zero");
     test_abs(zip, zero, "zip");
-    test_abs(Dec64(100, 0, true), zero, "zero alias");
+    test_abs(Dec64(dec64_raw, 100), zero, "zero alias");
     test_abs(one, one, "one");
     test_abs(negative_one, one, "-1");
     test_abs(almost_negative_one, almost_one, "almost_negative_one");
@@ -598,8 +603,8 @@ static void test_all_divide() {
     test_divide(Dec64(1000000000000000, -15), maxint, one_over_maxint, "one / maxint alias 15");
     test_divide(Dec64(10000000000000000, -16), maxint, one_over_maxint, "one / maxint alias 16");
     test_divide(minnum, two, minnum, "minnum / 2");
-    test_divide(one, Dec64(0x1437EEECD800000LL, 0, true), Dec64(28114572543455208, -31), "1/17!");
-    test_divide(one, Dec64(0x52D09F700003LL, 0, true), Dec64(28114572543455208, -31), "1/17!");
+    test_divide(one, Dec64(dec64_raw, 0x1437EEECD800000LL), Dec64(28114572543455208, -31), "1/17!");
+    test_divide(one, Dec64(dec64_raw, 0x52D09F700003LL), Dec64(28114572543455208, -31), "1/17!");
 }
 
 static void test_all_equal() {
@@ -623,7 +628,7 @@ static void test_all_equal() {
     test_equal(maxint, maxnum, zero, "maxint = maxnum");
     test_equal(negative_maxint, maxint, zero, "-maxint = maxint");
     test_equal(negative_maxint, negative_one, zero, "-maxint = -1");
-    test_equal(Dec64(0x1437EEECD800000LL, 0, true), Dec64(0x52D09F700003LL, 0, true), one, "17!");
+    test_equal(Dec64(dec64_raw, 0x1437EEECD800000LL), Dec64(dec64_raw, 0x52D09F700003LL), one, "17!");
 }
 
 static void test_all_floor() {
@@ -769,12 +774,27 @@ void test_all_int() {
     test_int(Dec64(-12500000000000000, -16), Dec64(-2, -0), "-1.25");
     test_int(maxint, maxint, "maxint");
     test_int(negative_maxint, negative_maxint, "negative_maxint");
-    test_int(maxint_plus, Dec64(36028797018963970 << 8, 0, true), "maxint_plus");
+    test_int(maxint_plus, Dec64(dec64_raw, 36028797018963970 << 8), "maxint_plus");
     test_int(maxnum, dec64nan, "maxnum");
-    test_int(Dec64(7205759403792793, 1), Dec64(72057594037927930 << 8, 0, true), "7205759403792793e1");
+    test_int(Dec64(7205759403792793, 1), Dec64(dec64_raw, 72057594037927930 << 8), "7205759403792793e1");
     test_int(Dec64(7205759403792794, 1), dec64nan, "7205759403792794e1");
 }
 
+static void test_all_fma() {
+    test_fma(dec64nan, one, one, dec64nan, "nan * 1 + 1");
+    test_fma(zero, maxnum, pi, pi, "0 * maxnum + pi");
+    test_fma(Dec64(1999, -2), three, Dec64(250, -2), Dec64(6247, -2), "19.99 * 3 + 2.50");
+    test_fma(Dec64(1999, -2), three, Dec64(-5997, -2), zero, "19.99 * 3 - 59.97");
+    test_fma(
+        Dec64(10000000000000001, -16),
+        Dec64(10000000000000001, -16),
+        negative_one,
+        Dec64(20000000000000001, -32),
+        "(1 + 1e-16)^2 - 1"
+    );
+    test_fma(maxnum, ten, one, dec64nan, "maxnum * 10 + 1");
+}
+
 static void test_all_integer_divide() {
     test_integer_divide(dec64nan, three, dec64nan, "nan / 3");
     test_integer_divide(six, dec64nan, dec64nan, "6 / nan");
@@ -1047,7 +1067,7 @@ static void test_all_multiply() {
 static void test_all_neg() {
     test_neg(dec64nan, dec64nan, "nan");
     test_neg(nannan, dec64nan, "nannan");
-    test_neg(Dec64(100, 0, true), zero, "zero alias");
+    test_neg(Dec64(dec64_raw, 100), zero, "zero alias");
     test_neg(zero, zero, "zero");
     test_neg(zip, zero, "zip");
     test_neg(one, negative_one, "one");
@@ -1062,94 +1082,94 @@ static void test_all_new() {
     test_new(                   0,     0,                                                    zero,                    "zero");
     test_new(                   0,  1000,                                                    zero,                  "0e1000");
     test_new(                   0, -1000,                                                    zero,                 "0e-1000");
-    test_new(                   1,     0,                                Dec64((1 << 8), 0, true),                     "one");
+    test_new(                   1,     0,                                Dec64(dec64_raw, (1 << 8)),                     "one");
     test_new(                   1,  1000,                                                dec64nan,                  "0e1000");
     test_new(                   1, -1000,                                                    zero,                 "1e-1000");
-    test_new(                  -1,   127,                        Dec64( (-1 << 8) + 127, 0, true),                  "-1e127");
-    test_new(                  -1,   128,                        Dec64((-10 << 8) + 127, 0, true),                  "-1e128");
+    test_new(                  -1,   127,                        Dec64(dec64_raw,  (-1 << 8) + 127),                  "-1e127");
+    test_new(                  -1,   128,                        Dec64(dec64_raw, (-10 << 8) + 127),                  "-1e128");
     test_new(                   1,  -128,                                                    zero,                  "1e-128");
-    test_new(                  -1,   143,       Dec64((-10000000000000000LL << 8) + 127, 0, true),                  "-1e143");
+    test_new(                  -1,   143,       Dec64(dec64_raw, (-10000000000000000LL << 8) + 127),                  "-1e143");
     test_new(                  -1,   144,                                                dec64nan,                  "-1e144");
     test_new(                  10,  -128,                                                  minnum,                 "10e-128");
     test_new(                 100,  -129,                                                  minnum,                "100e-129");
-    test_new(   10000000000000001,   -16, Dec64((10000000000000001 << 8) + (0xff & -16), 0, true),  "10000000000000001, -16");
-    test_new(   36028797018963967,     0, Dec64((36028797018963967 << 8),                0, true),      "3602879701896397e0");
-    test_new(  -36028797018963967,     0, Dec64(-36028797018963967 << 8,                 0, true),     "-3602879701896397e0");
-    test_new(   36028797018963967,  -128, Dec64((3602879701896397 << 8) + (0xff & -127), 0, true),  "36028797018963967e-128");
-    test_new(   36028797018963967,  -129, Dec64((360287970189640 << 8) + (0xff & -127),  0, true),  "36028797018963967e-129");
-    test_new(   36028797018963967,  -130, Dec64((36028797018964 << 8) + (0xff & -127),   0, true),  "36028797018963967e-130");
-    test_new(   36028797018963967,  -131, Dec64((3602879701896 << 8) + (0xff & -127),    0, true),  "36028797018963967e-131");
-    test_new(   36028797018963967,  -132, Dec64((360287970190 << 8) + (0xff & -127),     0, true),  "36028797018963967e-132");
-    test_new(   36028797018963967,  -133, Dec64((36028797019 << 8) + (0xff & -127),      0, true),  "36028797018963967e-133");
-    test_new(   36028797018963967,  -134, Dec64((3602879702LL << 8) + (0xff & -127),     0, true),  "36028797018963967e-134");
-    test_new(   36028797018963967,  -135, Dec64((360287970LL << 8) + (0xff & -127),      0, true),  "36028797018963967e-135");
-    test_new(   36028797018963967,  -136, Dec64((36028797LL << 8) + (0xff & -127),       0, true),  "36028797018963967e-136");
-    test_new(   36028797018963967,  -137, Dec64((3602880LL << 8) + (0xff & -127),        0, true),  "36028797018963967e-137");
-    test_new(   36028797018963967,  -138, Dec64((360288LL << 8) + (0xff & -127),         0, true),  "36028797018963967e-138");
-    test_new(   36028797018963967,  -139, Dec64((36029LL << 8) + (0xff & -127),          0, true),  "36028797018963967e-139");
-    test_new(   36028797018963967,  -140, Dec64((3603LL << 8) + (0xff & -127),           0, true),  "36028797018963967e-140");
-    test_new(   36028797018963967,  -141, Dec64((360LL << 8) + (0xff & -127),            0, true),  "36028797018963967e-141");
-    test_new(   36028797018963967,  -142, Dec64((36LL << 8) + (0xff & -127),             0, true),  "36028797018963967e-142");
-    test_new(   36028797018963967,  -143, Dec64((4LL << 8) + (0xff & -127),              0, true),  "36028797018963967e-143");
+    test_new(   10000000000000001,   -16, Dec64(dec64_raw, (10000000000000001 << 8) + (0xff & -16)),  "10000000000000001, -16");
+    test_new(   36028797018963967,     0, Dec64(dec64_raw, (36028797018963967 << 8)),      "3602879701896397e0");
+    test_new(  -36028797018963967,     0, Dec64(dec64_raw, -36028797018963967 << 8),     "-3602879701896397e0");
+    test_new(   36028797018963967,  -128, Dec64(dec64_raw, (3602879701896397 << 8) + (0xff & -127)),  "36028797018963967e-128");
+    test_new(   36028797018963967,  -129, Dec64(dec64_raw, (360287970189640 << 8) + (0xff & -127)),  "36028797018963967e-129");
+    test_new(   36028797018963967,  -130, Dec64(dec64_raw, (36028797018964 << 8) + (0xff & -127)),  "36028797018963967e-130");
+    test_new(   36028797018963967,  -131, Dec64(dec64_raw, (3602879701896 << 8) + (0xff & -127)),  "36028797018963967e-131");
+    test_new(   36028797018963967,  -132, Dec64(dec64_raw, (360287970190 << 8) + (0xff & -127)),  "36028797018963967e-132");
+    test_new(   36028797018963967,  -133, Dec64(dec64_raw, (36028797019 << 8) + (0xff & -127)),  "36028797018963967e-133");
+    test_new(   36028797018963967,  -134, Dec64(dec64_raw, (3602879702LL << 8) + (0xff & -127)),  "36028797018963967e-134");
+    test_new(   36028797018963967,  -135, Dec64(dec64_raw, (360287970LL << 8) + (0xff & -127)),  "36028797018963967e-135");
+    test_new(   36028797018963967,  -136, Dec64(dec64_raw, (36028797LL << 8) + (0xff & -127)),  "36028797018963967e-136");
+    test_new(   36028797018963967,  -137, Dec64(dec64_raw, (3602880LL << 8) + (0xff & -127)),  "36028797018963967e-137");
+    test_new(   36028797018963967,  -138, Dec64(dec64_raw, (360288LL << 8) + (0xff & -127)),  "36028797018963967e-138");
+    test_new(   36028797018963967,  -139, Dec64(dec64_raw, (36029LL << 8) + (0xff & -127)),  "36028797018963967e-139");
+    test_new(   36028797018963967,  -140, Dec64(dec64_raw, (3603LL << 8) + (0xff & -127)),  "36028797018963967e-140");
+    test_new(   36028797018963967,  -141, Dec64(dec64_raw, (360LL << 8) + (0xff & -127)),  "36028797018963967e-141");
+    test_new(   36028797018963967,  -142, Dec64(dec64_raw, (36LL << 8) + (0xff & -127)),  "36028797018963967e-142");
+    test_new(   36028797018963967,  -143, Dec64(dec64_raw, (4LL << 8) + (0xff & -127)),  "36028797018963967e-143");
     test_new(   36028797018963967,  -144,                                                    zero,  "36028797018963967e-144");
-    test_new(  360287970189639670,     0,          Dec64((36028797018963967 << 8) + 1,   0, true),     "36028797018963970e0");
-    test_new( -360287970189639670,     0,          Dec64((-36028797018963967 << 8) + 1,  0, true),    "-36028797018963970e0");
-    test_new( 3602879701896396700,     0,          Dec64((36028797018963967 << 8) + 2,   0, true),   "3602879701896396700e0");
-    test_new(-3602879701896396700,     0,          Dec64((-36028797018963967 << 8) + 2,  0, true),  "-3602879701896396700e0");
-    test_new( 3602879701896396701,     0,          Dec64((36028797018963967 << 8) + 2,   0, true),   "3602879701896396701e0");
-    test_new(-3602879701896396701,     0,          Dec64((-36028797018963967 << 8) + 2,  0, true),  "-3602879701896396701e0");
-    test_new(  360287970189639674,     0,          Dec64((36028797018963967 << 8) + 1,   0, true),     "36028797018963974e0");
-    test_new( -360287970189639674,     0,          Dec64((-36028797018963967 << 8) + 1,  0, true),    "-36028797018963974e0");
-    test_new( 3602879701896396740,     0,          Dec64((36028797018963967 << 8) + 2,   0, true),   "3602879701896396740e0");
-    test_new(-3602879701896396740,     0,          Dec64((-36028797018963967 << 8) + 2,  0, true),  "-3602879701896396740e0");
-    test_new( 3602879701896396749,     0,          Dec64((36028797018963967 << 8) + 2,   0, true),   "3602879701896396749e0");
-    test_new(-3602879701896396749,     0,          Dec64((-36028797018963967 << 8) + 2,  0, true),  "-3602879701896396749e0");
-    test_new( -360287970189639675,     0,          Dec64((-36028797018963968 << 8) + 1,  0, true),    "-36028797018963975e0");
-    test_new(  360287970189639675,     0,          Dec64((3602879701896397 << 8) + 2,    0, true),     "36028797018963975e0");
-    test_new(-3602879701896396750,     0,          Dec64((-36028797018963968 << 8) + 2,  0, true),  "-3602879701896396750e0");
-    test_new( 3602879701896396750,     0,          Dec64((3602879701896397 << 8) + 3,    0, true),   "3602879701896396750e0");
-    test_new(  -36028797018963968,     0,          Dec64((-36028797018963968 << 8),      0, true),     "-3602879701896398e0");
+    test_new(  360287970189639670,     0,          Dec64(dec64_raw, (36028797018963967 << 8) + 1),     "36028797018963970e0");
+    test_new( -360287970189639670,     0,          Dec64(dec64_raw, (-36028797018963967 << 8) + 1),    "-36028797018963970e0");
+    test_new( 3602879701896396700,     0,          Dec64(dec64_raw, (36028797018963967 << 8) + 2),   "3602879701896396700e0");
+    test_new(-3602879701896396700,     0,          Dec64(dec64_raw, (-36028797018963967 << 8) + 2),  "-3602879701896396700e0");
+    test_new( 3602879701896396701,     0,          Dec64(dec64_raw, (36028797018963967 << 8) + 2),   "3602879701896396701e0");
+    test_new(-3602879701896396701,     0,          Dec64(dec64_raw, (-36028797018963967 << 8) + 2),  "-3602879701896396701e0");
+    test_new(  360287970189639674,     0,          Dec64(dec64_raw, (36028797018963967 << 8) + 1),     "36028797018963974e0");
+    test_new( -360287970189639674,     0,          Dec64(dec64_raw, (-36028797018963967 << 8) + 1),    "-36028797018963974e0");
+    test_new( 3602879701896396740,     0,          Dec64(dec64_raw, (36028797018963967 << 8) + 2),   "3602879701896396740e0");
+    test_new(-3602879701896396740,     0,          Dec64(dec64_raw, (-36028797018963967 << 8) + 2),  "-3602879701896396740e0");
+    test_new( 3602879701896396749,     0,          Dec64(dec64_raw, (36028797018963967 << 8) + 2),   "3602879701896396749e0");
+    test_new(-3602879701896396749,     0,          Dec64(dec64_raw, (-36028797018963967 << 8) + 2),  "-3602879701896396749e0");
+    test_new( -360287970189639675,     0,          Dec64(dec64_raw, (-36028797018963968 << 8) + 1),    "-36028797018963975e0");
+    test_new(  360287970189639675,     0,          Dec64(dec64_raw, (3602879701896397 << 8) + 2),     "36028797018963975e0");
+    test_new(-3602879701896396750,     0,          Dec64(dec64_raw, (-36028797018963968 << 8) + 2),  "-3602879701896396750e0");
+    test_new( 3602879701896396750,     0,          Dec64(dec64_raw, (3602879701896397 << 8) + 3),   "3602879701896396750e0");
+    test_new(  -36028797018963968,     0,          Dec64(dec64_raw, (-36028797018963968 << 8)),     "-3602879701896398e0");
     test_new(  -36028797018963968,  -147,                                                    zero, "-36028797018963968e-147");
-    test_new(-3602879701896396800,     0,          Dec64((-36028797018963968 << 8) + 2,  0, true),     "-3602879701896396800e0");
-    test_new( 3602879701896396800,     0,          Dec64((3602879701896397 << 8) + 3,    0, true),      "3602879701896396800e0");
-    test_new( 4611686018427387903,     0,          Dec64((4611686018427388 << 8) + 3,    0, true),        "4611686018427387903");
-    test_new(-4611686018427387903,     0,          Dec64((-4611686018427388 << 8) + 3,   0, true),       "-4611686018427387903");
-    test_new( 9223372036854775499,     0,          Dec64((9223372036854775 << 8) + 3,    0, true),        "9223372036854775499");
-    test_new(-9223372036854775499,     0,          Dec64((-9223372036854775 << 8) + 3,   0, true),       "-9223372036854775499");
-    test_new( 3689348814741910499,     0,          Dec64((3689348814741910 << 8) + 3,    0, true),        "3689348814741910499");
-    test_new(-3689348814741910499,     0,          Dec64((-3689348814741910 << 8) + 3,   0, true),       "-3689348814741910499");
-    test_new( -368934881474191049,     0,          Dec64((-368934881474191 << 8) + 3,    0, true),        "-368934881474191049");
-    test_new(  -36893488147419104,     0,          Dec64((-3689348814741910 << 8) + 1,   0, true),         "-36893488147419104");
+    test_new(-3602879701896396800,     0,          Dec64(dec64_raw, (-36028797018963968 << 8) + 2),     "-3602879701896396800e0");
+    test_new( 3602879701896396800,     0,          Dec64(dec64_raw, (3602879701896397 << 8) + 3),      "3602879701896396800e0");
+    test_new( 4611686018427387903,     0,          Dec64(dec64_raw, (4611686018427388 << 8) + 3),        "4611686018427387903");
+    test_new(-4611686018427387903,     0,          Dec64(dec64_raw, (-4611686018427388 << 8) + 3),       "-4611686018427387903");
+    test_new( 9223372036854775499,     0,          Dec64(dec64_raw, (9223372036854775 << 8) + 3),        "9223372036854775499");
+    test_new(-9223372036854775499,     0,          Dec64(dec64_raw, (-9223372036854775 << 8) + 3),       "-9223372036854775499");
+    test_new( 3689348814741910499,     0,          Dec64(dec64_raw, (3689348814741910 << 8) + 3),        "3689348814741910499");
+    test_new(-3689348814741910499,     0,          Dec64(dec64_raw, (-3689348814741910 << 8) + 3),       "-3689348814741910499");
+    test_new( -368934881474191049,     0,          Dec64(dec64_raw, (-368934881474191 << 8) + 3),        "-368934881474191049");
+    test_new(  -36893488147419104,     0,          Dec64(dec64_raw, (-3689348814741910 << 8) + 1),         "-36893488147419104");
     test_new(                  49,  -129,                                                    zero,                    "49e-129");
     test_new(                  50,  -129,                                                  minnum,                    "50e-129");
-    test_new( -444444444444444444,     0,           Dec64((-4444444444444444 << 8) + 2,  0, true),        "-444444444444444444");
-    test_new(-4444444444444444444,     0,           Dec64((-4444444444444444 << 8) + 3,  0, true),       "-4444444444444444444");
+    test_new( -444444444444444444,     0,           Dec64(dec64_raw, (-4444444444444444 << 8) + 2),        "-444444444444444444");
+    test_new(-4444444444444444444,     0,           Dec64(dec64_raw, (-4444444444444444 << 8) + 3),       "-4444444444444444444");
     test_new(        500000000000,  -139,                                                  minnum,          "500000000000e-139");
     test_new(       -500000000000,  -139,                                         negative_minnum,         "-500000000000e-139");
-    test_new( 5000000000000000000,  -145,                      Dec64((5 << 8) + (0x81),  0, true),   "5000000000000000000e-145");
+    test_new( 5000000000000000000,  -145,                      Dec64(dec64_raw, (5 << 8) + (0x81)),   "5000000000000000000e-145");
     test_new(-5000000000000000000,  -146,                                         negative_minnum,  "-5000000000000000000e-146");
-    test_new(   -5555555555555555,     0,        Dec64((-5555555555555555 << 8) + 0,     0, true),         "-55555555555555555");
-    test_new(  -55555555555555555,     0,        Dec64((-5555555555555556 << 8) + 1,     0, true),         "-55555555555555555");
-    test_new( -555555555555555555,     0,        Dec64((-5555555555555556 << 8) + 2,     0, true),        "-555555555555555555");
-    test_new(-5555555555555555555,     0,        Dec64((-5555555555555556 << 8) + 3,     0, true),       "-5555555555555555555");
-    test_new(   -5555555555555554,     0,        Dec64((-5555555555555554 << 8) + 0,     0, true),         "-55555555555555555");
-    test_new(  -55555555555555554,     0,        Dec64((-5555555555555555 << 8) + 1,     0, true),         "-55555555555555555");
-    test_new(  576460752303423487,     0,        Dec64((5764607523034235 << 8) + 2,      0, true),        "1152921504606846975");
-    test_new( -576460752303423487,     0,        Dec64((-5764607523034235 << 8) + 2,     0, true),       "-1152921504606846975");
-    test_new(   72057594037927935,     0,        Dec64((7205759403792794 << 8) + 1,      0, true),          "72057594037927935");
-    test_new(  -72057594037927935,     0,        Dec64((-7205759403792794 << 8) + 1,     0, true),         "-72057594037927935");
-    test_new( 9223372036854775807,     0,        Dec64((9223372036854776 << 8) + 3,      0, true),        "9223372036854775807");
-    test_new(-9223372036854775807,     0,        Dec64((-9223372036854776 << 8) + 3,     0, true),       "-9223372036854775807");
-    test_new(-9223372036854775807,   124,        Dec64((-9223372036854776 << 8) + 127,   0, true),   "-9223372036854775807e124");
+    test_new(   -5555555555555555,     0,        Dec64(dec64_raw, (-5555555555555555 << 8) + 0),         "-55555555555555555");
+    test_new(  -55555555555555555,     0,        Dec64(dec64_raw, (-5555555555555556 << 8) + 1),         "-55555555555555555");
+    test_new( -555555555555555555,     0,        Dec64(dec64_raw, (-5555555555555556 << 8) + 2),        "-555555555555555555");
+    test_new(-5555555555555555555,     0,        Dec64(dec64_raw, (-5555555555555556 << 8) + 3),       "-5555555555555555555");
+    test_new(   -5555555555555554,     0,        Dec64(dec64_raw, (-5555555555555554 << 8) + 0),         "-55555555555555555");
+    test_new(  -55555555555555554,     0,        Dec64(dec64_raw, (-5555555555555555 << 8) + 1),         "-55555555555555555");
+    test_new(  576460752303423487,     0,        Dec64(dec64_raw, (5764607523034235 << 8) + 2),        "1152921504606846975");
+    test_new( -576460752303423487,     0,        Dec64(dec64_raw, (-5764607523034235 << 8) + 2),       "-1152921504606846975");
+    test_new(   72057594037927935,     0,        Dec64(dec64_raw, (7205759403792794 << 8) + 1),          "72057594037927935");
+    test_new(  -72057594037927935,     0,        Dec64(dec64_raw, (-7205759403792794 << 8) + 1),         "-72057594037927935");
+    test_new( 9223372036854775807,     0,        Dec64(dec64_raw, (9223372036854776 << 8) + 3),        "9223372036854775807");
+    test_new(-9223372036854775807,     0,        Dec64(dec64_raw, (-9223372036854776 << 8) + 3),       "-9223372036854775807");
+    test_new(-9223372036854775807,   124,        Dec64(dec64_raw, (-9223372036854776 << 8) + 127),   "-9223372036854775807e124");
     test_new(-9223372036854775807,   125,                                                dec64nan,   "-9223372036854775807e125");
-    test_new(-9223372036854775807,  -132,        Dec64((-92233720368548 << 8) + (0x81),  0, true),  "-9223372036854775807e-132");
-    test_new(-9223372036854775807,  -133,        Dec64((-9223372036855 << 8) + (0x81),   0, true),  "-9223372036854775807e-133");
-    test_new( 9223372036854775807,  -143,        Dec64((922LL << 8) + (0xff & -127),     0, true),   "9223372036854775807e-143");
-    test_new( 9223372036854775807,  -144,        Dec64((92LL << 8) + (0xff & -127),      0, true),   "9223372036854775807e-144");
-    test_new(-9223372036854775807,  -145,        Dec64((-9 << 8) + (0x81),               0, true),  "-9223372036854775807e-145");
-    test_new( 9223372036854775807,  -145,        Dec64((9LL << 8) + (0xff & -127),       0, true),   "9223372036854775807e-145");
-    test_new(-9223372036854775807,  -146,        Dec64((-1 << 8) + (0x81),               0, true),  "-9223372036854775807e-146");
-    test_new( 9223372036854775807,  -146,        Dec64((1LL << 8) + (0xff & -127),       0, true),   "9223372036854775807e-146");
+    test_new(-9223372036854775807,  -132,        Dec64(dec64_raw, (-92233720368548 << 8) + (0x81)),  "-9223372036854775807e-132");
+    test_new(-9223372036854775807,  -133,        Dec64(dec64_raw, (-9223372036855 << 8) + (0x81)),  "-9223372036854775807e-133");
+    test_new( 9223372036854775807,  -143,        Dec64(dec64_raw, (922LL << 8) + (0xff & -127)),   "9223372036854775807e-143");
+    test_new( 9223372036854775807,  -144,        Dec64(dec64_raw, (92LL << 8) + (0xff & -127)),   "9223372036854775807e-144");
+    test_new(-9223372036854775807,  -145,        Dec64(dec64_raw, (-9 << 8) + (0x81)),  "-9223372036854775807e-145");
+    test_new( 9223372036854775807,  -145,        Dec64(dec64_raw, (9LL << 8) + (0xff & -127)),   "9223372036854775807e-145");
+    test_new(-9223372036854775807,  -146,        Dec64(dec64_raw, (-1 << 8) + (0x81)),  "-9223372036854775807e-146");
+    test_new( 9223372036854775807,  -146,        Dec64(dec64_raw, (1LL << 8) + (0xff & -127)),   "9223372036854775807e-146");
 }
 
 void test_all_normal() {
@@ -1414,6 +1434,23 @@ static void test_new_from_string(std::string first, Dec64 expected, std::string
     judge_unary(first, expected, actual, "new from string", "!", comment);
 }
 
+static void test_parse(std::string first, Dec64 expected, std::size_t position, std::string comment)
+{
+    std::size_t error = 0;
+    Dec64 actual = Dec64::parse(first, &error);
+    judge_not(expected, actual, "parse", comment);
+    if (error == position)
+    {
+        nr_pass += 1;
+    }
+    else
+    {
+        nr_fail += 1;
+        if (level >= 1)
+            printf("\n\nFAIL parse error position: %s\n?   %lli\n=   %lli", comment.c_str(), (long long) error, (long long) position);
+    }
+}
+
 static void test_all_print()
 {
     test_print(Dec64(100,    0),    "100");
@@ -1439,6 +1476,141 @@ static void test_all_new_from_string()
     test_new_from_string(     "nan",               dec64nan,     "nan");
 }
 
+static void test_all_parse()
+{
+    const std::size_t ok = std::string_view::npos;
+
+    test_parse(                    "0",                      zero,  ok, "0");
+    test_parse(                 "-0.0",                      zero,  ok, "-0.0");
+    test_parse(                "+12.5",          Dec64(125,  -1),  ok, "+12.5");
+    test_parse(                 "-.25",          Dec64(-25,  -2),  ok, "-.25");
+    test_parse(                   "7.",             Dec64(7,  0),  ok, "7.");
+    test_parse(             "0.000123",          Dec64(123,  -6),  ok, "0.000123");
+    test_parse(               "1E+3",              Dec64(1, 3),  ok, "1E+3");
+    test_parse(             "12345e-2",        Dec64(12345, -2),  ok, "12345e-2");
+    test_parse(  "36028797018963967",  Dec64(36028797018963967, 0), ok, "maxint");
+    test_parse(  "36028797018963968",  Dec64(3602879701896397, 1), ok, "maxint + 1 rounds");
+    test_parse("123456789012345678901234567890", Dec64(12345678901234568, 13), ok, "30 digits");
+    test_parse("0.1234567890123456789", Dec64(12345678901234568, -17), ok, "19 places");
+    test_parse(                "1e999",                  dec64nan,  ok, "1e999");
+    test_parse(               "1e-999",                      zero,  ok, "1e-999");
+    test_parse(                     "",                  dec64nan,   0, "empty");
+    test_parse(                    "-",                  dec64nan,   1, "-");
+    test_parse(                    ".",                  dec64nan,   1, ".");
+    test_parse(                  "1.2.3",                dec64nan,   3, "1.2.3");
+    test_parse(                   "12x",                 dec64nan,   2, "12x");
+    test_parse(                    "1e",                 dec64nan,   2, "1e");
+    test_parse(                   "1e-",                 dec64nan,   3, "1e-");
+    test_parse(                  "1e5z",                 dec64nan,   3, "1e5z");
+    test_parse(                  " 100",                 dec64nan,   0, "leading space");
+    test_parse(                 "nanny",                 dec64nan,   0, "nanny");
+}
+
+/* constexpr */
+
+//Dec64 arithmetic is folded at compile time, or this doesn't build
+constexpr Dec64 tick_sizes[] = {Dec64(1, -2), Dec64(5, -2), Dec64(25, -2)};
+constexpr Dec64 third = Dec64(1) / Dec64(3);
+
+static_assert(Dec64(1, -2) * Dec64(100) == Dec64(1), "0.01 * 100");
+static_assert(tick_sizes[0] + tick_sizes[1] + tick_sizes[2] == Dec64(31, -2), "tick sizes");
+static_assert(third.coefficient_to_int() == 33333333333333333 && third.exponent_to_int() == -17, "1 / 3");
+static_assert(Dec64(2, -1) - Dec64(1, 1) < Dec64(0) == Dec64(1), "0.2 - 10 < 0");
+static_assert(Dec64(1200, -2).normal().value == Dec64(12).value, "normal 12.00");
+static_assert(Dec64(0, -128).value == DEC64_NAN, "nan");
+
+static void judge_constexpr(const char* name, dec64 first, dec64 second, dec64 expected, dec64 actual) {
+    if (expected == actual) {
+        nr_pass += 1;
+    } else {
+        nr_fail += 1;
+        if (level >= 1) {
+            printf("\n\nFAIL constexpr %s: %016llx %016llx", name, first, second);
+            if (level >= 2) {
+                printf("\n    ? %016llx\n    = %016llx", actual, expected);
+            }
+        }
+    }
+}
+
+static void test_all_constexpr() {
+/*
+    The constexpr port must give the very same words as the backend the
+    library was built with, for special numbers and for random ones, and so
+    must the Dec64 operators at run time.
+*/
+    static const dec64 specials[] = {
+        DEC64_NAN, 32896, DEC64_ZERO, 250, DEC64_ONE, (dec64)DEC64_NEGATIVE_ONE,
+        dec64_new(1, -127), dec64_new(36028797018963967, 127),
+        dec64_new(-36028797018963968, 127), dec64_new(-36028797018963968, 0),
+        dec64_new(31415926535897932, -16), dec64_new(9999999999999999, -16)
+    };
+    const int nr_specials = sizeof specials / sizeof specials[0];
+    uint64 seed = 0x2545F4914F6CDD1DULL;
+    dec64 operands[200];
+    int at;
+    int left;
+    int right;
+
+    for (at = 0; at < 200; at += 1) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        operands[at] = at < nr_specials
+            ? specials[at]
+            : at % 3 == 0
+            ? (dec64)seed
+            : dec64_new((int64)seed >> (8 + seed % 48), (int64)(seed % 41) - 20);
+    }
+    for (left = 0; left < 200; left += 1) {
+        dec64 first = operands[left];
+        judge_constexpr("normal", first, 0, dec64_normal(first), dec64_constexpr::dec64_normal(first));
+        judge_constexpr(
+            "new",
+            first,
+            0,
+            dec64_new(first >> 8, (int8_t)first),
+            dec64_constexpr::dec64_new(first >> 8, (int8_t)first)
+        );
+        judge_constexpr("Dec64", first, 0, dec64_new(first >> 8, (int8_t)first), Dec64(first >> 8, (int8_t)first).value);
+        judge_constexpr("Dec64 normal", first, 0, dec64_normal(first), Dec64(dec64_raw, first).normal().value);
+        for (right = 0; right < 200; right += 1) {
+            dec64 second = operands[right];
+            Dec64 a(dec64_raw, first);
+            Dec64 b(dec64_raw, second);
+            Dec64 c = a;
+            dec64 equal = dec64_is_equal(first, second);
+            dec64 less = dec64_is_less(first, second);
+            dec64 greater = dec64_is_less(second, first);
+            judge_constexpr("Dec64 +", first, second, dec64_add(first, second), (a + b).value);
+            judge_constexpr("Dec64 -", first, second, dec64_subtract(first, second), (a - b).value);
+            judge_constexpr("Dec64 *", first, second, dec64_multiply(first, second), (a * b).value);
+            judge_constexpr("Dec64 /", first, second, dec64_divide(first, second), (a / b).value);
+            judge_constexpr("Dec64 <", first, second, less, (a < b).value);
+            judge_constexpr("Dec64 >", first, second, greater == DEC64_ONE, a > b);
+            judge_constexpr("Dec64 ==", first, second, equal == DEC64_ONE, a == b);
+            judge_constexpr("Dec64 !=", first, second, equal == DEC64_ZERO, a != b);
+            c += b;
+            judge_constexpr("Dec64 +=", first, second, dec64_add(first, second), c.value);
+            c = a;
+            c -= b;
+            judge_constexpr("Dec64 -=", first, second, dec64_subtract(first, second), c.value);
+            c = a;
+            c *= b;
+            judge_constexpr("Dec64 *=", first, second, dec64_multiply(first, second), c.value);
+            c = a;
+            c /= b;
+            judge_constexpr("Dec64 /=", first, second, dec64_divide(first, second), c.value);
+            judge_constexpr("add", first, second, dec64_add(first, second), dec64_constexpr::dec64_add(first, second));
+            judge_constexpr("subtract", first, second, dec64_subtract(first, second), dec64_constexpr::dec64_subtract(first, second));
+            judge_constexpr("multiply", first, second, dec64_multiply(first, second), dec64_constexpr::dec64_multiply(first, second));
+            judge_constexpr("divide", first, second, dec64_divide(first, second), dec64_constexpr::dec64_divide(first, second));
+            judge_constexpr("is_equal", first, second, dec64_is_equal(first, second), dec64_constexpr::dec64_is_equal(first, second));
+            judge_constexpr("is_less", first, second, dec64_is_less(first, second), dec64_constexpr::dec64_is_less(first, second));
+        }
+    }
+}
+
 
 static int do_tests(int level_of_detail) {
 /*
@@ -1459,6 +1631,7 @@ static int do_tests(int level_of_detail) {
     test_all_divide();
     test_all_equal();
     test_all_floor();
+    test_all_fma();
     test_all_half();
     test_all_inc();
     test_all_int();
@@ -1478,6 +1651,8 @@ static int do_tests(int level_of_detail) {
     test_all_subtract();
     test_all_print();
     test_all_new_from_string();
+    test_all_parse();
+    test_all_constexpr();
 
     printf("\n\n%i pass, %i fail.\n", nr_pass, nr_fail);
     return nr_fail;